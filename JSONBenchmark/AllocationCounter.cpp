@@ -0,0 +1,68 @@
+#include "stdafx.h"
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> s_AllocationCount;
+static std::atomic<uint64_t> s_AllocationBytes;
+
+AllocationCounter::Totals AllocationCounter::GetTotals()
+{
+	return Totals{ s_AllocationCount.load(std::memory_order_relaxed), s_AllocationBytes.load(std::memory_order_relaxed) };
+}
+
+static void* CountedAlloc(size_t size)
+{
+	s_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+	s_AllocationBytes.fetch_add(size, std::memory_order_relaxed);
+
+	// malloc(0) is allowed to return nullptr, operator new isn't
+	return std::malloc(size ? size : 1);
+}
+
+void* operator new(size_t size)
+{
+	if (void* retVal = CountedAlloc(size))
+		return retVal;
+
+	throw std::bad_alloc();
+}
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAlloc(size);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAlloc(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+void operator delete[](void* ptr) noexcept
+{
+	std::free(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+void operator delete[](void* ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+	std::free(ptr);
+}
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+	std::free(ptr);
+}
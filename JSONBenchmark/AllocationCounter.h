@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+
+// Counts calls to the global operator new, which this project replaces. Every
+// thread's allocations are included, so take deltas around single-threaded work.
+class AllocationCounter
+{
+public:
+	AllocationCounter() = delete;
+
+	struct Totals
+	{
+		uint64_t m_Count;
+		uint64_t m_Bytes;
+	};
+
+	static Totals GetTotals();
+};
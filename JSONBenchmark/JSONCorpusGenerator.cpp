@@ -0,0 +1,121 @@
+#include "stdafx.h"
+#include "JSONCorpusGenerator.h"
+
+#include <array>
+
+static constexpr std::array<std::string_view, 20> KEYS =
+{
+	"name"sv, "shaderGroup"sv, "inputs"sv, "sourceFiles"sv, "filter"sv,
+	"addressMode"sv, "animated"sv, "color"sv, "position"sv, "rotation"sv,
+	"scale"sv, "stage"sv, "file"sv, "value"sv, "id"sv,
+	"tags"sv, "uv"sv, "mipLevels"sv, "frameTime"sv, "description"sv,
+};
+
+static constexpr std::string_view STRING_CHARS = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-./ "sv;
+static constexpr std::array<std::string_view, 6> ESCAPED_STRINGS = { "\""sv, "\\"sv, "\n"sv, "\t"sv, "\x01"sv, u8"é"sv };
+
+JSONCorpusGenerator::JSONCorpusGenerator(const JSONCorpusSettings& settings) :
+	m_Settings(settings),
+	m_Random(settings.m_Seed),
+	m_Writer(settings.m_Minified)
+{
+}
+
+std::string JSONCorpusGenerator::Generate(const JSONCorpusSettings& settings)
+{
+	JSONCorpusGenerator generator(settings);
+
+	generator.m_Writer.StartArray();
+	while (generator.m_Writer.GetString().size() < settings.m_TargetSize)
+		generator.WriteObject(1);
+
+	generator.m_Writer.EndArray();
+
+	return generator.m_Writer.GetString();
+}
+
+void JSONCorpusGenerator::WriteObject(size_t depth)
+{
+	m_Writer.StartObject();
+
+	// Walk the key list from a random starting point so keys never repeat
+	const uint32_t keyCount = RandomInt(1, 8);
+	const uint32_t firstKey = RandomInt(0, uint32_t(KEYS.size() - 1));
+	for (uint32_t i = 0; i < keyCount; i++)
+	{
+		m_Writer.Key(KEYS[(firstKey + i) % KEYS.size()]);
+		WriteValue(depth);
+	}
+
+	m_Writer.EndObject();
+}
+
+void JSONCorpusGenerator::WriteArray(size_t depth)
+{
+	m_Writer.StartArray();
+
+	const uint32_t count = RandomInt(0, 8);
+	for (uint32_t i = 0; i < count; i++)
+		WriteValue(depth);
+
+	m_Writer.EndArray();
+}
+
+void JSONCorpusGenerator::WriteValue(size_t depth)
+{
+	// Once we've hit the target size, only scalars, so the current element wraps up quickly
+	if (depth < m_Settings.m_MaxDepth && m_Writer.GetString().size() < m_Settings.m_TargetSize && Chance(m_Settings.m_ContainerChance))
+	{
+		if (Chance(0.5f))
+			WriteObject(depth + 1);
+		else
+			WriteArray(depth + 1);
+	}
+	else
+		WriteScalar();
+}
+
+void JSONCorpusGenerator::WriteScalar()
+{
+	if (Chance(m_Settings.m_StringRatio))
+		return WriteString();
+
+	const uint32_t kind = RandomInt(0, 19);
+	if (kind == 0)
+		m_Writer.Null();
+	else if (kind == 1)
+		m_Writer.Bool(Chance(0.5f));
+	else if (kind < 8)
+		m_Writer.Number(double(RandomInt(0, 4096)));
+	else if (kind < 19)
+		m_Writer.Number((double(RandomInt(0, 2000000)) - 1000000) / 1000);
+	else
+		m_Writer.Number(double(RandomInt(1, 999)) * 1e20);
+}
+
+void JSONCorpusGenerator::WriteString()
+{
+	const uint32_t length = RandomInt(0, uint32_t(m_Settings.m_MaxStringLength));
+
+	std::string str;
+	str.reserve(length + 2);
+	for (uint32_t i = 0; i < length; i++)
+		str += STRING_CHARS[RandomInt(0, uint32_t(STRING_CHARS.size() - 1))];
+
+	if (Chance(m_Settings.m_EscapeChance))
+		str.insert(RandomInt(0, length), ESCAPED_STRINGS[RandomInt(0, uint32_t(ESCAPED_STRINGS.size() - 1))]);
+
+	m_Writer.String(str);
+}
+
+bool JSONCorpusGenerator::Chance(float probability)
+{
+	// Not std::uniform_real_distribution, its output differs between standard libraries
+	return (m_Random() >> 8) * (1.0f / 16777216.0f) < probability;
+}
+
+uint32_t JSONCorpusGenerator::RandomInt(uint32_t min, uint32_t max)
+{
+	assert(min <= max);
+	return min + uint32_t(m_Random() % (uint64_t(max) - min + 1));
+}
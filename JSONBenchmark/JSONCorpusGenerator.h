@@ -0,0 +1,58 @@
+#pragma once
+#include "JSONWriter.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+struct JSONCorpusSettings
+{
+	// Documents end up slightly larger, since the element that crosses this
+	// size is still finished off
+	size_t m_TargetSize = 1024;
+
+	// Deepest level of nested objects/arrays below the root array
+	size_t m_MaxDepth = 6;
+
+	// Chance (0-1) that a value which could be a container is one
+	float m_ContainerChance = 0.3f;
+
+	// Of the scalar values, the fraction that are strings. The rest are mostly
+	// numbers, with the occasional bool or null.
+	float m_StringRatio = 0.5f;
+
+	size_t m_MaxStringLength = 32;
+
+	// Chance (0-1) that any given string contains an escape sequence
+	float m_EscapeChance = 0.05f;
+
+	bool m_Minified = false;
+
+	uint32_t m_Seed = 1;
+};
+
+// Produces synthetic JSON documents for benchmarking the parsers. The root is
+// an array of objects shaped roughly like our asset definitions, with keys
+// drawn from a small vocabulary. The same settings always produce the same
+// document, on any platform.
+class JSONCorpusGenerator
+{
+public:
+	static std::string Generate(const JSONCorpusSettings& settings);
+
+private:
+	JSONCorpusGenerator(const JSONCorpusSettings& settings);
+
+	void WriteObject(size_t depth);
+	void WriteArray(size_t depth);
+	void WriteValue(size_t depth);
+	void WriteScalar();
+	void WriteString();
+
+	bool Chance(float probability);
+	uint32_t RandomInt(uint32_t min, uint32_t max);
+
+	const JSONCorpusSettings& m_Settings;
+	std::mt19937 m_Random;
+	JSONWriter m_Writer;
+};
@@ -0,0 +1,362 @@
+#include "stdafx.h"
+
+#include "AllocationCounter.h"
+#include "JSON.h"
+#include "JSONCorpusGenerator.h"
+#include "JSONDocument.h"
+#include "JSONReader.h"
+#include "JSONTape.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+// Measures parse throughput and allocations for every JSONSerializer entry
+// point (and JSONReader) over the real asset files and a set of synthetic
+// documents. Run from the VulkanTest1 directory, or pass --content.
+//
+//	JSONBenchmark [--content <dir>] [--csv <file>] [--filter <text>]
+//		[--min-time <seconds>] [--min-iterations <count>] [--max-size <bytes>]
+//		[--depth <levels>] [--string-ratio <0-1>] [--escape-chance <0-1>]
+//		[--minified] [--seed <number>]
+
+struct BenchmarkSettings
+{
+	std::filesystem::path m_ContentDir = std::filesystem::current_path();
+	std::filesystem::path m_CSVPath;
+	std::string m_Filter;
+
+	double m_MinSeconds = 0.5;
+	size_t m_MinIterations = 3;
+
+	// Synthetic documents go from 1KB up to this, growing 4x each step
+	size_t m_MaxSyntheticSize = 256 * 1024 * 1024;
+	JSONCorpusSettings m_Corpus;
+};
+
+struct BenchmarkDocument
+{
+	std::filesystem::path m_Path;
+	std::string m_Text;
+};
+
+struct BenchmarkCorpus
+{
+	std::string m_Name;
+	std::vector<BenchmarkDocument> m_Documents;
+	size_t m_TotalBytes = 0;
+};
+
+struct BenchmarkParser
+{
+	std::string_view m_Name;
+	void(*m_Parse)(const BenchmarkDocument& document);
+};
+
+struct BenchmarkResult
+{
+	std::string m_Corpus;
+	std::string_view m_Parser;
+	size_t m_Documents;
+	size_t m_Bytes;
+	size_t m_Iterations;
+	double m_BestSeconds;
+	double m_MeanSeconds;
+	double m_AllocationsPerDocument;
+	double m_AllocatedBytesPerDocument;
+
+	double GetBestMBPerSecond() const { return m_Bytes / m_BestSeconds / 1e6; }
+	double GetMeanMBPerSecond() const { return m_Bytes / m_MeanSeconds / 1e6; }
+};
+
+static const BenchmarkParser PARSERS[] =
+{
+	{ "FromString"sv, [](const BenchmarkDocument& document) { JSONSerializer::FromString(document.m_Text); } },
+	{ "FromFile"sv, [](const BenchmarkDocument& document) { JSONSerializer::FromFile(document.m_Path); } },
+	{ "FromStringInSitu"sv, [](const BenchmarkDocument& document) { JSONSerializer::FromStringInSitu(document.m_Text); } },
+	{ "FromFileInSitu"sv, [](const BenchmarkDocument& document) { JSONSerializer::FromFileInSitu(document.m_Path); } },
+	{ "FromStringTape"sv, [](const BenchmarkDocument& document) { JSONSerializer::FromStringTape(document.m_Text); } },
+	{ "FromFileTape"sv, [](const BenchmarkDocument& document) { JSONSerializer::FromFileTape(document.m_Path); } },
+	{ "JSONReader"sv, [](const BenchmarkDocument& document)
+		{
+			JSONReader reader{ std::string_view(document.m_Text) };
+			while (reader.Next() != JSONEvent::EndOfDocument)
+				;
+		}
+	},
+};
+
+static std::string ReadFile(const std::filesystem::path& path)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		throw std::runtime_error(StringTools::CSFormat("Failed to open \"{0}\"", path));
+
+	std::string retVal(size_t(file.tellg()), '\0');
+	file.seekg(0);
+	file.read(retVal.data(), retVal.size());
+	return retVal;
+}
+
+static void AddDocument(BenchmarkCorpus& corpus, const std::filesystem::path& path)
+{
+	auto& document = corpus.m_Documents.emplace_back();
+	document.m_Path = path;
+	document.m_Text = ReadFile(path);
+	corpus.m_TotalBytes += document.m_Text.size();
+}
+
+static std::vector<BenchmarkCorpus> LoadFileCorpora(const std::filesystem::path& contentDir)
+{
+	std::vector<BenchmarkCorpus> retVal;
+
+	if (const auto testFile = contentDir / "test.json"; std::filesystem::exists(testFile))
+	{
+		auto& corpus = retVal.emplace_back();
+		corpus.m_Name = "test.json";
+		AddDocument(corpus, testFile);
+	}
+	else
+		std::cerr << "Skipping test.json, " << testFile << " doesn't exist\n";
+
+	for (const auto& folder : { "materials"sv, "textures"sv })
+	{
+		const auto folderPath = contentDir / folder;
+		if (!std::filesystem::is_directory(folderPath))
+		{
+			std::cerr << "Skipping " << folder << ", " << folderPath << " doesn't exist\n";
+			continue;
+		}
+
+		BenchmarkCorpus corpus;
+		corpus.m_Name = folder;
+
+		std::vector<std::filesystem::path> files;
+		for (const auto& item : std::filesystem::recursive_directory_iterator(folderPath))
+		{
+			if (item.status().type() == std::filesystem::file_type::regular && item.path().extension() == ".json")
+				files.push_back(item.path());
+		}
+
+		std::sort(files.begin(), files.end());
+		for (const auto& file : files)
+			AddDocument(corpus, file);
+
+		if (!corpus.m_Documents.empty())
+			retVal.push_back(std::move(corpus));
+	}
+
+	return retVal;
+}
+
+static std::string FormatSize(size_t bytes)
+{
+	if (bytes >= 1024 * 1024 && !(bytes % (1024 * 1024)))
+		return StringTools::CSFormat("{0}MB", bytes / (1024 * 1024));
+	if (bytes >= 1024 && !(bytes % 1024))
+		return StringTools::CSFormat("{0}KB", bytes / 1024);
+
+	return StringTools::CSFormat("{0}B", bytes);
+}
+
+static BenchmarkCorpus GenerateCorpus(const BenchmarkSettings& settings, size_t targetSize)
+{
+	JSONCorpusSettings corpusSettings = settings.m_Corpus;
+	corpusSettings.m_TargetSize = targetSize;
+
+	BenchmarkCorpus retVal;
+	retVal.m_Name = "synthetic/" + FormatSize(targetSize);
+
+	// The FromFile* parsers need the document on disk
+	const auto directory = std::filesystem::temp_directory_path() / "JSONBenchmark";
+	std::filesystem::create_directories(directory);
+
+	auto& document = retVal.m_Documents.emplace_back();
+	document.m_Path = directory / ("synthetic_" + FormatSize(targetSize) + ".json");
+	document.m_Text = JSONCorpusGenerator::Generate(corpusSettings);
+	retVal.m_TotalBytes = document.m_Text.size();
+
+	std::ofstream file(document.m_Path, std::ios::binary | std::ios::trunc);
+	file.write(document.m_Text.data(), document.m_Text.size());
+	if (!file.good())
+		throw std::runtime_error(StringTools::CSFormat("Failed to write \"{0}\"", document.m_Path));
+
+	return retVal;
+}
+
+static BenchmarkResult Run(const BenchmarkSettings& settings, const BenchmarkCorpus& corpus, const BenchmarkParser& parser)
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	BenchmarkResult retVal{};
+	retVal.m_Corpus = corpus.m_Name;
+	retVal.m_Parser = parser.m_Name;
+	retVal.m_Documents = corpus.m_Documents.size();
+	retVal.m_Bytes = corpus.m_TotalBytes;
+
+	// Untimed warmup pass, which also gives us the allocation counts. Those are
+	// the same on every pass, unlike the timings.
+	{
+		const auto before = AllocationCounter::GetTotals();
+		for (const auto& document : corpus.m_Documents)
+			parser.m_Parse(document);
+
+		const auto after = AllocationCounter::GetTotals();
+		retVal.m_AllocationsPerDocument = double(after.m_Count - before.m_Count) / retVal.m_Documents;
+		retVal.m_AllocatedBytesPerDocument = double(after.m_Bytes - before.m_Bytes) / retVal.m_Documents;
+	}
+
+	double totalSeconds = 0;
+	retVal.m_BestSeconds = std::numeric_limits<double>::infinity();
+	while (retVal.m_Iterations < settings.m_MinIterations || totalSeconds < settings.m_MinSeconds)
+	{
+		const auto start = Clock::now();
+		for (const auto& document : corpus.m_Documents)
+			parser.m_Parse(document);
+
+		const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+		retVal.m_BestSeconds = std::min(retVal.m_BestSeconds, seconds);
+		totalSeconds += seconds;
+		retVal.m_Iterations++;
+	}
+
+	retVal.m_MeanSeconds = totalSeconds / retVal.m_Iterations;
+	return retVal;
+}
+
+static void PrintResult(const BenchmarkResult& result)
+{
+	std::cout << std::left << std::setw(20) << result.m_Corpus << std::setw(18) << result.m_Parser << std::right
+		<< std::fixed << std::setprecision(1)
+		<< std::setw(12) << result.GetBestMBPerSecond()
+		<< std::setw(12) << result.GetMeanMBPerSecond()
+		<< std::setw(14) << result.m_AllocationsPerDocument
+		<< std::setw(16) << result.m_AllocatedBytesPerDocument
+		<< std::setw(8) << result.m_Iterations << std::endl;
+}
+
+static void WriteCSV(const std::filesystem::path& path, const std::vector<BenchmarkResult>& results)
+{
+	std::ofstream file(path, std::ios::trunc);
+	if (!file.is_open())
+		throw std::runtime_error(StringTools::CSFormat("Failed to open \"{0}\" for writing", path));
+
+	file << "corpus,parser,documents,bytes,iterations,best_seconds,mean_seconds,best_mb_per_s,mean_mb_per_s,allocations_per_document,allocated_bytes_per_document\n";
+
+	file << std::setprecision(9);
+	for (const auto& result : results)
+	{
+		file << result.m_Corpus << ',' << result.m_Parser << ',' << result.m_Documents << ',' << result.m_Bytes << ','
+			<< result.m_Iterations << ',' << result.m_BestSeconds << ',' << result.m_MeanSeconds << ','
+			<< result.GetBestMBPerSecond() << ',' << result.GetMeanMBPerSecond() << ','
+			<< result.m_AllocationsPerDocument << ',' << result.m_AllocatedBytesPerDocument << '\n';
+	}
+
+	if (!file.good())
+		throw std::runtime_error(StringTools::CSFormat("Failed to write \"{0}\"", path));
+}
+
+template<class T> static T ParseNumberArgument(const std::string_view& arg, const std::string_view& value)
+{
+	T retVal{};
+	const auto result = StringConverter::Parse(value, retVal);
+	if (result.ec != std::errc() || result.ptr != value.data() + value.size())
+		throw std::invalid_argument(StringTools::CSFormat("Invalid value \"{0}\" for argument {1}", value, arg));
+
+	return retVal;
+}
+
+static BenchmarkSettings ParseArguments(int argc, char** argv)
+{
+	BenchmarkSettings retVal;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string_view arg = argv[i];
+		if (arg == "--minified"sv)
+		{
+			retVal.m_Corpus.m_Minified = true;
+			continue;
+		}
+
+		if (i + 1 >= argc)
+			throw std::invalid_argument(StringTools::CSFormat("Missing value for argument {0}", arg));
+
+		const char* value = argv[++i];
+		if (arg == "--content"sv)
+			retVal.m_ContentDir = value;
+		else if (arg == "--csv"sv)
+			retVal.m_CSVPath = value;
+		else if (arg == "--filter"sv)
+			retVal.m_Filter = value;
+		else if (arg == "--min-time"sv)
+			retVal.m_MinSeconds = ParseNumberArgument<double>(arg, value);
+		else if (arg == "--min-iterations"sv)
+			retVal.m_MinIterations = ParseNumberArgument<size_t>(arg, value);
+		else if (arg == "--max-size"sv)
+			retVal.m_MaxSyntheticSize = ParseNumberArgument<size_t>(arg, value);
+		else if (arg == "--depth"sv)
+			retVal.m_Corpus.m_MaxDepth = ParseNumberArgument<size_t>(arg, value);
+		else if (arg == "--string-ratio"sv)
+			retVal.m_Corpus.m_StringRatio = ParseNumberArgument<float>(arg, value);
+		else if (arg == "--escape-chance"sv)
+			retVal.m_Corpus.m_EscapeChance = ParseNumberArgument<float>(arg, value);
+		else if (arg == "--seed"sv)
+			retVal.m_Corpus.m_Seed = ParseNumberArgument<uint32_t>(arg, value);
+		else
+			throw std::invalid_argument(StringTools::CSFormat("Unknown argument {0}", arg));
+	}
+
+	return retVal;
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		const BenchmarkSettings settings = ParseArguments(argc, argv);
+
+		std::vector<BenchmarkCorpus> corpora = LoadFileCorpora(settings.m_ContentDir);
+		for (size_t size = 1024; size <= settings.m_MaxSyntheticSize; size *= 4)
+			corpora.push_back(GenerateCorpus(settings, size));
+
+		std::cout << std::left << std::setw(20) << "corpus" << std::setw(18) << "parser" << std::right
+			<< std::setw(12) << "best MB/s" << std::setw(12) << "mean MB/s"
+			<< std::setw(14) << "allocs/doc" << std::setw(16) << "alloc bytes/doc"
+			<< std::setw(8) << "iters" << '\n';
+
+		std::vector<BenchmarkResult> results;
+		for (const auto& corpus : corpora)
+		{
+			for (const auto& parser : PARSERS)
+			{
+				const std::string fullName = corpus.m_Name + '/' + std::string(parser.m_Name);
+				if (fullName.find(settings.m_Filter) == fullName.npos)
+					continue;
+
+				try
+				{
+					results.push_back(Run(settings, corpus, parser));
+					PrintResult(results.back());
+				}
+				catch (const std::exception& e)
+				{
+					std::cerr << fullName << " failed: " << e.what() << '\n';
+				}
+			}
+		}
+
+		if (!settings.m_CSVPath.empty())
+			WriteCSV(settings.m_CSVPath, results);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << '\n';
+		return 1;
+	}
+
+	return 0;
+}
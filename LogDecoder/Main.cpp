@@ -0,0 +1,113 @@
+#include "stdafx.h"
+
+#include "BinaryLogReader.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+// Turns a BinaryLog file back into text, exactly as Log::Msg would have written it.
+//
+//	LogDecoder <file> [--output <file>] [--timestamps] [--threads]
+
+struct DecoderSettings
+{
+	std::filesystem::path m_InputPath;
+	std::filesystem::path m_OutputPath;
+
+	// Prefix each line with seconds since the log was opened
+	bool m_Timestamps = false;
+	// Prefix each line with the index of the thread that logged it
+	bool m_Threads = false;
+};
+
+static DecoderSettings ParseArguments(int argc, char** argv)
+{
+	DecoderSettings retVal;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string_view arg = argv[i];
+		if (arg == "--timestamps"sv)
+		{
+			retVal.m_Timestamps = true;
+			continue;
+		}
+		if (arg == "--threads"sv)
+		{
+			retVal.m_Threads = true;
+			continue;
+		}
+		if (arg.substr(0, 2) != "--"sv)
+		{
+			if (!retVal.m_InputPath.empty())
+				throw std::invalid_argument(StringTools::CSFormat("Unexpected argument {0}, already decoding {1}", arg, retVal.m_InputPath));
+
+			retVal.m_InputPath = argv[i];
+			continue;
+		}
+
+		if (i + 1 >= argc)
+			throw std::invalid_argument(StringTools::CSFormat("Missing value for argument {0}", arg));
+
+		const char* value = argv[++i];
+		if (arg == "--output"sv)
+			retVal.m_OutputPath = value;
+		else
+			throw std::invalid_argument(StringTools::CSFormat("Unknown argument {0}", arg));
+	}
+
+	if (retVal.m_InputPath.empty())
+		throw std::invalid_argument("Usage: LogDecoder <file> [--output <file>] [--timestamps] [--threads]");
+
+	return retVal;
+}
+
+static void WriteRecords(std::ostream& output, const DecoderSettings& settings, const std::vector<BinaryLogRecord>& records)
+{
+	for (const auto& record : records)
+	{
+		if (settings.m_Timestamps)
+		{
+			output << '[' << record.m_Timestamp / 1000000000 << '.'
+				<< std::setfill('0') << std::setw(6) << record.m_Timestamp / 1000 % 1000000 << "] ";
+		}
+
+		if (settings.m_Threads)
+			output << "[T" << record.m_ThreadIndex << "] ";
+
+		output << record.m_Text << '\n';
+	}
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		const DecoderSettings settings = ParseArguments(argc, argv);
+
+		BinaryLogReader reader(settings.m_InputPath);
+		const auto records = reader.ReadAll();
+
+		if (reader.IsTruncated())
+			std::cerr << settings.m_InputPath << " ends partway through a block, the last records are missing\n";
+
+		if (settings.m_OutputPath.empty())
+			WriteRecords(std::cout, settings, records);
+		else
+		{
+			std::ofstream output(settings.m_OutputPath, std::ios::binary);
+			if (!output.good())
+				throw std::runtime_error(StringTools::CSFormat("Failed to open \"{0}\"", settings.m_OutputPath));
+
+			WriteRecords(output, settings, records);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << '\n';
+		return 1;
+	}
+
+	return 0;
+}
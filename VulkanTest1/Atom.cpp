@@ -0,0 +1,165 @@
+#include "stdafx.h"
+#include "Atom.h"
+
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+
+static constexpr uint32_t FNV_OFFSET_BASIS = 2166136261u;
+static constexpr uint32_t FNV_PRIME = 16777619u;
+
+Atom::Entry Atom::s_FirstChunk[CHUNK_SIZE] = { { "", 0, FNV_OFFSET_BASIS } };
+std::atomic<Atom::Entry*> Atom::s_Chunks[MAX_CHUNKS] = { s_FirstChunk };
+
+// Maps text to atom index. Open addressing with linear probing over indices
+// only, the text and hash are read back out of the entries.
+class AtomTable
+{
+public:
+	static AtomTable& Instance()
+	{
+		// Leaked so atoms stay usable from other static destructors
+		static AtomTable* s_Instance = new AtomTable();
+		return *s_Instance;
+	}
+
+	uint32_t Find(const std::string_view& text, uint32_t hash) const
+	{
+		std::shared_lock<std::shared_mutex> lock(m_Mutex);
+		return FindLocked(text, hash);
+	}
+
+	uint32_t Intern(const std::string_view& text, uint32_t hash)
+	{
+		if (const uint32_t found = Find(text, hash))
+			return found;
+
+		std::lock_guard<std::shared_mutex> lock(m_Mutex);
+
+		// Someone else may have added it while we were waiting for the lock
+		if (const uint32_t found = FindLocked(text, hash))
+			return found;
+
+		if (m_Count >= CAPACITY)
+			throw std::length_error(StringTools::CSFormat("Atom table is full ({0} atoms)", CAPACITY));
+
+		const uint32_t index = m_Count;
+		Atom::Entry* chunk = Atom::s_Chunks[index >> Atom::CHUNK_BITS].load(std::memory_order_relaxed);
+		if (!chunk)
+		{
+			m_Chunks.push_back(std::make_unique<Atom::Entry[]>(Atom::CHUNK_SIZE));
+			chunk = m_Chunks.back().get();
+			Atom::s_Chunks[index >> Atom::CHUNK_BITS].store(chunk, std::memory_order_release);
+		}
+
+		chunk[index & (Atom::CHUNK_SIZE - 1)] = { StoreText(text), uint32_t(text.size()), hash };
+		m_Count++;
+
+		// Rehashing picks up the new atom too
+		if (m_Count * 2 > m_Slots.size())
+			Rehash(m_Slots.size() * 2);
+		else
+			InsertSlot(index, hash);
+
+		return index;
+	}
+
+private:
+	static constexpr uint32_t CAPACITY = Atom::CHUNK_SIZE * Atom::MAX_CHUNKS;
+	static constexpr size_t TEXT_BLOCK_SIZE = 64 * 1024;
+
+	AtomTable() : m_Slots(1024) { }
+
+	uint32_t FindLocked(const std::string_view& text, uint32_t hash) const
+	{
+		const size_t mask = m_Slots.size() - 1;
+		for (size_t i = hash & mask; m_Slots[i]; i = (i + 1) & mask)
+		{
+			const Atom::Entry& entry = Atom::GetEntry(m_Slots[i]);
+			if (entry.m_Hash == hash && std::string_view(entry.m_Text, entry.m_Size) == text)
+				return m_Slots[i];
+		}
+
+		return 0;
+	}
+
+	void InsertSlot(uint32_t index, uint32_t hash)
+	{
+		const size_t mask = m_Slots.size() - 1;
+		size_t i = hash & mask;
+		while (m_Slots[i])
+			i = (i + 1) & mask;
+
+		m_Slots[i] = index;
+	}
+
+	void Rehash(size_t slotCount)
+	{
+		m_Slots.assign(slotCount, 0);
+
+		// The empty atom is index 0, which doubles as the empty slot marker, so
+		// it's never in here
+		for (uint32_t i = 1; i < m_Count; i++)
+			InsertSlot(i, Atom::GetEntry(i).m_Hash);
+	}
+
+	// Copies text (null terminated) somewhere it will never move or be freed
+	const char* StoreText(const std::string_view& text)
+	{
+		const size_t size = text.size() + 1;
+		if (size > TEXT_BLOCK_SIZE / 4)
+		{
+			m_LargeText.push_back(std::make_unique<char[]>(size));
+			char* retVal = m_LargeText.back().get();
+			std::copy(text.begin(), text.end(), retVal);
+			retVal[text.size()] = '\0';
+			return retVal;
+		}
+
+		if (m_TextBlocks.empty() || m_TextBlockUsed + size > TEXT_BLOCK_SIZE)
+		{
+			m_TextBlocks.push_back(std::make_unique<char[]>(TEXT_BLOCK_SIZE));
+			m_TextBlockUsed = 0;
+		}
+
+		char* retVal = m_TextBlocks.back().get() + m_TextBlockUsed;
+		std::copy(text.begin(), text.end(), retVal);
+		retVal[text.size()] = '\0';
+		m_TextBlockUsed += size;
+		return retVal;
+	}
+
+	mutable std::shared_mutex m_Mutex;
+
+	std::vector<uint32_t> m_Slots;
+	uint32_t m_Count = 1;	// The empty atom
+
+	std::vector<std::unique_ptr<Atom::Entry[]>> m_Chunks;
+	std::vector<std::unique_ptr<char[]>> m_TextBlocks;
+	std::vector<std::unique_ptr<char[]>> m_LargeText;
+	size_t m_TextBlockUsed = 0;
+};
+
+Atom::Atom(const std::string_view& text)
+{
+	if (!text.empty())
+		m_Index = AtomTable::Instance().Intern(text, Hash(text));
+}
+
+Atom Atom::Find(const std::string_view& text)
+{
+	if (text.empty())
+		return Atom();
+
+	return Atom(AtomTable::Instance().Find(text, Hash(text)));
+}
+
+// FNV-1a, same as JSONKeyHash
+uint32_t Atom::Hash(const std::string_view& text)
+{
+	uint32_t hash = FNV_OFFSET_BASIS;
+	for (char c : text)
+		hash = (hash ^ uint8_t(c)) * FNV_PRIME;
+
+	return hash;
+}
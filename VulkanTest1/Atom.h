@@ -0,0 +1,84 @@
+#pragma once
+#include "StringTools.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// An interned string: a 32-bit index into a process-wide table that only ever
+// grows. Two atoms are equal exactly when their text is, so comparing or hashing
+// them never touches the characters. Meant for names drawn from a mostly fixed
+// set (resource names, shader inputs), not arbitrary text, since nothing is
+// ever freed.
+//
+// Interning takes a shared lock (an exclusive one if the text is new). Getting
+// the text or hash back out of an atom never locks.
+class Atom
+{
+public:
+	// The empty string.
+	constexpr Atom() = default;
+	explicit Atom(const std::string_view& text);
+
+	// Looks text up without interning it. If it has never been interned, returns
+	// the empty atom, so anything keyed on the result just misses.
+	static Atom Find(const std::string_view& text);
+
+	// What GetHash() returns for an atom of text, without interning or even
+	// looking it up. Handy for tables that want to be searchable by either.
+	static uint32_t Hash(const std::string_view& text);
+
+	std::string_view GetView() const { const Entry& entry = GetEntry(m_Index); return std::string_view(entry.m_Text, entry.m_Size); }
+	// Always null terminated.
+	const char* c_str() const { return GetEntry(m_Index).m_Text; }
+	uint32_t GetHash() const { return GetEntry(m_Index).m_Hash; }
+	uint32_t GetIndex() const { return m_Index; }
+	bool empty() const { return !m_Index; }
+
+	bool operator==(const Atom& rhs) const { return m_Index == rhs.m_Index; }
+	bool operator!=(const Atom& rhs) const { return m_Index != rhs.m_Index; }
+	// Orders by when the text was first interned, not alphabetically.
+	bool operator<(const Atom& rhs) const { return m_Index < rhs.m_Index; }
+
+private:
+	struct Entry
+	{
+		const char* m_Text;
+		uint32_t m_Size;
+		uint32_t m_Hash;
+	};
+
+	static constexpr uint32_t CHUNK_BITS = 12;
+	static constexpr uint32_t CHUNK_SIZE = 1 << CHUNK_BITS;
+	static constexpr uint32_t MAX_CHUNKS = 1024;
+
+	static const Entry& GetEntry(uint32_t index)
+	{
+		return s_Chunks[index >> CHUNK_BITS].load(std::memory_order_acquire)[index & (CHUNK_SIZE - 1)];
+	}
+
+	// Entries never move once written, so they can be read without a lock. The
+	// first chunk is static, so the empty atom works before main().
+	static Entry s_FirstChunk[CHUNK_SIZE];
+	static std::atomic<Entry*> s_Chunks[MAX_CHUNKS];
+
+	friend class AtomTable;
+	constexpr explicit Atom(uint32_t index) : m_Index(index) { }
+
+	uint32_t m_Index = 0;
+};
+
+namespace std
+{
+	template<> struct hash<Atom>
+	{
+		size_t operator()(const Atom& x) const { return x.GetHash(); }
+	};
+}
+
+template<> struct CSFormatter<Atom>
+{
+	static void Append(std::string& out, const Atom& value) { out += value.GetView(); }
+};
@@ -0,0 +1,30 @@
+#include "stdafx.h"
+#include "AtomicWait.h"
+
+#include <cstdint>
+
+auto AtomicWait::GetSlot(const void* address) -> Slot&
+{
+	// Plenty to keep unrelated waits from sharing, as long as there aren't
+	// hundreds of threads blocked at once
+	static constexpr size_t SLOT_COUNT = 64;
+
+	// Leaked so threads still running during static destruction can use them
+	static Slot* const s_Slots = new Slot[SLOT_COUNT];
+
+	// The low bits are mostly alignment
+	const uintptr_t bits = reinterpret_cast<uintptr_t>(address);
+	return s_Slots[((bits >> 4) ^ (bits >> 10)) % SLOT_COUNT];
+}
+
+void AtomicWait::NotifyAll(const void* address)
+{
+	Slot& slot = GetSlot(address);
+	{
+		std::lock_guard<std::mutex> lock(slot.m_Mutex);
+	}
+
+	// Wakes anyone sharing the slot too, they just check their value and go
+	// back to sleep
+	slot.m_Changed.notify_all();
+}
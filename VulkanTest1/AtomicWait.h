@@ -0,0 +1,46 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+// Blocking until an atomic changes, like C++20's std::atomic::wait/notify_all.
+// Waiters park on one of a fixed set of mutex/condition variable slots picked
+// by the atomic's address, so nothing needs a mutex of its own just in case
+// someone has to wait on it.
+class AtomicWait final
+{
+public:
+	AtomicWait() = delete;
+	AtomicWait(const AtomicWait& other) = delete;
+	AtomicWait(AtomicWait&& other) = delete;
+	~AtomicWait() = delete;
+
+	// Returns once value no longer holds old. Can wake up a little after the
+	// change, but never before, and never misses one as long as whoever changes
+	// value calls NotifyAll() afterwards.
+	template<class T> static void Wait(const std::atomic<T>& value, T old);
+
+	// Wakes everyone waiting on the atomic at address.
+	static void NotifyAll(const void* address);
+
+private:
+	struct Slot
+	{
+		std::mutex m_Mutex;
+		std::condition_variable m_Changed;
+	};
+
+	static Slot& GetSlot(const void* address);
+};
+
+template<class T> inline void AtomicWait::Wait(const std::atomic<T>& value, T old)
+{
+	if (value.load(std::memory_order_acquire) != old)
+		return;
+
+	// NotifyAll() takes the same lock, so the change can't slip in between
+	// checking value and going to sleep
+	Slot& slot = GetSlot(&value);
+	std::unique_lock<std::mutex> lock(slot.m_Mutex);
+	slot.m_Changed.wait(lock, [&value, old]() { return value.load(std::memory_order_acquire) != old; });
+}
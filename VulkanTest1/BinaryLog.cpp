@@ -0,0 +1,260 @@
+#include "stdafx.h"
+#include "BinaryLog.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+// Each thread's buffer is written out once it gets this big
+static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+namespace
+{
+	struct ThreadBuffer
+	{
+		// Only contended when another thread is flushing or closing the log
+		std::mutex m_Mutex;
+		std::string m_Data;
+		uint32_t m_ThreadIndex;
+	};
+
+	struct BinaryLogState
+	{
+		std::atomic<bool> m_Open = false;
+		std::atomic<int64_t> m_StartTicks = 0;
+
+		// Everything below is protected by m_Mutex. Lock a thread's buffer
+		// before this, never the other way around.
+		std::mutex m_Mutex;
+		std::ofstream m_File;
+		bool m_AtExitRegistered = false;
+
+		std::vector<std::shared_ptr<ThreadBuffer>> m_Buffers;
+		uint32_t m_NextThreadIndex = 0;
+
+		// Format IDs last for the life of the process, every file gets all of them.
+		// The text is copied, so callers' strings don't have to outlive us.
+		std::unordered_map<std::string_view, uint32_t> m_FormatIDs;	// Views into m_Formats
+		std::vector<std::unique_ptr<const std::string>> m_Formats;
+		size_t m_WrittenFormatCount = 0;
+	};
+
+	// Flushes the thread's records when it exits
+	struct ThreadBufferOwner
+	{
+		~ThreadBufferOwner();
+
+		std::shared_ptr<ThreadBuffer> m_Buffer;
+
+		struct CachedFormat
+		{
+			uint32_t m_ID;
+			const std::string* m_Text = nullptr;	// Never changes once it's in BinaryLogState::m_Formats
+		};
+
+		// So looking up a format ID doesn't need the global lock. Keyed by
+		// address, with the text compared too in case a different string ends up
+		// at an address that was used before.
+		std::unordered_map<const char*, CachedFormat> m_FormatIDs;
+	};
+}
+
+// Never destroyed, threads can still be exiting during static destruction
+static BinaryLogState& GetState()
+{
+	static BinaryLogState* s_State = new BinaryLogState();
+	return *s_State;
+}
+
+static thread_local ThreadBufferOwner s_ThreadBuffer;
+
+static int64_t GetTicks()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void WriteBlock(std::ofstream& file, BinaryLog::BlockType type, uint32_t id, const std::string_view& data)
+{
+	const uint32_t size = uint32_t(data.size());
+	file.put(char(type));
+	file.write(reinterpret_cast<const char*>(&id), sizeof(id));
+	file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+	file.write(data.data(), data.size());
+}
+
+// buffer.m_Mutex must be held
+static void WriteBuffer(ThreadBuffer& buffer)
+{
+	if (buffer.m_Data.empty())
+		return;
+
+	auto& state = GetState();
+	{
+		std::lock_guard<std::mutex> lock(state.m_Mutex);
+		if (state.m_File.is_open())
+		{
+			// Formats first, this block might use them
+			for (; state.m_WrittenFormatCount < state.m_Formats.size(); state.m_WrittenFormatCount++)
+			{
+				WriteBlock(state.m_File, BinaryLog::BlockType::Format, uint32_t(state.m_WrittenFormatCount),
+					*state.m_Formats[state.m_WrittenFormatCount]);
+			}
+
+			WriteBlock(state.m_File, BinaryLog::BlockType::Records, buffer.m_ThreadIndex, buffer.m_Data);
+		}
+	}
+
+	buffer.m_Data.clear();
+}
+
+static ThreadBuffer& GetThreadBuffer()
+{
+	if (!s_ThreadBuffer.m_Buffer)
+	{
+		auto buffer = std::make_shared<ThreadBuffer>();
+		buffer->m_Data.reserve(BUFFER_SIZE + 1024);
+
+		auto& state = GetState();
+		std::lock_guard<std::mutex> lock(state.m_Mutex);
+		buffer->m_ThreadIndex = state.m_NextThreadIndex++;
+		state.m_Buffers.push_back(buffer);
+
+		s_ThreadBuffer.m_Buffer = std::move(buffer);
+	}
+
+	return *s_ThreadBuffer.m_Buffer;
+}
+
+ThreadBufferOwner::~ThreadBufferOwner()
+{
+	if (!m_Buffer)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Buffer->m_Mutex);
+		WriteBuffer(*m_Buffer);
+	}
+
+	auto& state = GetState();
+	std::lock_guard<std::mutex> lock(state.m_Mutex);
+	state.m_Buffers.erase(std::find(state.m_Buffers.begin(), state.m_Buffers.end(), m_Buffer));
+}
+
+void BinaryLog::Open(const std::filesystem::path& path)
+{
+	Close();
+
+	auto& state = GetState();
+
+	// Throw away anything logged while there was no file
+	{
+		std::unique_lock<std::mutex> lock(state.m_Mutex);
+		const auto buffers = state.m_Buffers;
+		lock.unlock();
+
+		for (const auto& buffer : buffers)
+		{
+			std::lock_guard<std::mutex> bufferLock(buffer->m_Mutex);
+			buffer->m_Data.clear();
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(state.m_Mutex);
+
+	state.m_File.open(path, std::ios::binary | std::ios::trunc);
+	if (!state.m_File.good())
+		throw std::runtime_error(StringTools::CSFormat("Failed to open binary log {0}", path));
+
+	Header header;
+	memcpy(header.m_Magic, MAGIC, sizeof(MAGIC));
+	header.m_Version = VERSION;
+	header.m_ByteOrder = BYTE_ORDER_MARK;
+	header.m_StartTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	state.m_File.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	state.m_WrittenFormatCount = 0;
+	state.m_StartTicks = GetTicks();
+	state.m_Open = true;
+
+	if (!state.m_AtExitRegistered)
+	{
+		std::atexit([]() { BinaryLog::Close(); });
+		state.m_AtExitRegistered = true;
+	}
+}
+
+void BinaryLog::Close()
+{
+	auto& state = GetState();
+	if (!state.m_Open.exchange(false))
+		return;
+
+	Flush();
+
+	std::lock_guard<std::mutex> lock(state.m_Mutex);
+	state.m_File.close();
+}
+
+bool BinaryLog::IsOpen()
+{
+	return GetState().m_Open.load(std::memory_order_relaxed);
+}
+
+void BinaryLog::Flush()
+{
+	auto& state = GetState();
+
+	std::unique_lock<std::mutex> lock(state.m_Mutex);
+	const auto buffers = state.m_Buffers;
+	lock.unlock();
+
+	for (const auto& buffer : buffers)
+	{
+		std::lock_guard<std::mutex> bufferLock(buffer->m_Mutex);
+		WriteBuffer(*buffer);
+	}
+
+	lock.lock();
+	if (state.m_File.is_open())
+		state.m_File.flush();
+}
+
+void BinaryLog::BeginRecord(std::string& out, const std::string_view& fmt, size_t argCount)
+{
+	auto& state = GetState();
+
+	auto& cached = s_ThreadBuffer.m_FormatIDs[fmt.data()];
+	if (!cached.m_Text || *cached.m_Text != fmt)
+	{
+		std::lock_guard<std::mutex> lock(state.m_Mutex);
+		auto found = state.m_FormatIDs.find(fmt);
+		if (found == state.m_FormatIDs.end())
+		{
+			const auto& text = state.m_Formats.emplace_back(std::make_unique<const std::string>(fmt));
+			found = state.m_FormatIDs.emplace(*text, uint32_t(state.m_Formats.size() - 1)).first;
+		}
+
+		cached.m_ID = found->second;
+		cached.m_Text = state.m_Formats[found->second].get();
+	}
+
+	AppendPOD(out, cached.m_ID);
+	AppendPOD(out, GetTicks() - state.m_StartTicks.load(std::memory_order_relaxed));
+	AppendPOD(out, uint8_t(argCount));
+}
+
+void BinaryLog::EndRecord(const std::string& record)
+{
+	ThreadBuffer& buffer = GetThreadBuffer();
+
+	std::lock_guard<std::mutex> lock(buffer.m_Mutex);
+	buffer.m_Data.append(record);
+
+	if (buffer.m_Data.size() >= BUFFER_SIZE)
+		WriteBuffer(buffer);
+}
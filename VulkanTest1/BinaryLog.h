@@ -0,0 +1,144 @@
+#pragma once
+#include "StringTools.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Compact log for high-frequency messages, see Log::DeferredMsg. Rather than
+// formatted text, each record is the ID of its format string, a timestamp and
+// the raw argument values, appended to a buffer owned by the logging thread.
+// Full buffers are written to the file as a single block. BinaryLogReader (and
+// the LogDecoder tool) turns the file back into exactly the text CSFormat would
+// have produced.
+//
+// File layout, all in native byte order: a Header, then blocks of
+// [uint8 BlockType][uint32 id][uint32 size][size bytes]:
+//	Format:		id is the format ID, the bytes are the format string
+//	Records:	id is the thread index, the bytes are records, each
+//				[uint32 format ID][int64 ns since Open()][uint8 arg count], then
+//				per arg [uint8 ArgType][value]. Strings are [uint32 length][bytes].
+// A format's block is always written before the first block that uses it.
+class BinaryLog final
+{
+public:
+	BinaryLog() = delete;
+	BinaryLog(const BinaryLog&) = delete;
+	BinaryLog(BinaryLog&&) = delete;
+	~BinaryLog() = delete;
+
+	// Starts a new file, replacing any existing one. Closed automatically at exit.
+	static void Open(const std::filesystem::path& path);
+	static void Close();
+	static bool IsOpen();
+
+	// Writes out every thread's buffered records.
+	static void Flush();
+
+	// fmt is copied the first time it's seen, and found by its address after
+	// that, so string literals are the cheapest.
+	template<class... Args> static void Write(const std::string_view& fmt, const Args&... args);
+
+	enum class BlockType : uint8_t
+	{
+		Format,
+		Records,
+	};
+
+	// What an argument was stored as. Integers are widened to 64 bits, anything
+	// that isn't a number, bool or char is stored as the text it formats to.
+	enum class ArgType : uint8_t
+	{
+		Int,
+		UInt,
+		Float,
+		Double,
+		Bool,
+		Char,
+		String,
+	};
+
+	struct Header
+	{
+		char m_Magic[8];
+		uint32_t m_Version;
+		uint32_t m_ByteOrder;	// BYTE_ORDER_MARK, as written by the logging machine
+		int64_t m_StartTime;	// system_clock, ns since its epoch
+	};
+
+	static constexpr char MAGIC[8] = { 'V', 'T', 'B', 'I', 'N', 'L', 'O', 'G' };
+	static constexpr uint32_t VERSION = 1;
+	static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+private:
+	// Appends the record's header to out
+	static void BeginRecord(std::string& out, const std::string_view& fmt, size_t argCount);
+	// Moves the finished record into this thread's buffer
+	static void EndRecord(const std::string& record);
+
+	template<class T> static void AppendArg(std::string& out, const T& value);
+	template<class T> static void AppendPOD(std::string& out, const T& value) { out.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+};
+
+template<class... Args>
+inline void BinaryLog::Write(const std::string_view& fmt, const Args&... args)
+{
+	static_assert(sizeof...(args) <= UINT8_MAX);
+
+	// Built separately so arguments that log while being formatted don't end up inside this record
+	StringTools::ScratchString record;
+	BeginRecord(record.Get(), fmt, sizeof...(args));
+	(AppendArg(record.Get(), args), ...);
+	EndRecord(record.Get());
+}
+
+template<class T>
+inline void BinaryLog::AppendArg(std::string& out, const T& value)
+{
+	if constexpr (std::is_same_v<T, bool>)
+	{
+		out += char(ArgType::Bool);
+		out += char(value ? 1 : 0);
+	}
+	else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>)
+	{
+		out += char(ArgType::Char);
+		out += char(value);
+	}
+	else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+	{
+		out += char(ArgType::Int);
+		AppendPOD(out, int64_t(value));
+	}
+	else if constexpr (std::is_integral_v<T>)
+	{
+		out += char(ArgType::UInt);
+		AppendPOD(out, uint64_t(value));
+	}
+	else if constexpr (std::is_same_v<T, float>)
+	{
+		out += char(ArgType::Float);
+		AppendPOD(out, value);
+	}
+	else if constexpr (std::is_same_v<T, double>)
+	{
+		out += char(ArgType::Double);
+		AppendPOD(out, value);
+	}
+	else
+	{
+		out += char(ArgType::String);
+
+		// Format straight into the record, then go back and fill in the length
+		const size_t lengthOffset = out.size();
+		AppendPOD(out, uint32_t(0));
+		CSFormatter<T>::Append(out, value);
+
+		const uint32_t length = uint32_t(out.size() - lengthOffset - sizeof(uint32_t));
+		memcpy(&out[lengthOffset], &length, sizeof(length));
+	}
+}
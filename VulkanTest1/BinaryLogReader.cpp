@@ -0,0 +1,151 @@
+#include "stdafx.h"
+#include "BinaryLogReader.h"
+
+#include <algorithm>
+
+namespace
+{
+	// Bounds-checked reads from a block of the file
+	class BinaryLogCursor
+	{
+	public:
+		BinaryLogCursor(const std::string_view& data) : m_Data(data) { }
+
+		bool IsEnd() const { return m_Offset >= m_Data.size(); }
+		size_t GetRemaining() const { return m_Data.size() - m_Offset; }
+
+		template<class T> T Read()
+		{
+			T retVal;
+			memcpy(&retVal, ReadBytes(sizeof(T)).data(), sizeof(T));
+			return retVal;
+		}
+
+		std::string_view ReadBytes(size_t count)
+		{
+			if (count > GetRemaining())
+				throw std::runtime_error("Unexpected end of binary log block");
+
+			const std::string_view retVal = m_Data.substr(m_Offset, count);
+			m_Offset += count;
+			return retVal;
+		}
+
+	private:
+		std::string_view m_Data;
+		size_t m_Offset = 0;
+	};
+}
+
+BinaryLogReader::BinaryLogReader(const std::filesystem::path& path) :
+	m_File(path)
+{
+	if (m_File.size() < sizeof(m_Header))
+		throw std::runtime_error(StringTools::CSFormat("{0} is too small to be a binary log", path));
+
+	memcpy(&m_Header, m_File.data(), sizeof(m_Header));
+
+	if (memcmp(m_Header.m_Magic, BinaryLog::MAGIC, sizeof(BinaryLog::MAGIC)))
+		throw std::runtime_error(StringTools::CSFormat("{0} is not a binary log", path));
+	if (m_Header.m_Version != BinaryLog::VERSION)
+		throw std::runtime_error(StringTools::CSFormat("{0} is binary log version {1}, expected {2}", path, m_Header.m_Version, BinaryLog::VERSION));
+	if (m_Header.m_ByteOrder != BinaryLog::BYTE_ORDER_MARK)
+		throw std::runtime_error(StringTools::CSFormat("{0} was written on a machine with a different byte order", path));
+}
+
+std::vector<BinaryLogRecord> BinaryLogReader::ReadAll()
+{
+	std::vector<BinaryLogRecord> retVal;
+
+	m_Formats.clear();
+	m_Truncated = false;
+
+	BinaryLogCursor cursor(m_File.GetView().substr(sizeof(m_Header)));
+	while (!cursor.IsEnd())
+	{
+		constexpr size_t BLOCK_HEADER_SIZE = sizeof(uint8_t) + sizeof(uint32_t) * 2;
+		if (cursor.GetRemaining() < BLOCK_HEADER_SIZE)
+		{
+			m_Truncated = true;
+			break;
+		}
+
+		const auto type = BinaryLog::BlockType(cursor.Read<uint8_t>());
+		const auto id = cursor.Read<uint32_t>();
+		const auto size = cursor.Read<uint32_t>();
+		if (size > cursor.GetRemaining())
+		{
+			m_Truncated = true;
+			break;
+		}
+
+		const std::string_view data = cursor.ReadBytes(size);
+		switch (type)
+		{
+		case BinaryLog::BlockType::Format:
+			if (id != m_Formats.size())
+				throw std::runtime_error(StringTools::CSFormat("Format {0} was out of order, expected {1}", id, m_Formats.size()));
+
+			m_Formats.push_back(data);
+			break;
+
+		case BinaryLog::BlockType::Records:
+			ReadRecords(data, id, retVal);
+			break;
+
+		default:
+			throw std::runtime_error(StringTools::CSFormat("Unknown binary log block type {0}", unsigned(type)));
+		}
+	}
+
+	// Each block is in order, but blocks from different threads overlap
+	std::stable_sort(retVal.begin(), retVal.end(),
+		[](const BinaryLogRecord& a, const BinaryLogRecord& b) { return a.m_Timestamp < b.m_Timestamp; });
+
+	return retVal;
+}
+
+void BinaryLogReader::ReadRecords(const std::string_view& data, uint32_t threadIndex, std::vector<BinaryLogRecord>& records) const
+{
+	std::vector<std::string> args;
+	std::vector<std::string_view> argViews;
+
+	BinaryLogCursor cursor(data);
+	while (!cursor.IsEnd())
+	{
+		BinaryLogRecord& record = records.emplace_back();
+		record.m_ThreadIndex = threadIndex;
+
+		const auto formatID = cursor.Read<uint32_t>();
+		if (formatID >= m_Formats.size())
+			throw std::runtime_error(StringTools::CSFormat("Record used format {0} before it was defined", formatID));
+
+		record.m_Timestamp = cursor.Read<int64_t>();
+
+		// Formatted with the same CSFormatter the original argument would have used
+		const auto argCount = cursor.Read<uint8_t>();
+		args.resize(argCount);
+		for (auto& arg : args)
+		{
+			arg.clear();
+
+			const auto argType = BinaryLog::ArgType(cursor.Read<uint8_t>());
+			switch (argType)
+			{
+			case BinaryLog::ArgType::Int:		CSFormatter<int64_t>::Append(arg, cursor.Read<int64_t>()); break;
+			case BinaryLog::ArgType::UInt:		CSFormatter<uint64_t>::Append(arg, cursor.Read<uint64_t>()); break;
+			case BinaryLog::ArgType::Float:		CSFormatter<float>::Append(arg, cursor.Read<float>()); break;
+			case BinaryLog::ArgType::Double:	CSFormatter<double>::Append(arg, cursor.Read<double>()); break;
+			case BinaryLog::ArgType::Bool:		CSFormatter<bool>::Append(arg, cursor.Read<uint8_t>() != 0); break;
+			case BinaryLog::ArgType::Char:		CSFormatter<char>::Append(arg, cursor.Read<char>()); break;
+			case BinaryLog::ArgType::String:	arg = cursor.ReadBytes(cursor.Read<uint32_t>()); break;
+
+			default:
+				throw std::runtime_error(StringTools::CSFormat("Unknown binary log argument type {0}", unsigned(argType)));
+			}
+		}
+
+		argViews.assign(args.begin(), args.end());
+		StringTools::CSFormatToPreformatted(record.m_Text, m_Formats[formatID], argViews.data(), argViews.size());
+	}
+}
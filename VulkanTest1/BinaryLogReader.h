@@ -0,0 +1,39 @@
+#pragma once
+#include "BinaryLog.h"
+#include "MemoryMappedFile.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct BinaryLogRecord
+{
+	int64_t m_Timestamp;	// ns since the log was opened
+	uint32_t m_ThreadIndex;
+	std::string m_Text;		// Without a trailing newline
+};
+
+class BinaryLogReader
+{
+public:
+	BinaryLogReader(const std::filesystem::path& path);
+
+	// system_clock, ns since its epoch
+	int64_t GetStartTime() const { return m_Header.m_StartTime; }
+
+	// Every record in the file, formatted and in timestamp order. A partially
+	// written block at the end (the program died mid-write) is skipped, and
+	// IsTruncated() returns true.
+	std::vector<BinaryLogRecord> ReadAll();
+	bool IsTruncated() const { return m_Truncated; }
+
+private:
+	void ReadRecords(const std::string_view& data, uint32_t threadIndex, std::vector<BinaryLogRecord>& records) const;
+
+	MemoryMappedFile m_File;
+	BinaryLog::Header m_Header;
+	std::vector<std::string_view> m_Formats;
+	bool m_Truncated = false;
+};
@@ -0,0 +1,638 @@
+#include "stdafx.h"
+#include "BlockCompressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+	constexpr uint32_t BLOCK_TEXELS = 16;
+
+	// 4x4 texels, row by row from the top left
+	using Block = uint8_t[BLOCK_TEXELS][4];
+
+	// How far towards the second endpoint each BC7 4 bit index is, out of 64
+	constexpr uint32_t BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// Blocks are packed starting from the lowest bit of the first byte
+	class BitWriter
+	{
+	public:
+		BitWriter(uint8_t* out, size_t size) : m_Out(out) { memset(out, 0, size); }
+
+		void Write(uint32_t value, uint32_t bits)
+		{
+			for (uint32_t i = 0; i < bits; i++, m_Position++)
+			{
+				if (value & (1u << i))
+					m_Out[m_Position / 8] |= uint8_t(1u << (m_Position % 8));
+			}
+		}
+
+	private:
+		uint8_t* m_Out;
+		uint32_t m_Position = 0;
+	};
+}
+
+vk::Format BlockCompressor::ChooseFormat(TextureCompression compression, const uint8_t* rgba, uint32_t width, uint32_t height)
+{
+	switch (compression)
+	{
+	case TextureCompression::None:	return vk::Format::eR8G8B8A8Unorm;
+	case TextureCompression::BC1:	return vk::Format::eBc1RgbaUnormBlock;
+	case TextureCompression::BC3:	return vk::Format::eBc3UnormBlock;
+	case TextureCompression::BC4:	return vk::Format::eBc4UnormBlock;
+	case TextureCompression::BC5:	return vk::Format::eBc5UnormBlock;
+	case TextureCompression::BC7:	return vk::Format::eBc7UnormBlock;
+	case TextureCompression::Auto:	break;
+
+	default:
+		throw std::invalid_argument(StringTools::CSFormat("Unknown TextureCompression {0}", Enums::value(compression)));
+	}
+
+	bool opaque = true;
+	bool gray = true;
+	bool noBlue = true;
+	for (size_t i = 0; i < size_t(width) * height; i++)
+	{
+		const uint8_t* texel = rgba + i * 4;
+		opaque &= (texel[3] == 255);
+		gray &= (texel[0] == texel[1] && texel[1] == texel[2]);
+		noBlue &= (texel[2] == 0);
+	}
+
+	if (!opaque)
+		return vk::Format::eBc3UnormBlock;
+	else if (gray)
+		return vk::Format::eBc4UnormBlock;
+	else if (noBlue)
+		return vk::Format::eBc5UnormBlock;
+	else
+		return vk::Format::eBc1RgbaUnormBlock;
+}
+
+bool BlockCompressor::IsSupported(vk::Format format)
+{
+	switch (format)
+	{
+	case vk::Format::eR8G8B8A8Unorm:
+	case vk::Format::eBc1RgbaUnormBlock:
+	case vk::Format::eBc3UnormBlock:
+	case vk::Format::eBc4UnormBlock:
+	case vk::Format::eBc5UnormBlock:
+	case vk::Format::eBc7UnormBlock:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+vk::ComponentMapping BlockCompressor::GetComponentMapping(vk::Format format)
+{
+	using S = vk::ComponentSwizzle;
+
+	switch (format)
+	{
+	case vk::Format::eBc4UnormBlock:	return vk::ComponentMapping(S::eR, S::eR, S::eR, S::eOne);
+	case vk::Format::eBc5UnormBlock:	return vk::ComponentMapping(S::eR, S::eG, S::eZero, S::eOne);
+	default:							return vk::ComponentMapping();
+	}
+}
+
+size_t BlockCompressor::GetImageSize(vk::Format format, uint32_t width, uint32_t height)
+{
+	const size_t blocks = size_t((width + 3) / 4) * ((height + 3) / 4);
+
+	switch (format)
+	{
+	case vk::Format::eR8G8B8A8Unorm:		return size_t(width) * height * 4;
+	case vk::Format::eBc1RgbaUnormBlock:
+	case vk::Format::eBc4UnormBlock:		return blocks * 8;
+	case vk::Format::eBc3UnormBlock:
+	case vk::Format::eBc5UnormBlock:
+	case vk::Format::eBc7UnormBlock:		return blocks * 16;
+
+	default:
+		throw std::invalid_argument(StringTools::CSFormat("{0}: Unsupported format {1}", __FUNCTION__, vk::to_string(format)));
+	}
+}
+
+// Texels past the right and bottom edges repeat the last row/column, so they
+// don't pull the endpoints anywhere the real texels don't need
+static void LoadBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, Block& block)
+{
+	for (uint32_t y = 0; y < 4; y++)
+	{
+		const uint32_t srcY = std::min(blockY * 4 + y, height - 1);
+		for (uint32_t x = 0; x < 4; x++)
+		{
+			const uint32_t srcX = std::min(blockX * 4 + x, width - 1);
+			memcpy(block[y * 4 + x], rgba + (size_t(srcY) * width + srcX) * 4, 4);
+		}
+	}
+}
+
+// Line through the used texels along their principal axis, trimmed to where
+// they actually fall on it
+template<size_t N> static void FindEndpoints(const float (&texels)[BLOCK_TEXELS][N], const bool (&used)[BLOCK_TEXELS], float (&e0)[N], float (&e1)[N])
+{
+	float mean[N] = {};
+	float count = 0;
+	for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+	{
+		if (!used[i])
+			continue;
+
+		for (size_t c = 0; c < N; c++)
+			mean[c] += texels[i][c];
+
+		count++;
+	}
+
+	for (size_t c = 0; c < N; c++)
+		mean[c] /= count;
+
+	float covariance[N][N] = {};
+	float minimum[N];
+	float maximum[N];
+	std::fill(std::begin(minimum), std::end(minimum), 255.0f);
+	std::fill(std::begin(maximum), std::end(maximum), 0.0f);
+	for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+	{
+		if (!used[i])
+			continue;
+
+		for (size_t a = 0; a < N; a++)
+		{
+			minimum[a] = std::min(minimum[a], texels[i][a]);
+			maximum[a] = std::max(maximum[a], texels[i][a]);
+
+			for (size_t b = 0; b < N; b++)
+				covariance[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+		}
+	}
+
+	// Power iteration, starting from the bounding box diagonal
+	float axis[N];
+	for (size_t c = 0; c < N; c++)
+		axis[c] = maximum[c] - minimum[c];
+
+	for (int iteration = 0; iteration < 8; iteration++)
+	{
+		float next[N] = {};
+		float length = 0;
+		for (size_t a = 0; a < N; a++)
+		{
+			for (size_t b = 0; b < N; b++)
+				next[a] += covariance[a][b] * axis[b];
+
+			length = std::max(length, std::abs(next[a]));
+		}
+
+		if (length <= 0)
+			break;
+
+		for (size_t c = 0; c < N; c++)
+			axis[c] = next[c] / length;
+	}
+
+	float lengthSquared = 0;
+	for (size_t c = 0; c < N; c++)
+		lengthSquared += axis[c] * axis[c];
+
+	if (lengthSquared <= 0)
+	{
+		// Every used texel is the same
+		std::copy(std::begin(mean), std::end(mean), std::begin(e0));
+		std::copy(std::begin(mean), std::end(mean), std::begin(e1));
+		return;
+	}
+
+	float minT = std::numeric_limits<float>::max();
+	float maxT = std::numeric_limits<float>::lowest();
+	for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+	{
+		if (!used[i])
+			continue;
+
+		float t = 0;
+		for (size_t c = 0; c < N; c++)
+			t += (texels[i][c] - mean[c]) * axis[c];
+
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+
+	for (size_t c = 0; c < N; c++)
+	{
+		e0[c] = std::clamp(mean[c] + axis[c] * minT / lengthSquared, 0.0f, 255.0f);
+		e1[c] = std::clamp(mean[c] + axis[c] * maxT / lengthSquared, 0.0f, 255.0f);
+	}
+}
+
+// Least squares endpoints for texels that have already been assigned a
+// position (0 = e0, 1 = e1) along the line. False if they all landed on the
+// same spot and there's nothing to solve for.
+template<size_t N> static bool FitEndpoints(const float (&texels)[BLOCK_TEXELS][N], const bool (&used)[BLOCK_TEXELS], const float (&positions)[BLOCK_TEXELS],
+	float (&e0)[N], float (&e1)[N])
+{
+	float aa = 0, bb = 0, ab = 0;
+	float ax[N] = {};
+	float bx[N] = {};
+	for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+	{
+		if (!used[i])
+			continue;
+
+		const float b = positions[i];
+		const float a = 1 - b;
+		aa += a * a;
+		bb += b * b;
+		ab += a * b;
+
+		for (size_t c = 0; c < N; c++)
+		{
+			ax[c] += a * texels[i][c];
+			bx[c] += b * texels[i][c];
+		}
+	}
+
+	const float determinant = aa * bb - ab * ab;
+	if (std::abs(determinant) < 1e-6f)
+		return false;
+
+	for (size_t c = 0; c < N; c++)
+	{
+		e0[c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+		e1[c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+	}
+
+	return true;
+}
+
+static float DistanceSquared(const float* a, const float* b, size_t count)
+{
+	float retVal = 0;
+	for (size_t c = 0; c < count; c++)
+		retVal += (a[c] - b[c]) * (a[c] - b[c]);
+
+	return retVal;
+}
+
+static uint16_t To565(const float (&color)[3])
+{
+	const auto quantize = [](float value, uint32_t max) { return uint32_t(value * max / 255 + 0.5f); };
+	return uint16_t((quantize(color[0], 31) << 11) | (quantize(color[1], 63) << 5) | quantize(color[2], 31));
+}
+
+static void From565(uint16_t packed, float (&color)[3])
+{
+	const uint32_t r = (packed >> 11) & 31;
+	const uint32_t g = (packed >> 5) & 63;
+	const uint32_t b = packed & 31;
+	color[0] = float((r << 3) | (r >> 2));
+	color[1] = float((g << 2) | (g >> 4));
+	color[2] = float((b << 3) | (b >> 2));
+}
+
+namespace
+{
+	struct ColorBlock
+	{
+		uint16_t m_Color0;
+		uint16_t m_Color1;
+		uint8_t m_Indices[BLOCK_TEXELS];
+		float m_Error;
+	};
+}
+
+// Orders the endpoints for the mode we want and picks the closest palette entry
+// for each texel. Four color mode needs color0 > color1, three color mode (the
+// one with transparent black) needs color0 <= color1.
+static ColorBlock MakeColorBlock(uint16_t color0, uint16_t color1, bool threeColor,
+	const float (&texels)[BLOCK_TEXELS][3], const bool (&opaque)[BLOCK_TEXELS])
+{
+	if (threeColor == (color0 > color1))
+		std::swap(color0, color1);
+
+	ColorBlock retVal;
+	retVal.m_Color0 = color0;
+	retVal.m_Color1 = color1;
+	retVal.m_Error = 0;
+
+	float palette[4][3];
+	From565(color0, palette[0]);
+	From565(color1, palette[1]);
+	for (size_t c = 0; c < 3; c++)
+	{
+		if (threeColor || color0 == color1)
+		{
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+		else
+		{
+			palette[2][c] = (palette[0][c] * 2 + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + palette[1][c] * 2) / 3;
+		}
+	}
+
+	const uint32_t paletteSize = (threeColor || color0 == color1) ? 3 : 4;
+	for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+	{
+		if (!opaque[i])
+		{
+			retVal.m_Indices[i] = 3;
+			continue;
+		}
+
+		uint8_t best = 0;
+		float bestError = std::numeric_limits<float>::max();
+		for (uint8_t p = 0; p < paletteSize; p++)
+		{
+			const float error = DistanceSquared(texels[i], palette[p], 3);
+			if (error < bestError)
+			{
+				best = p;
+				bestError = error;
+			}
+		}
+
+		retVal.m_Indices[i] = best;
+		retVal.m_Error += bestError;
+	}
+
+	return retVal;
+}
+
+// BC1 layout: two 5:6:5 endpoints, then 2 bits per texel
+static void CompressColorBlock(const Block& block, bool allowTransparent, uint8_t* out)
+{
+	float texels[BLOCK_TEXELS][3];
+	bool opaque[BLOCK_TEXELS];
+	bool anyTransparent = false;
+	bool anyOpaque = false;
+	for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+	{
+		for (size_t c = 0; c < 3; c++)
+			texels[i][c] = block[i][c];
+
+		opaque[i] = !allowTransparent || block[i][3] >= 128;
+		anyTransparent |= !opaque[i];
+		anyOpaque |= opaque[i];
+	}
+
+	ColorBlock result;
+	if (!anyOpaque)
+	{
+		result = MakeColorBlock(0, 0, true, texels, opaque);
+	}
+	else
+	{
+		float e0[3], e1[3];
+		FindEndpoints(texels, opaque, e0, e1);
+		result = MakeColorBlock(To565(e0), To565(e1), anyTransparent, texels, opaque);
+
+		// One round of refinement is where most of the gain is
+		float positions[BLOCK_TEXELS];
+		for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			static constexpr float FOUR_COLOR[] = { 0, 1, 1.0f / 3, 2.0f / 3 };
+			static constexpr float THREE_COLOR[] = { 0, 1, 0.5f, 0 };
+			positions[i] = (anyTransparent ? THREE_COLOR : FOUR_COLOR)[result.m_Indices[i]];
+		}
+
+		if (FitEndpoints(texels, opaque, positions, e0, e1))
+		{
+			const ColorBlock refined = MakeColorBlock(To565(e0), To565(e1), anyTransparent, texels, opaque);
+			if (refined.m_Error < result.m_Error)
+				result = refined;
+		}
+	}
+
+	uint32_t indices = 0;
+	for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		indices |= uint32_t(result.m_Indices[i]) << (i * 2);
+
+	out[0] = uint8_t(result.m_Color0);
+	out[1] = uint8_t(result.m_Color0 >> 8);
+	out[2] = uint8_t(result.m_Color1);
+	out[3] = uint8_t(result.m_Color1 >> 8);
+	memcpy(out + 4, &indices, sizeof(indices));
+}
+
+// BC4 layout, also used for BC3 alpha and both halves of BC5: two 8 bit
+// endpoints, then 3 bits per texel. With endpoint0 > endpoint1 there are six
+// values evenly spaced between them.
+static void CompressChannelBlock(const Block& block, size_t channel, uint8_t* out)
+{
+	uint8_t minimum = 255;
+	uint8_t maximum = 0;
+	for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+	{
+		minimum = std::min(minimum, block[i][channel]);
+		maximum = std::max(maximum, block[i][channel]);
+	}
+
+	BitWriter writer(out, 8);
+	writer.Write(maximum, 8);
+	writer.Write(minimum, 8);
+
+	if (minimum == maximum)
+		return;
+
+	// Palette order is endpoint0, endpoint1, then the in-betweens from
+	// endpoint0's end
+	static constexpr uint32_t STEP_TO_INDEX[8] = { 0, 2, 3, 4, 5, 6, 7, 1 };
+	for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+	{
+		const float position = float(maximum - block[i][channel]) / (maximum - minimum);
+		writer.Write(STEP_TO_INDEX[uint32_t(position * 7 + 0.5f)], 3);
+	}
+}
+
+static void QuantizeBC7Endpoint(const float (&endpoint)[4], uint32_t (&quantized)[4], uint32_t& pBit, float (&expanded)[4])
+{
+	// 7 bits per channel plus one low bit shared by all four, so try both
+	float bestError = std::numeric_limits<float>::max();
+	for (uint32_t p = 0; p < 2; p++)
+	{
+		uint32_t q[4];
+		float e[4];
+		for (size_t c = 0; c < 4; c++)
+		{
+			q[c] = uint32_t(std::clamp((endpoint[c] - p) / 2 + 0.5f, 0.0f, 127.0f));
+			e[c] = float((q[c] << 1) | p);
+		}
+
+		const float error = DistanceSquared(endpoint, e, 4);
+		if (error < bestError)
+		{
+			bestError = error;
+			pBit = p;
+			std::copy(std::begin(q), std::end(q), std::begin(quantized));
+			std::copy(std::begin(e), std::end(e), std::begin(expanded));
+		}
+	}
+}
+
+namespace
+{
+	struct BC7Block
+	{
+		uint32_t m_Endpoints[2][4];
+		uint32_t m_PBits[2];
+		uint8_t m_Indices[BLOCK_TEXELS];
+		float m_Error;
+	};
+}
+
+static BC7Block MakeBC7Block(const float (&e0)[4], const float (&e1)[4], const float (&texels)[BLOCK_TEXELS][4])
+{
+	BC7Block retVal;
+	retVal.m_Error = 0;
+
+	float expanded[2][4];
+	QuantizeBC7Endpoint(e0, retVal.m_Endpoints[0], retVal.m_PBits[0], expanded[0]);
+	QuantizeBC7Endpoint(e1, retVal.m_Endpoints[1], retVal.m_PBits[1], expanded[1]);
+
+	float palette[16][4];
+	for (size_t p = 0; p < 16; p++)
+	{
+		for (size_t c = 0; c < 4; c++)
+			palette[p][c] = float((uint32_t(expanded[0][c]) * (64 - BC7_WEIGHTS[p]) + uint32_t(expanded[1][c]) * BC7_WEIGHTS[p] + 32) >> 6);
+	}
+
+	for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+	{
+		uint8_t best = 0;
+		float bestError = std::numeric_limits<float>::max();
+		for (uint8_t p = 0; p < 16; p++)
+		{
+			const float error = DistanceSquared(texels[i], palette[p], 4);
+			if (error < bestError)
+			{
+				best = p;
+				bestError = error;
+			}
+		}
+
+		retVal.m_Indices[i] = best;
+		retVal.m_Error += bestError;
+	}
+
+	return retVal;
+}
+
+// Mode 6 only: one RGBA line per block with 4 bit indices. It has the most
+// precise endpoints and indices of any single subset mode, which covers most
+// textures well. The partitioned modes would do better on blocks with sharp
+// edges between unrelated colors, at a much higher search cost.
+static void CompressBC7Block(const Block& block, uint8_t* out)
+{
+	float texels[BLOCK_TEXELS][4];
+	bool used[BLOCK_TEXELS];
+	for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+	{
+		for (size_t c = 0; c < 4; c++)
+			texels[i][c] = block[i][c];
+
+		used[i] = true;
+	}
+
+	float e0[4], e1[4];
+	FindEndpoints(texels, used, e0, e1);
+	BC7Block result = MakeBC7Block(e0, e1, texels);
+
+	float positions[BLOCK_TEXELS];
+	for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		positions[i] = BC7_WEIGHTS[result.m_Indices[i]] / 64.0f;
+
+	if (FitEndpoints(texels, used, positions, e0, e1))
+	{
+		const BC7Block refined = MakeBC7Block(e0, e1, texels);
+		if (refined.m_Error < result.m_Error)
+			result = refined;
+	}
+
+	// Texel 0's index only gets 3 bits, the top one is implied to be 0
+	if (result.m_Indices[0] & 8)
+	{
+		std::swap(result.m_Endpoints[0], result.m_Endpoints[1]);
+		std::swap(result.m_PBits[0], result.m_PBits[1]);
+		for (uint8_t& index : result.m_Indices)
+			index = 15 - index;
+	}
+
+	BitWriter writer(out, 16);
+	writer.Write(1 << 6, 7);
+
+	for (size_t c = 0; c < 4; c++)
+	{
+		writer.Write(result.m_Endpoints[0][c], 7);
+		writer.Write(result.m_Endpoints[1][c], 7);
+	}
+
+	writer.Write(result.m_PBits[0], 1);
+	writer.Write(result.m_PBits[1], 1);
+
+	writer.Write(result.m_Indices[0], 3);
+	for (uint32_t i = 1; i < BLOCK_TEXELS; i++)
+		writer.Write(result.m_Indices[i], 4);
+}
+
+void BlockCompressor::Compress(vk::Format format, const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* out)
+{
+	if (format == vk::Format::eR8G8B8A8Unorm)
+	{
+		memcpy(out, rgba, GetImageSize(format, width, height));
+		return;
+	}
+
+	const size_t blockSize = GetImageSize(format, 4, 4);
+	const uint32_t blocksX = (width + 3) / 4;
+	const uint32_t blocksY = (height + 3) / 4;
+
+	Block block;
+	for (uint32_t blockY = 0; blockY < blocksY; blockY++)
+	{
+		for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+		{
+			LoadBlock(rgba, width, height, blockX, blockY, block);
+
+			switch (format)
+			{
+			case vk::Format::eBc1RgbaUnormBlock:
+				CompressColorBlock(block, true, out);
+				break;
+
+			case vk::Format::eBc3UnormBlock:
+				CompressChannelBlock(block, 3, out);
+				CompressColorBlock(block, false, out + 8);
+				break;
+
+			case vk::Format::eBc4UnormBlock:
+				CompressChannelBlock(block, 0, out);
+				break;
+
+			case vk::Format::eBc5UnormBlock:
+				CompressChannelBlock(block, 0, out);
+				CompressChannelBlock(block, 1, out + 8);
+				break;
+
+			case vk::Format::eBc7UnormBlock:
+				CompressBC7Block(block, out);
+				break;
+
+			default:
+				throw std::invalid_argument(StringTools::CSFormat("{0}: Unsupported format {1}", __FUNCTION__, vk::to_string(format)));
+			}
+
+			out += blockSize;
+		}
+	}
+}
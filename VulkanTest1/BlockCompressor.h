@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+enum class TextureCompression
+{
+	// Plain RGBA8
+	None,
+
+	// Picked from the channels the image actually uses, see
+	// BlockCompressor::ChooseFormat()
+	Auto,
+
+	BC1,	// RGB, or RGB with 1 bit alpha. 4 bits per texel.
+	BC3,	// RGBA. 8 bits per texel.
+	BC4,	// Red only. 4 bits per texel.
+	BC5,	// Red and green. 8 bits per texel.
+	BC7,	// RGBA. 8 bits per texel, better than BC3 for color but slower to encode.
+};
+
+// Encodes tightly packed RGBA8 images to the BCn block compressed formats. It's
+// all CPU work with nothing from the device, so textures can be cooked on
+// machines without a GPU.
+class BlockCompressor final
+{
+public:
+	BlockCompressor() = delete;
+	BlockCompressor(const BlockCompressor& other) = delete;
+	BlockCompressor(BlockCompressor&& other) = delete;
+	~BlockCompressor() = delete;
+
+	// The format for compression. For TextureCompression::Auto, the smallest
+	// one that holds everything the image uses:
+	//   gray and opaque              BC4
+	//   red and green only, opaque   BC5
+	//   opaque                       BC1
+	//   anything else                BC3
+	// BC1 is always written with 1 bit alpha, texels with alpha under 128 come
+	// out transparent black.
+	static vk::Format ChooseFormat(TextureCompression compression, const uint8_t* rgba, uint32_t width, uint32_t height);
+
+	// Every format Compress() can write, which includes plain eR8G8B8A8Unorm.
+	static bool IsSupported(vk::Format format);
+	static bool IsBlockCompressed(vk::Format format) { return format != vk::Format::eR8G8B8A8Unorm; }
+
+	// BC4 and BC5 only store red (and green), so views have to put the rest back.
+	static vk::ComponentMapping GetComponentMapping(vk::Format format);
+
+	// Including the partial blocks at the right and bottom edges.
+	static size_t GetImageSize(vk::Format format, uint32_t width, uint32_t height);
+
+	// out has room for GetImageSize() bytes.
+	static void Compress(vk::Format format, const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* out);
+};
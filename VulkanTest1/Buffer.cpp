@@ -4,10 +4,11 @@
 #include "LogicalDevice.h"
 #include "VulkanHelpers.h"
 
-Buffer::Buffer(LogicalDevice& device, vk::DeviceSize size, const vk::BufferUsageFlags& bufFlags, const vk::MemoryPropertyFlags& memFlags) :
+Buffer::Buffer(LogicalDevice& device, vk::DeviceSize size, const vk::BufferUsageFlags& bufFlags, const vk::MemoryPropertyFlags& memFlags,
+	const vk::MemoryPropertyFlags& preferredMemFlags) :
 	m_Device(device)
 {
-	Log::Msg<LogType::ObjectLifetime>(__FUNCSIG__);
+	Log::DeferredMsg<LogType::ObjectLifetime>(__FUNCSIG__);
 
 	m_CreateInfo.setSize(size);
 	m_CreateInfo.setUsage(bufFlags);
@@ -18,21 +19,32 @@ Buffer::Buffer(LogicalDevice& device, vk::DeviceSize size, const vk::BufferUsage
 	m_MemoryReqs = device->getBufferMemoryRequirements(m_Buffer.get());
 
 	m_AllocInfo.setAllocationSize(m_MemoryReqs.size);
-	m_AllocInfo.setMemoryTypeIndex(device.GetData().FindMemoryType(m_MemoryReqs.memoryTypeBits, memFlags));
+	const auto preferredType = device.GetData().TryFindMemoryType(m_MemoryReqs.memoryTypeBits, memFlags | preferredMemFlags);
+	m_AllocInfo.setMemoryTypeIndex(preferredType ? *preferredType : device.GetData().FindMemoryType(m_MemoryReqs.memoryTypeBits, memFlags));
 
 	m_DeviceMemory = device->allocateMemoryUnique(m_AllocInfo);
 
 	device->bindBufferMemory(m_Buffer.get(), m_DeviceMemory.get(), 0);
+
+	// Mapping and unmapping for every write adds up fast for buffers that get
+	// written every frame
+	const auto& memoryType = device.GetData().GetMemoryProperties().memoryTypes[m_AllocInfo.memoryTypeIndex];
+	if (memoryType.propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible)
+		m_MappedData = static_cast<uint8_t*>(device->mapMemory(m_DeviceMemory.get(), 0, VK_WHOLE_SIZE));
 }
 
 Buffer::~Buffer()
 {
+	if (m_MappedData)
+		m_Device->unmapMemory(m_DeviceMemory.get());
+
 	m_Buffer.reset();
 	m_DeviceMemory.reset();
 }
 
 void Buffer::CopyTo(Buffer& buffer) const
 {
+	const auto poolLock = GetDevice().LockCommandPool();
 	vk::UniqueCommandBuffer cmdBuf = GetDevice().AllocCommandBuffer();
 
 	cmdBuf->begin(VulkanHelpers::CBBI_ONE_TIME_SUBMIT);
@@ -44,7 +56,6 @@ void Buffer::CopyTo(Buffer& buffer) const
 
 void Buffer::Write(const void* data, vk::DeviceSize bytes, vk::DeviceSize offset)
 {
-	void* dst = GetDevice()->mapMemory(m_DeviceMemory.get(), offset, bytes);
-	memcpy(dst, data, bytes);
-	GetDevice()->unmapMemory(m_DeviceMemory.get());
+	assert(offset + bytes <= GetSize());
+	memcpy(GetMappedData() + offset, data, bytes);
 }
\ No newline at end of file
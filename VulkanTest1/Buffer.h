@@ -6,7 +6,10 @@ class LogicalDevice;
 class Buffer
 {
 public:
-	Buffer(LogicalDevice& device, vk::DeviceSize size, const vk::BufferUsageFlags& bufFlags, const vk::MemoryPropertyFlags& memFlags);
+	// Memory with preferredMemFlags as well as memFlags is used if there is
+	// any. Host visible buffers stay mapped for as long as they exist.
+	Buffer(LogicalDevice& device, vk::DeviceSize size, const vk::BufferUsageFlags& bufFlags, const vk::MemoryPropertyFlags& memFlags,
+		const vk::MemoryPropertyFlags& preferredMemFlags = {});
 	virtual ~Buffer();
 
 	const LogicalDevice& GetDevice() const { return m_Device; }
@@ -23,6 +26,10 @@ public:
 
 	void Write(const void* data, vk::DeviceSize bytes, vk::DeviceSize offset);
 
+	// Only for host visible buffers. Writes are seen by the device without
+	// any flushing as long as the memory is host coherent.
+	uint8_t* GetMappedData() const { assert(m_MappedData); return m_MappedData; }
+
 private:
 	LogicalDevice& m_Device;
 	vk::BufferCreateInfo m_CreateInfo;
@@ -30,4 +37,5 @@ private:
 	vk::MemoryAllocateInfo m_AllocInfo;
 	vk::UniqueBuffer m_Buffer;
 	vk::UniqueDeviceMemory m_DeviceMemory;
+	uint8_t* m_MappedData = nullptr;
 };
\ No newline at end of file
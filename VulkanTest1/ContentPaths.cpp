@@ -18,3 +18,9 @@ const std::filesystem::path& ContentPaths::Shaders()
 	static const std::filesystem::path s_ShadersFolderPath(std::filesystem::current_path().append("shaders"s));
 	return s_ShadersFolderPath;
 }
+
+const std::filesystem::path& ContentPaths::CookedTextures()
+{
+	static const std::filesystem::path s_CookedTexturesFolderPath(std::filesystem::current_path().append("cooked"s).append("textures"s));
+	return s_CookedTexturesFolderPath;
+}
@@ -7,4 +7,7 @@ public:
 	static const std::filesystem::path& Textures();
 	static const std::filesystem::path& Materials();
 	static const std::filesystem::path& Shaders();
+
+	// Generated from Textures(), safe to delete
+	static const std::filesystem::path& CookedTextures();
 };
\ No newline at end of file
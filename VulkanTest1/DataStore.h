@@ -1,56 +1,262 @@
 #pragma once
+#include "Atom.h"
+#include "AtomicWait.h"
+#include "ThreadPool.h"
 #include "Util.h"
 
-#include <map>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 class LogicalDevice;
 
+enum class ReloadMode
+{
+	// Load every file on the calling thread, one after another.
+	Serial,
+
+	// Load files on ThreadPool::Default(), then add them on the calling thread.
+	Parallel,
+};
+
+// Named elements of one type, loaded all at once by Reload(). Elements are kept
+// in the order they were added, and found through an open addressing hash table
+// that can be searched by string_view or Atom without allocating.
+//
+// Each element is transformed from its StorageType the first time it's needed,
+// exactly once even if several threads want it at the same time. Stores that
+// call EnableAsyncLoading() can also have that done on ThreadPool::Default()
+// through Prefetch() and FindAsync(). Once an element is loaded, getting it
+// again never locks or waits.
 template<class ParentType, class ElementType, class StorageType = ElementType> class DataStore
 {
 public:
 	using DataStoreType = DataStore<ParentType, ElementType, StorageType>;
 
+	// An element's position in the store, valid until the next Reload(). Hot code
+	// can look a name up once with FindHandle() and then use Get() every frame.
+	struct Handle
+	{
+		static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+		bool IsValid() const { return m_Index != INVALID_INDEX; }
+		bool operator==(const Handle& other) const { return m_Index == other.m_Index; }
+		bool operator!=(const Handle& other) const { return m_Index != other.m_Index; }
+
+		uint32_t m_Index = INVALID_INDEX;
+	};
+
+	// What FindAsync() returns. Cheap to copy and to poll every frame, and valid
+	// until the next Reload(), same as a Handle.
+	class AsyncElement
+	{
+	public:
+		AsyncElement() = default;
+
+		// False if there was nothing with that name.
+		bool IsValid() const { return m_Handle.IsValid(); }
+
+		// Once this is true, Get() always returns the element itself.
+		bool IsReady() const { return IsValid() && m_Store->m_Data[m_Handle.m_Index].TryGet(); }
+
+		// The element if it's finished loading, otherwise the store's fallback
+		// (nullptr if it doesn't have one). Never blocks.
+		std::shared_ptr<const ElementType> Get() const;
+
+		// Blocks until the element is loaded, loading it on this thread if no
+		// worker has started on it yet.
+		std::shared_ptr<const ElementType> Wait() const { return IsValid() ? m_Store->Get(m_Handle) : nullptr; }
+
+	private:
+		friend class DataStoreType;
+		AsyncElement(const DataStoreType& store, const Handle& handle, const std::shared_ptr<const ElementType>& fallback) :
+			m_Store(&store), m_Handle(handle), m_Fallback(fallback)
+		{
+		}
+
+		const DataStoreType* m_Store = nullptr;
+		Handle m_Handle;
+		std::shared_ptr<const ElementType> m_Fallback;
+	};
+
 	DataStore(LogicalDevice& device);
 	virtual ~DataStore();
 	static ParentType& Instance();
 
 	virtual void Reload() = 0;
 
-	std::shared_ptr<const ElementType> Find(const std::string& name) const;
-	std::shared_ptr<ElementType> Find(const std::string& name) { return std::const_pointer_cast<ElementType>(std::as_const(*this).Find(name)); }
+	ReloadMode GetReloadMode() const { return m_ReloadMode; }
+	void SetReloadMode(ReloadMode mode) { m_ReloadMode = mode; }
+
+	// Returns an invalid handle if there's nothing with that name. Doesn't log.
+	Handle FindHandle(const std::string_view& name) const { return FindHandle(name, Atom::Hash(name)); }
+	Handle FindHandle(const Atom& name) const { return FindHandle(name, name.GetHash()); }
 
-	auto begin() const { return m_Data.begin(); }
+	std::shared_ptr<const ElementType> Get(const Handle& handle) const { return m_Data.at(handle.m_Index).Get(); }
+	std::shared_ptr<ElementType> Get(const Handle& handle) { return m_Data.at(handle.m_Index).Get(); }
+
+	// Logs (rate limited) and returns nullptr if there's nothing with that name.
+	std::shared_ptr<const ElementType> Find(const std::string_view& name) const { return Find(FindHandle(name), name); }
+	std::shared_ptr<ElementType> Find(const std::string_view& name) { return std::const_pointer_cast<ElementType>(std::as_const(*this).Find(name)); }
+	std::shared_ptr<const ElementType> Find(const Atom& name) const { return Find(FindHandle(name), name.GetView()); }
+	std::shared_ptr<ElementType> Find(const Atom& name) { return std::const_pointer_cast<ElementType>(std::as_const(*this).Find(name)); }
+
+	// Starts transforming the element on ThreadPool::Default() if nothing has yet,
+	// so whoever calls Find() later doesn't have to wait as long. Does nothing
+	// unless the store has called EnableAsyncLoading(). Returns false if there's
+	// nothing with that name, without logging.
+	bool Prefetch(const std::string_view& name) const { return Prefetch(FindHandle(name)); }
+	bool Prefetch(const Atom& name) const { return Prefetch(FindHandle(name)); }
+	bool Prefetch(const Handle& handle) const;
+
+	// Like Find(), but prefetches the element instead of waiting for it. Stores
+	// that haven't called EnableAsyncLoading() load it right away instead, so the
+	// result is always ready.
+	AsyncElement FindAsync(const std::string_view& name) const { return FindAsync(FindHandle(name), name); }
+	AsyncElement FindAsync(const Atom& name) const { return FindAsync(FindHandle(name), name.GetView()); }
+
+	// Blocks until every load started by Prefetch() or FindAsync() has finished.
+	void WaitForAsyncLoads() const;
+
+	// Goes up every time an element finishes loading, so anything showing a
+	// fallback can tell when it's worth checking again.
+	uint32_t GetLoadGeneration() const { return m_LoadGeneration.load(std::memory_order_acquire); }
+
+	size_t size() const { return m_Data.size(); }
+
+	// In the order they were added
+	auto begin() const { return m_Data.cbegin(); }
 	auto begin() { return m_Data.begin(); }
-	auto end() const { return m_Data.end(); }
+	auto end() const { return m_Data.cend(); }
 	auto end() { return m_Data.end(); }
 
 protected:
-	void ClearData() { m_Data.clear(); }
-	void AddPair(const std::string& name, const std::shared_ptr<StorageType>& storage);
+	void ClearData();
+
+	// If something with the same name was already added, the first one wins.
+	void AddPair(const std::string_view& name, const std::shared_ptr<StorageType>& storage);
 	virtual std::shared_ptr<ElementType> Transform(const std::shared_ptr<StorageType>& in) const;
 
+	// Lets Prefetch() and FindAsync() call Transform() on worker threads, so it
+	// has to be safe to call from any thread. Until an element has loaded,
+	// FindAsync() hands out the one named fallbackName instead, which is loaded
+	// right away the first time it's needed.
+	void EnableAsyncLoading(const std::string_view& fallbackName);
+
+	// Every regular file under directory with the given extension, sorted by path.
+	static std::vector<std::filesystem::path> FindFiles(const std::filesystem::path& directory, const std::filesystem::path& extension);
+
+	// Calls load(path) for every file, which returns a std::pair of the name and
+	// the loaded StorageType, and adds the results. Results are always added in
+	// the order of files, so parallel loading picks the same winner as serial
+	// loading if two files end up with the same name.
+	//
+	// With ReloadMode::Parallel, load runs on worker threads. Any other
+	// DataStores it uses must already be loaded, so call their Instance() first.
+	template<class LoadFunc> void AddFiles(const std::vector<std::filesystem::path>& files, const LoadFunc& load);
+
 	LogicalDevice& m_Device;
 
 private:
 	struct Storage
 	{
+		const Atom& GetName() const { return m_Name; }
+
 		std::shared_ptr<const ElementType> Get() const;
 		std::shared_ptr<ElementType> Get() { return std::const_pointer_cast<ElementType>(std::as_const(*this).Get()); }
 
+		// nullptr if it hasn't finished loading yet. Never loads anything itself.
+		std::shared_ptr<const ElementType> TryGet() const { return IsLoaded() ? m_Cached : nullptr; }
+		std::shared_ptr<ElementType> TryGet() { return IsLoaded() ? m_Cached : nullptr; }
+
+		// Only ever moved while the store is being filled in, before any other
+		// thread can see it
+		Storage(Storage&& other) noexcept :
+			m_Name(other.m_Name),
+			m_Cached(std::move(other.m_Cached)),
+			m_Storage(std::move(other.m_Storage)),
+			m_LoadState(other.m_LoadState.load(std::memory_order_relaxed))
+		{
+		}
+
 	protected:
-		Storage(const std::shared_ptr<StorageType>& storage) : m_Storage(storage) { }
+		Storage(const Atom& name, const std::shared_ptr<StorageType>& storage) : m_Name(name), m_Storage(storage) { }
 		friend class DataStoreType;
 
 	private:
+		enum class LoadState : uint8_t
+		{
+			NotLoaded,
+			Queued,		// Prefetch()ed, but no worker has started on it
+			Loading,	// Whoever set this is the only one who may write m_Cached
+			Loaded,		// m_Cached won't change again
+			Failed,		// A worker tried and failed, Find() will still try again
+		};
+
+		bool IsLoaded() const { return m_LoadState.load(std::memory_order_acquire) == LoadState::Loaded; }
+
+		Atom m_Name;
+
+		// Written once, by whoever moved m_LoadState to Loading, and published to
+		// everyone else by it becoming Loaded
 		mutable std::shared_ptr<ElementType> m_Cached;
 		std::shared_ptr<StorageType> m_Storage;
+
+		// Changes are announced with AtomicWait::NotifyAll()
+		mutable std::atomic<LoadState> m_LoadState = LoadState::NotLoaded;
 	};
 
-	std::map<std::string, Storage> m_Data;
+	// Index into m_Data, alongside the name's hash so most mismatches never
+	// have to touch m_Data at all
+	struct Slot
+	{
+		uint32_t m_Hash;
+		uint32_t m_Index = Handle::INVALID_INDEX;
+	};
+
+	// KeyT is std::string_view or Atom
+	template<class KeyT> Handle FindHandle(const KeyT& name, uint32_t hash) const;
+	void InsertSlot(uint32_t index, uint32_t hash);
+
+	std::shared_ptr<const ElementType> Find(const Handle& handle, const std::string_view& name) const;
+	AsyncElement FindAsync(const Handle& handle, const std::string_view& name) const;
+
+	// Moves storage to LoadState::Loading if it isn't loaded or being loaded.
+	// Returns false without changing anything if it is.
+	static bool TryClaim(const Storage& storage, typename Storage::LoadState expected);
+	void FinishLoad(const Storage& storage, std::shared_ptr<ElementType>&& loaded, typename Storage::LoadState state) const;
+
+	std::shared_ptr<const ElementType> Load(const Storage& storage) const;
+	void LoadAsync(uint32_t index) const;
+
+	void Init();
+
+	// Kept out of Find(), which is usually called every frame, since misses are rare
+	void LogMissing(const std::string_view& name) const;
+
+	std::vector<Storage> m_Data;
+	std::vector<Slot> m_Slots;			// Size is a power of 2, at most half full
+
+	// Queued by Prefetch() and not yet finished. Changes are announced with
+	// AtomicWait::NotifyAll() when it reaches zero.
+	mutable std::atomic<size_t> m_PendingAsyncLoads = 0;
+	mutable std::atomic<uint32_t> m_LoadGeneration = 0;
+
+	bool m_AsyncLoading = false;
+	Atom m_FallbackName;
+
+	ReloadMode m_ReloadMode = ReloadMode::Parallel;
+
+	// The first Reload(), from whichever thread calls Instance() first
+	std::once_flag m_InitOnce;
+	std::atomic<bool> m_Init = false;
 
-	bool m_Init;
 	static ParentType* s_Instance;
 };
 
@@ -60,7 +266,6 @@ template<class ParentType, class ElementType, class StorageType>
 inline DataStore<ParentType, ElementType, StorageType>::DataStore(LogicalDevice& device) :
 	m_Device(device)
 {
-	m_Init = false;
 	assert(!s_Instance);
 	s_Instance = static_cast<ParentType*>(this);
 }
@@ -68,6 +273,8 @@ inline DataStore<ParentType, ElementType, StorageType>::DataStore(LogicalDevice&
 template<class ParentType, class ElementType, class StorageType>
 inline DataStore<ParentType, ElementType, StorageType>::~DataStore()
 {
+	WaitForAsyncLoads();
+
 	assert(s_Instance == static_cast<ParentType*>(this));
 	s_Instance = nullptr;
 }
@@ -78,44 +285,330 @@ inline ParentType& DataStore<ParentType, ElementType, StorageType>::Instance()
 	if (!s_Instance)
 		throw std::runtime_error(StringTools::CSFormat("Attempted to call " __FUNCSIG__ " before the {0} instance was constructed!", typeid(ParentType).name()));
 
-	if (!s_Instance->m_Init)
-	{
-		s_Instance->Reload();
-		s_Instance->m_Init = true;
-	}
+	if (!s_Instance->m_Init.load(std::memory_order_acquire))
+		s_Instance->Init();
 
 	return *s_Instance;
 }
 
+template<class ParentType, class ElementType, class StorageType>
+__declspec(noinline) void DataStore<ParentType, ElementType, StorageType>::Init()
+{
+	// Anyone else calling Instance() in the meantime waits here for us to
+	// finish. If Reload() throws, the next call tries again.
+	std::call_once(m_InitOnce, [this]()
+	{
+		Reload();
+		m_Init.store(true, std::memory_order_release);
+	});
+}
+
 template<class ParentType, class ElementType, class StorageType>
 inline std::shared_ptr<ElementType> DataStore<ParentType, ElementType, StorageType>::Transform(const std::shared_ptr<StorageType>& in) const
 {
 	assert(typeid(ElementType) == typeid(StorageType));
-	return reinterpret_pointer_cast<ElementType>(in);
+
+	// Instantiated for every store, including ones with a const StorageType and
+	// a Transform() of their own
+	return reinterpret_pointer_cast<ElementType>(std::const_pointer_cast<std::remove_const_t<StorageType>>(in));
+}
+
+template<class ParentType, class ElementType, class StorageType>
+inline void DataStore<ParentType, ElementType, StorageType>::EnableAsyncLoading(const std::string_view& fallbackName)
+{
+	m_AsyncLoading = true;
+	m_FallbackName = Atom(fallbackName);
 }
 
 template<class ParentType, class ElementType, class StorageType>
-inline std::shared_ptr<const ElementType> DataStore<ParentType, ElementType, StorageType>::Find(const std::string& name) const
+inline std::shared_ptr<const ElementType> DataStore<ParentType, ElementType, StorageType>::Find(const Handle& handle, const std::string_view& name) const
 {
-	auto found = m_Data.find(name);
-	if (found != m_Data.end())
-		return found->second.Get();
+	if (handle.IsValid())
+		return m_Data[handle.m_Index].Get();
 
-	Log::Msg(__FUNCTION__ ": Unable to find a {0} named \"{1}\"", typeid(ElementType).name(), name);
+	LogMissing(name);
 	return nullptr;
 }
 
 template<class ParentType, class ElementType, class StorageType>
-inline void DataStore<ParentType, ElementType, StorageType>::AddPair(const std::string& name, const std::shared_ptr<StorageType>& storage)
+inline auto DataStore<ParentType, ElementType, StorageType>::FindAsync(const Handle& handle, const std::string_view& name) const -> AsyncElement
+{
+	if (!handle.IsValid())
+	{
+		LogMissing(name);
+		return AsyncElement();
+	}
+
+	if (!m_AsyncLoading)
+		return AsyncElement(*this, handle, m_Data[handle.m_Index].Get());
+
+	Prefetch(handle);
+
+	std::shared_ptr<const ElementType> fallback;
+	if (!m_Data[handle.m_Index].TryGet())
+		fallback = Find(m_FallbackName);
+
+	return AsyncElement(*this, handle, fallback);
+}
+
+template<class ParentType, class ElementType, class StorageType>
+inline std::shared_ptr<const ElementType> DataStore<ParentType, ElementType, StorageType>::AsyncElement::Get() const
+{
+	if (!IsValid())
+		return nullptr;
+
+	if (auto loaded = m_Store->m_Data[m_Handle.m_Index].TryGet())
+		return loaded;
+
+	return m_Fallback;
+}
+
+template<class ParentType, class ElementType, class StorageType>
+inline bool DataStore<ParentType, ElementType, StorageType>::Prefetch(const Handle& handle) const
+{
+	if (!handle.IsValid())
+		return false;
+
+	if (!m_AsyncLoading)
+		return true;
+
+	// Counted first, so WaitForAsyncLoads() can't miss it between being queued and counted
+	m_PendingAsyncLoads.fetch_add(1, std::memory_order_relaxed);
+
+	auto expected = Storage::LoadState::NotLoaded;
+	if (!m_Data[handle.m_Index].m_LoadState.compare_exchange_strong(expected, Storage::LoadState::Queued, std::memory_order_relaxed))
+	{
+		// Someone else already got to it
+		if (m_PendingAsyncLoads.fetch_sub(1, std::memory_order_release) == 1)
+			AtomicWait::NotifyAll(&m_PendingAsyncLoads);
+
+		return true;
+	}
+
+	const uint32_t index = handle.m_Index;
+	ThreadPool::Default().Submit([this, index]() { LoadAsync(index); });
+	return true;
+}
+
+template<class ParentType, class ElementType, class StorageType>
+inline bool DataStore<ParentType, ElementType, StorageType>::TryClaim(const Storage& storage, typename Storage::LoadState expected)
+{
+	return storage.m_LoadState.compare_exchange_strong(expected, Storage::LoadState::Loading, std::memory_order_acquire, std::memory_order_relaxed);
+}
+
+template<class ParentType, class ElementType, class StorageType>
+inline void DataStore<ParentType, ElementType, StorageType>::FinishLoad(const Storage& storage, std::shared_ptr<ElementType>&& loaded, typename Storage::LoadState state) const
+{
+	if (state == Storage::LoadState::Loaded)
+		storage.m_Cached = std::move(loaded);
+
+	storage.m_LoadState.store(state, std::memory_order_release);
+	AtomicWait::NotifyAll(&storage.m_LoadState);
+
+	if (state == Storage::LoadState::Loaded)
+		m_LoadGeneration.fetch_add(1, std::memory_order_release);
+}
+
+template<class ParentType, class ElementType, class StorageType>
+inline void DataStore<ParentType, ElementType, StorageType>::LoadAsync(uint32_t index) const
+{
+	const Storage& storage = m_Data[index];
+
+	// If it's not still queued, someone called Find() first and loaded it themselves
+	if (TryClaim(storage, Storage::LoadState::Queued))
+	{
+		try
+		{
+			FinishLoad(storage, Transform(storage.m_Storage), Storage::LoadState::Loaded);
+		}
+		catch (const std::exception& e)
+		{
+			Log::Msg(__FUNCTION__ ": Failed to load {0} \"{1}\": {2}", typeid(ElementType).name(), storage.GetName(), e.what());
+			FinishLoad(storage, nullptr, Storage::LoadState::Failed);
+		}
+	}
+
+	if (m_PendingAsyncLoads.fetch_sub(1, std::memory_order_release) == 1)
+		AtomicWait::NotifyAll(&m_PendingAsyncLoads);
+}
+
+template<class ParentType, class ElementType, class StorageType>
+inline std::shared_ptr<const ElementType> DataStore<ParentType, ElementType, StorageType>::Load(const Storage& storage) const
+{
+	for (;;)
+	{
+		const auto state = storage.m_LoadState.load(std::memory_order_acquire);
+		if (state == Storage::LoadState::Loaded)
+			return storage.m_Cached;
+
+		if (state == Storage::LoadState::Loading)
+		{
+			AtomicWait::Wait(storage.m_LoadState, state);
+			continue;
+		}
+
+		// Queued ones are taken over rather than waited for, since the worker that
+		// would load them might be stuck behind us
+		if (TryClaim(storage, state))
+			break;
+	}
+
+	std::shared_ptr<ElementType> loaded;
+	try
+	{
+		loaded = Transform(storage.m_Storage);
+	}
+	catch (...)
+	{
+		FinishLoad(storage, nullptr, Storage::LoadState::NotLoaded);
+		throw;
+	}
+
+	std::shared_ptr<const ElementType> retVal = loaded;
+	FinishLoad(storage, std::move(loaded), Storage::LoadState::Loaded);
+	return retVal;
+}
+
+template<class ParentType, class ElementType, class StorageType>
+inline void DataStore<ParentType, ElementType, StorageType>::WaitForAsyncLoads() const
+{
+	size_t pending;
+	while ((pending = m_PendingAsyncLoads.load(std::memory_order_acquire)) != 0)
+		AtomicWait::Wait(m_PendingAsyncLoads, pending);
+}
+
+template<class ParentType, class ElementType, class StorageType>
+__declspec(noinline) void DataStore<ParentType, ElementType, StorageType>::LogMissing(const std::string_view& name) const
+{
+	// Usually looked up every frame, once is plenty
+	static Log::RateLimit s_MissLimit(5, std::chrono::seconds(1));
+	Log::Msg(s_MissLimit, __FUNCTION__ ": Unable to find a {0} named \"{1}\"", typeid(ElementType).name(), name);
+}
+
+template<class ParentType, class ElementType, class StorageType>
+template<class KeyT>
+inline auto DataStore<ParentType, ElementType, StorageType>::FindHandle(const KeyT& name, uint32_t hash) const -> Handle
+{
+	if (m_Slots.empty())
+		return Handle();
+
+	const size_t mask = m_Slots.size() - 1;
+	for (size_t i = hash & mask; m_Slots[i].m_Index != Handle::INVALID_INDEX; i = (i + 1) & mask)
+	{
+		const Slot& slot = m_Slots[i];
+		if (slot.m_Hash != hash)
+			continue;
+
+		const Atom& slotName = m_Data[slot.m_Index].GetName();
+		if constexpr (std::is_same_v<KeyT, Atom>)
+		{
+			if (slotName == name)
+				return Handle{ slot.m_Index };
+		}
+		else if (slotName.GetView() == name)
+			return Handle{ slot.m_Index };
+	}
+
+	return Handle();
+}
+
+template<class ParentType, class ElementType, class StorageType>
+inline void DataStore<ParentType, ElementType, StorageType>::ClearData()
+{
+	// Workers hold on to indices into m_Data
+	WaitForAsyncLoads();
+
+	m_Data.clear();
+	m_Slots.clear();
+}
+
+template<class ParentType, class ElementType, class StorageType>
+inline void DataStore<ParentType, ElementType, StorageType>::AddPair(const std::string_view& name, const std::shared_ptr<StorageType>& storage)
+{
+	const uint32_t hash = Atom::Hash(name);
+	if (FindHandle(name, hash).IsValid())
+		return;
+
+	if (m_Data.size() >= Handle::INVALID_INDEX)
+		throw std::length_error(StringTools::CSFormat("Too many elements in {0}", typeid(ParentType).name()));
+
+	const uint32_t index = uint32_t(m_Data.size());
+	m_Data.push_back(Storage(Atom(name), storage));
+
+	if (m_Data.size() * 2 > m_Slots.size())
+	{
+		// Rebuild at double the size, which picks up the new element too
+		m_Slots.assign(std::max<size_t>(m_Slots.size() * 2, 16), Slot());
+		for (uint32_t i = 0; i < m_Data.size(); i++)
+			InsertSlot(i, m_Data[i].GetName().GetHash());
+	}
+	else
+		InsertSlot(index, hash);
+}
+
+template<class ParentType, class ElementType, class StorageType>
+inline void DataStore<ParentType, ElementType, StorageType>::InsertSlot(uint32_t index, uint32_t hash)
+{
+	const size_t mask = m_Slots.size() - 1;
+	size_t i = hash & mask;
+	while (m_Slots[i].m_Index != Handle::INVALID_INDEX)
+		i = (i + 1) & mask;
+
+	m_Slots[i] = Slot{ hash, index };
+}
+
+template<class ParentType, class ElementType, class StorageType>
+inline std::vector<std::filesystem::path> DataStore<ParentType, ElementType, StorageType>::FindFiles(const std::filesystem::path& directory, const std::filesystem::path& extension)
+{
+	std::vector<std::filesystem::path> retVal;
+
+	for (auto& item : std::filesystem::recursive_directory_iterator(directory))
+	{
+		const auto& type = item.status().type();
+		if (type != std::filesystem::file_type::regular)
+			continue;
+
+		const auto& path = item.path();
+		if (!path.has_extension() || path.extension() != extension)
+			continue;
+
+		retVal.push_back(path);
+	}
+
+	// Directory iteration order is up to the filesystem
+	std::sort(retVal.begin(), retVal.end());
+	return retVal;
+}
+
+template<class ParentType, class ElementType, class StorageType>
+template<class LoadFunc>
+inline void DataStore<ParentType, ElementType, StorageType>::AddFiles(const std::vector<std::filesystem::path>& files, const LoadFunc& load)
 {
-	m_Data.insert(std::make_pair(name, Storage(storage)));
+	if (m_ReloadMode == ReloadMode::Serial)
+	{
+		for (const auto& file : files)
+		{
+			const auto loaded = load(file);
+			AddPair(loaded.first, loaded.second);
+		}
+
+		return;
+	}
+
+	std::vector<std::pair<std::string, std::shared_ptr<StorageType>>> loaded(files.size());
+	ThreadPool::Default().ParallelFor(files.size(), [&](size_t i) { loaded[i] = load(files[i]); });
+
+	for (const auto& pair : loaded)
+		AddPair(pair.first, pair.second);
 }
 
 template<class ParentType, class ElementType, class StorageType>
 inline std::shared_ptr<const ElementType> DataStore<ParentType, ElementType, StorageType>::Storage::Get() const
 {
-	if (!m_Cached)
-		m_Cached = ((DataStoreType*)&Instance())->Transform(m_Storage);
+	if (IsLoaded())
+		return m_Cached;
 
-	return m_Cached;
+	// Whoever has a Storage already got at it through Instance()
+	const auto& store = *(const DataStoreType*)s_Instance;
+	return store.Load(*this);
 }
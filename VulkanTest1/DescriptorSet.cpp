@@ -14,7 +14,7 @@ DescriptorSet::DescriptorSet(LogicalDevice& device, const std::shared_ptr<const
 	m_Device(device),
 	m_CreateInfo(createInfo)
 {
-	Log::Msg<LogType::ObjectLifetime>(__FUNCSIG__);
+	Log::DeferredMsg<LogType::ObjectLifetime>(__FUNCSIG__);
 
 	if (!m_CreateInfo)
 		throw std::invalid_argument("createInfo == nullptr");
@@ -22,6 +22,12 @@ DescriptorSet::DescriptorSet(LogicalDevice& device, const std::shared_ptr<const
 	CreateDescriptorSet();
 }
 
+DescriptorSet::~DescriptorSet()
+{
+	const auto poolLock = GetDevice().LockDescriptorPool();
+	m_DescriptorSet.reset();
+}
+
 void DescriptorSet::Bind(uint32_t setID, const vk::CommandBuffer& cmdBuf, const GraphicsPipeline& pipeline) const
 {
 	auto sets = make_array<vk::DescriptorSet>(m_DescriptorSet.get());
@@ -38,7 +44,10 @@ void DescriptorSet::CreateDescriptorSet()
 	allocInfo.setDescriptorSetCount(layouts.size());
 	allocInfo.setPSetLayouts(layouts.data());
 
-	m_DescriptorSet = std::move(GetDevice()->allocateDescriptorSetsUnique(allocInfo).front());
+	{
+		const auto poolLock = GetDevice().LockDescriptorPool();
+		m_DescriptorSet = std::move(GetDevice()->allocateDescriptorSetsUnique(allocInfo).front());
+	}
 
 	const auto& bindings = m_CreateInfo->m_Layout->GetCreateInfo()->m_Bindings;
 	std::vector<vk::WriteDescriptorSet> descriptorWrites;
@@ -8,6 +8,7 @@ class DescriptorSet
 {
 public:
 	DescriptorSet(LogicalDevice& device, const std::shared_ptr<const DescriptorSetCreateInfo>& createInfo);
+	~DescriptorSet();
 
 	const DescriptorSetCreateInfo& GetCreateInfo() const { return *m_CreateInfo; }
 
@@ -5,7 +5,8 @@ std::ostream& operator<<(std::ostream& lhs, DeviceFeature rhs)
 {
 	switch (rhs)
 	{
-	case DeviceFeature::SamplerAnisotropy:	return lhs << "DeviceFeature::SamplerAnisotropy";
+	case DeviceFeature::SamplerAnisotropy:		return lhs << "DeviceFeature::SamplerAnisotropy";
+	case DeviceFeature::TextureCompressionBC:	return lhs << "DeviceFeature::TextureCompressionBC";
 	}
 
 	assert(!false);
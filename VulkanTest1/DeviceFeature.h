@@ -3,10 +3,11 @@
 
 enum class DeviceFeature
 {
-	SamplerAnisotropy
+	SamplerAnisotropy,
+	TextureCompressionBC,
 };
 
 template<> __forceinline constexpr auto Enums::min<DeviceFeature>() { return Enums::value(DeviceFeature::SamplerAnisotropy); }
-template<> __forceinline constexpr auto Enums::max<DeviceFeature>() { return Enums::value(DeviceFeature::SamplerAnisotropy); }
+template<> __forceinline constexpr auto Enums::max<DeviceFeature>() { return Enums::value(DeviceFeature::TextureCompressionBC); }
 
 extern std::ostream& operator<<(std::ostream& lhs, DeviceFeature rhs);
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "DescriptorSet.h"
 #include "IDrawable.h"
 #include "Material.h"
+#include "MaterialManager.h"
 #include "Mesh.h"
 #include "Transform.h"
 #include "UniformBuffer.h"
@@ -15,13 +16,14 @@ public:
 	virtual void Draw(const vk::CommandBuffer& cmdBuf) const override;
 
 	virtual const Transform& GetTransform() const override { return m_Transform; }
-	virtual const Material& GetMaterial() const override { assert(m_Material); return *m_Material; }
+	// The fallback material until m_Material has finished loading
+	virtual const Material& GetMaterial() const override { const auto material = m_Material.Get(); assert(material); return *material; }
 	virtual const Mesh& GetMesh() const override { assert(m_Mesh); return *m_Mesh; }
 
 protected:
 	LogicalDevice& m_Device;
 	Transform m_Transform;
-	std::shared_ptr<Material> m_Material;
+	MaterialManager::AsyncElement m_Material;
 	std::shared_ptr<Mesh> m_Mesh;
 
 private:
@@ -16,7 +16,7 @@
 GraphicsPipeline::GraphicsPipeline(LogicalDevice& device, const std::shared_ptr<const GraphicsPipelineCreateInfo>& createInfo) :
 	m_Device(device), m_CreateInfo(createInfo)
 {
-	Log::Msg<LogType::ObjectLifetime>(__FUNCSIG__);
+	Log::DeferredMsg<LogType::ObjectLifetime>(__FUNCSIG__);
 
 	if (!m_CreateInfo->m_ShaderGroup)
 		throw std::invalid_argument("Attempted to create a GraphicsPipeline object with a GraphicsPipelineCreateInfo that did not have a ShaderGroup set.");
@@ -0,0 +1,16 @@
+#pragma once
+#include <string_view>
+
+// Destination for finished log text. Sinks are only ever called by one thread
+// at a time, so they don't need any locking of their own. They must not log.
+class ILogSink
+{
+public:
+	virtual ~ILogSink() = default;
+
+	// text is one or more complete UTF-8 records, each ending in a newline.
+	virtual void Write(const std::string_view& text) = 0;
+
+	// Called once a batch of writes has been handed over, and before shutdown.
+	virtual void Flush() { }
+};
@@ -0,0 +1,54 @@
+#include "stdafx.h"
+#include "ImageDecoder.h"
+
+#include "MemoryMappedFile.h"
+
+#include "stb_image.h"
+
+#include <memory>
+
+void ImageDecoder::ReadSize(const std::filesystem::path& path, uint32_t& width, uint32_t& height)
+{
+	int x, y, channels;
+	if (!stbi_info(path.string().c_str(), &x, &y, &channels) || x <= 0 || y <= 0)
+		throw std::runtime_error(StringTools::CSFormat("{0}: Failed to read the size of {1}", __FUNCTION__, path.string()));
+
+	width = uint32_t(x);
+	height = uint32_t(y);
+}
+
+void ImageDecoder::Decode(const std::filesystem::path& path, uint8_t* dst, uint32_t width, uint32_t height)
+{
+	// stb decodes straight out of the page cache
+	const MemoryMappedFile file(path);
+
+	// stb's own vertical flip is a global setting and a whole extra pass over
+	// the image, so rows are flipped as they're copied out instead
+	int imgWidth, imgHeight, imgChannels;
+	std::unique_ptr<stbi_uc, decltype(&stbi_image_free)> img(
+		stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(file.data()), int(file.size()), &imgWidth, &imgHeight, &imgChannels, 4), &stbi_image_free);
+
+	// No stbi_failure_reason(), this stb_image keeps it in a global that other
+	// threads' decodes overwrite
+	if (!img)
+		throw std::runtime_error(StringTools::CSFormat("{0}: Failed to decode {1}", __FUNCTION__, path.string()));
+
+	const size_t dstStride = size_t(width) * 4;
+	const size_t imgStride = size_t(imgWidth) * 4;
+	const size_t copyStride = std::min(dstStride, imgStride);
+	const uint32_t copyHeight = std::min<uint32_t>(height, imgHeight);
+
+	for (uint32_t y = 0; y < height; y++)
+	{
+		uint8_t* const dstRow = dst + dstStride * y;
+		if (y >= copyHeight)
+		{
+			memset(dstRow, 0, dstStride);
+			continue;
+		}
+
+		memcpy(dstRow, img.get() + imgStride * (imgHeight - 1 - y), copyStride);
+		if (copyStride < dstStride)
+			memset(dstRow + copyStride, 0, dstStride - copyStride);
+	}
+}
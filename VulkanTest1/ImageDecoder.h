@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+
+// Decodes anything stb_image can read to tightly packed RGBA8, bottom row
+// first like everything else that gets uploaded to a texture.
+class ImageDecoder final
+{
+public:
+	ImageDecoder() = delete;
+	ImageDecoder(const ImageDecoder& other) = delete;
+	ImageDecoder(ImageDecoder&& other) = delete;
+	~ImageDecoder() = delete;
+
+	// Only reads as far as the header.
+	static void ReadSize(const std::filesystem::path& path, uint32_t& width, uint32_t& height);
+
+	// Writes a width x height image to dst, which may be mapped device memory:
+	// every byte is written exactly once and nothing is read back. Images of
+	// a different size are cropped, or padded with transparent black.
+	static void Decode(const std::filesystem::path& path, uint8_t* dst, uint32_t width, uint32_t height);
+};
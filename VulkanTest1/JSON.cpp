@@ -2,6 +2,9 @@
 #include "JSON.h"
 
 #include "Enums.h"
+#include "JSONDocument.h"
+#include "JSONTape.h"
+#include "JSONWriter.h"
 
 #include <fstream>
 
@@ -14,222 +17,176 @@ JSONValue JSONSerializer::FromFile(const std::filesystem::path& path)
 	str.resize(length);
 	stream.seekg(0);
 	stream.read(str.data(), length);
+	JSONStructuralIndex::ValidateUTF8(str);
 	return FromString(str);
 }
 
 JSONValue JSONSerializer::FromString(const std::string& str)
 {
-	const char* pStr = str.c_str();
+	const JSONStructuralIndex index(str);
+	JSONStructuralIndex::Cursor cursor(index);
 
-	if (pStr[0] == ESCAPE_CHAR)
-		throw json_parsing_error(StringTools::CSFormat("String begins with ESCAPE_CHAR ({0})", ESCAPE_CHAR));
+	JSONValue retVal = GatherValue(cursor, 0);
 
-	while (isspace(*pStr))
-		pStr++;
+	if (!cursor.AtEnd())
+		cursor.Error("Unexpected data after the root value");
 
-	if (*pStr == '{')
-		return JSONValue(GatherObject(&pStr));
-	else if (*pStr == '[')
-		return JSONValue(GatherArray(&pStr));
-	else if (*pStr == '"')
-		return GatherValue(&pStr);
-	else
-		throw json_parsing_error(StringTools::CSFormat("Encountered unknown character '{0}'", *pStr));
+	return retVal;
+}
+
+JSONDocument JSONSerializer::FromFileInSitu(const std::filesystem::path& path)
+{
+	MemoryMappedFile file(path);
+	JSONStructuralIndex::ValidateUTF8(file.GetView());
+	return JSONDocument(std::move(file));
 }
 
-bool JSONSerializer::IsEscaped(const char* input)
+JSONDocument JSONSerializer::FromStringInSitu(const std::string_view& str)
 {
-	// This will overrun if the string begins with an escape char, but we explicitly check for
-	// that case in JsonSerializer::FromString.
-	size_t escapeCharCount = 0;
-	while (*(--input) == ESCAPE_CHAR)
-		escapeCharCount++;
+	return JSONDocument(str);
+}
 
-	return (escapeCharCount % 2) == 1;
+JSONTapeDocument JSONSerializer::FromFileTape(const std::filesystem::path& path)
+{
+	// The tape doesn't reference the source, so the mapping can go as soon as it's built
+	const MemoryMappedFile file(path);
+	JSONStructuralIndex::ValidateUTF8(file.GetView());
+	return JSONTapeDocument(file.GetView());
 }
 
-bool JSONSerializer::IsNumber(char input)
+JSONTapeDocument JSONSerializer::FromStringTape(const std::string_view& str)
 {
-	assert(input != '\0');
-	return isdigit(input) || input == '+' || input == '-' || input == '.';
+	return JSONTapeDocument(str);
 }
 
-void JSONSerializer::EatWhitespace(const char** input)
+std::string JSONSerializer::ToString(const JSONValue& value, bool minified)
 {
-	while (isspace(**input))
-		(*input)++;
+	JSONWriter writer(minified);
+	writer.Value(value);
+	return writer.GetString();
 }
 
-JSONObject JSONSerializer::GatherObject(const char** input)
+void JSONSerializer::ToFile(const std::filesystem::path& path, const JSONValue& value, bool minified)
 {
-	assert(**input == '{');
-	(*input)++;
+	JSONWriter writer(minified);
+	writer.Value(value);
+
+	const std::string& str = writer.GetString();
+	std::ofstream stream(path.string(), std::ios::binary | std::ios::trunc);
+	if (!stream.write(str.data(), str.size()))
+		throw std::runtime_error(StringTools::CSFormat("Failed to write JSON to \"{0}\"", path.string()));
+}
+
+JSONObject JSONSerializer::GatherObject(JSONStructuralIndex::Cursor& cursor, size_t depth)
+{
+	assert(cursor.Peek() == '{');
+	cursor.Advance();
 
 	JSONObject retVal;
+	if (cursor.Peek() == '}')
+	{
+		cursor.Advance();
+		return retVal;
+	}
 
-	std::string nameBuf;
-	while (**input != '\0')
+	while (true)
 	{
-		EatWhitespace(input);
+		retVal.insert(GatherNamedValue(cursor, depth));
 
-		if (**input == '"')
-			retVal.insert(GatherNamedValue(input));
-		//else if (IsNumber(**input))
-		//	JSONAddValue(objOut, GatherNumber(input));
-		else if (**input == '}')
+		if (cursor.Peek() == ',')
+			cursor.Advance();
+		else if (cursor.Peek() == '}')
 		{
-			(*input)++;
-			if (**input == ',')
-				(*input)++;
-
+			cursor.Advance();
 			break;
 		}
 		else
-			throw json_parsing_error(StringTools::CSFormat("Malformed JSON file! Expected '\"' or '}', but encountered '{0}'.", **input));
+			cursor.Error("Malformed JSON file! Expected ',' or '}'");
 	}
+
 	return retVal;
 }
 
-JSONArray JSONSerializer::GatherArray(const char ** input)
+JSONArray JSONSerializer::GatherArray(JSONStructuralIndex::Cursor& cursor, size_t depth)
 {
-	assert(**input == '[');
-	(*input)++;
+	assert(cursor.Peek() == '[');
+	cursor.Advance();
 
 	JSONArray retVal;
-	while (**input != '\0')
+	if (cursor.Peek() == ']')
 	{
-		EatWhitespace(input);
-
-		if (**input == '"')
-			retVal.push_back(GatherValue(input));
-		else if (**input == '{')
-			retVal.push_back(JSONValue(GatherObject(input)));
-		else if (**input == '[')
-			retVal.push_back(JSONValue(GatherArray(input)));
-		else if (IsNumber(**input))
-			retVal.push_back(JSONValue(GatherNumber(input)));
-		else if (**input == ']')
-		{
-			(*input)++;
-			if (**input == ',')
-				(*input)++;
+		cursor.Advance();
+		return retVal;
+	}
 
+	while (true)
+	{
+		retVal.push_back(GatherValue(cursor, depth));
+
+		if (cursor.Peek() == ',')
+			cursor.Advance();
+		else if (cursor.Peek() == ']')
+		{
+			cursor.Advance();
 			break;
 		}
 		else
-			throw json_parsing_error(StringTools::CSFormat("Malformed JSON file"));
+			cursor.Error("Malformed JSON file! Expected ',' or ']'");
 	}
 
-	return retVal;;
+	return retVal;
 }
 
-JSONValue JSONSerializer::GatherValue(const char** input)
+JSONValue JSONSerializer::GatherValue(JSONStructuralIndex::Cursor& cursor, size_t depth)
 {
-	JSONValue retVal;
+	if (depth >= MAX_DEPTH)
+		cursor.Error("Maximum nesting depth exceeded");
 
-	EatWhitespace(input);
-
-	if (**input == '"')
-		retVal.Set(GatherString(input));
-	else if (**input == '{')
-		retVal.Set(GatherObject(input));
-	else if (**input == '[')
-		retVal.Set(GatherArray(input));
-	else if (IsNumber(**input))
-		retVal.Set(GatherNumber(input));
-	else if (!strncmp(*input, "true", 4) || !strncmp(*input, "false", 5))
+	switch (cursor.Peek())
 	{
-		if (**input == 't')
-		{
-			retVal.Set(true);
-			(*input) += 4;	// "true"
-		}
-		else
-		{
-			retVal.Set(false);
-			(*input) += 5;	// "false"
-		}
+	case '"':	return JSONValue(GatherString(cursor));
+	case '{':	return JSONValue(GatherObject(cursor, depth + 1));
+	case '[':	return JSONValue(GatherArray(cursor, depth + 1));
+
+	case '}':
+	case ']':
+	case ',':
+	case ':':
+	case '\0':
+		cursor.Error("Malformed JSON file! Expected a value");
 	}
-	else
-		throw json_parsing_error("Malformed JSON file");
 
-	if (**input == ',')
-		(*input)++;
+	const auto scalar = cursor.GatherScalar();
+	if (scalar == "true"sv)
+		return JSONValue(true);
+	else if (scalar == "false"sv)
+		return JSONValue(false);
+	else if (scalar == "null"sv)
+		return JSONValue(nullptr);
 
-	return retVal;
+	return JSONValue(JSONStructuralIndex::ParseNumber(scalar));
 }
 
-double JSONSerializer::GatherNumber(const char** input)
+std::string JSONSerializer::GatherString(JSONStructuralIndex::Cursor& cursor)
 {
-	char* endPtr;
-	const double retVal = strtod(*input, &endPtr);
-	assert(endPtr > *input);
-	*input = endPtr;
-
-	if (**input == ',')
-		(*input)++;
-
-	return retVal;
+	bool hasEscapes;
+	const auto raw = cursor.GatherString(&hasEscapes);
+	return hasEscapes ? JSONViewString::Decode(raw) : std::string(raw);
 }
 
-std::string JSONSerializer::GatherString(const char** input)
+std::pair<std::string, JSONValue> JSONSerializer::GatherNamedValue(JSONStructuralIndex::Cursor& cursor, size_t depth)
 {
-	assert(**input == '"');
-	(*input)++;
-
-	std::stringstream retVal;
-	bool nonSlashGathered = false;
-
-	while ((**input != '"' || IsEscaped(*input)) && **input != '\0')
-	{
-		const bool escaped = IsEscaped(*input);
-		char c = **input;
-		if (c != ESCAPE_CHAR || escaped)
-		{
-			if (c != ESCAPE_CHAR)
-				nonSlashGathered = true;
-			if (escaped && c == 'n')
-				c = '\n';
-
-			retVal << c;
-		}
+	if (cursor.Peek() != '"')
+		cursor.Error("Malformed JSON file! Expected '\"'");
 
-#if 0
-		if (charsGathered > 0 && nonSlashGathered && IsEscaped(output))
-		{
-			charsGathered--;
-			maxLength--;
-			output--;
-
-			// Escaped control characters
-			if (c == 'n')
-				*output = '\n';
-			else
-				continue;
-		}
-#endif
+	auto name = GatherString(cursor);
 
-		(*input)++;
-	}
-
-	// Closing quote
-	assert(**input == '"');
-	(*input)++;
-
-	return retVal.str();
-}
-
-std::pair<std::string, JSONValue> JSONSerializer::GatherNamedValue(const char** input)
-{
-	assert(**input == '"');
-	auto name = GatherString(input);
+	if (cursor.Peek() != ':')
+		cursor.Error("Malformed JSON file! Expected ':'");
 
-	if (**input != ':')
-		throw json_parsing_error("Malformed JSON file");
-	else
-		(*input)++;
+	cursor.Advance();
 
-	auto value = GatherValue(input);
+	auto value = GatherValue(cursor, depth);
 	return std::make_pair(std::move(name), std::move(value));
 }
 
@@ -242,6 +199,7 @@ std::ostream& operator<<(std::ostream& lhs, JSONDataType rhs)
 	case JSONDataType::Bool:		return lhs << "JSONDataType::Bool"sv;
 	case JSONDataType::Array:		return lhs << "JSONDataType::Array"sv;
 	case JSONDataType::Object:		return lhs << "JSONDataType::Object"sv;
+	case JSONDataType::Null:		return lhs << "JSONDataType::Null"sv;
 
 	default:
 		return lhs << StringTools::CSFormat("<*** UNKNOWN JSONDataType {0} ***>", Enums::value(rhs));
@@ -1,5 +1,6 @@
 #pragma once
 #include "BaseException.h"
+#include "JSONStructuralIndex.h"
 
 #include <filesystem>
 #include <map>
@@ -13,11 +14,14 @@ enum class JSONDataType
 	String,
 	Bool,
 	Array,
-	Object
+	Object,
+	Null,
 };
 
 extern std::ostream& operator<<(std::ostream& lhs, JSONDataType rhs);
 
+class JSONDocument;
+class JSONTapeDocument;
 class JSONValue;
 using JSONArray = std::vector<JSONValue>;
 
@@ -69,12 +73,14 @@ public:
 	explicit JSONValue(bool boolean) : m_Data(boolean) { }
 	explicit JSONValue(const JSONArray& array) : m_Data(array) { }
 	explicit JSONValue(const JSONObject& object) : m_Data(object) { }
+	explicit JSONValue(std::nullptr_t) : m_Data(nullptr) { }
 
 	void Set(double number) { m_Data = number; }
 	void Set(const std::string& str) { m_Data.emplace<std::string>(str); }
 	void Set(bool boolean) { m_Data = boolean; }
 	void Set(const JSONArray& array) { m_Data = array; }
 	void Set(const JSONObject& object) { m_Data = object; }
+	void Set(std::nullptr_t) { m_Data = nullptr; }
 
 	const double& GetNumber() const;
 	double& GetNumber() { return const_cast<double&>(std::as_const(*this).GetNumber()); }
@@ -94,7 +100,7 @@ public:
 	JSONDataType GetType() const;
 
 private:
-	std::variant<std::monostate, double, std::string, bool, JSONArray, JSONObject> m_Data;
+	std::variant<std::monostate, double, std::string, bool, JSONArray, JSONObject, std::nullptr_t> m_Data;
 };
 class json_error : public BaseException<>
 {
@@ -124,18 +130,28 @@ public:
 	static JSONValue FromFile(const std::filesystem::path& path);
 	static JSONValue FromString(const std::string& str);
 
-private:
-	static constexpr char ESCAPE_CHAR = '\\';
+	// Zero-copy parsing: the returned document keeps the file mapped (or its own copy
+	// of the string) and every string in it is a view into that source text.
+	static JSONDocument FromFileInSitu(const std::filesystem::path& path);
+	static JSONDocument FromStringInSitu(const std::string_view& str);
+
+	// Parses into a flat tape with its own copy of every string (see JSONTapeDocument).
+	// The source text isn't needed once these return.
+	static JSONTapeDocument FromFileTape(const std::filesystem::path& path);
+	static JSONTapeDocument FromStringTape(const std::string_view& str);
 
-	static bool IsEscaped(const char* input);
-	static bool IsNumber(char input);
-	static void EatWhitespace(const char** input);
+	// Pretty-printed with tabs unless minified. See JSONWriter for writing
+	// without building a JSONValue first.
+	static std::string ToString(const JSONValue& value, bool minified = false);
+	static void ToFile(const std::filesystem::path& path, const JSONValue& value, bool minified = false);
+
+private:
+	static constexpr size_t MAX_DEPTH = 512;
 
-	static JSONObject GatherObject(const char** input);
-	static JSONArray GatherArray(const char** input);
-	static JSONValue GatherValue(const char** input);
+	static JSONObject GatherObject(JSONStructuralIndex::Cursor& cursor, size_t depth);
+	static JSONArray GatherArray(JSONStructuralIndex::Cursor& cursor, size_t depth);
+	static JSONValue GatherValue(JSONStructuralIndex::Cursor& cursor, size_t depth);
 
-	static double GatherNumber(const char** input);
-	static std::string GatherString(const char** input);
-	static std::pair<std::string, JSONValue> GatherNamedValue(const char** input);
+	static std::string GatherString(JSONStructuralIndex::Cursor& cursor);
+	static std::pair<std::string, JSONValue> GatherNamedValue(JSONStructuralIndex::Cursor& cursor, size_t depth);
 };
\ No newline at end of file
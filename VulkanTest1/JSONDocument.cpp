@@ -0,0 +1,435 @@
+#include "stdafx.h"
+#include "JSONDocument.h"
+
+#include "JSONStructuralIndex.h"
+
+class JSONDocument::Parser
+{
+public:
+	Parser(const std::string_view& str) : m_Index(JSONStructuralIndex::SkipBOM(str)), m_Cursor(m_Index) { }
+
+	JSONViewValue ParseRoot();
+
+private:
+	static constexpr size_t MAX_DEPTH = 512;
+
+	JSONViewValue ParseValue();
+	JSONViewObject ParseObject();
+	JSONViewArray ParseArray();
+	JSONViewString ParseString();
+	JSONViewValue ParseScalar();
+
+	void Expect(char c);
+
+	JSONStructuralIndex m_Index;
+	JSONStructuralIndex::Cursor m_Cursor;
+	size_t m_Depth = 0;
+};
+
+JSONDocument::JSONDocument(MemoryMappedFile&& file) :
+	m_File(std::move(file))
+{
+	m_Root = Parser(m_File.GetView()).ParseRoot();
+}
+
+JSONDocument::JSONDocument(const std::string_view& str) :
+	m_Buffer(std::make_unique<char[]>(str.size())),
+	m_BufferSize(str.size())
+{
+	memcpy(m_Buffer.get(), str.data(), str.size());
+	m_Root = Parser(std::string_view(m_Buffer.get(), m_BufferSize)).ParseRoot();
+}
+
+JSONViewValue JSONDocument::Parser::ParseRoot()
+{
+	JSONViewValue retVal = ParseValue();
+
+	if (!m_Cursor.AtEnd())
+		m_Cursor.Error("Unexpected data after the root value");
+
+	return retVal;
+}
+
+JSONViewValue JSONDocument::Parser::ParseValue()
+{
+	switch (m_Cursor.Peek())
+	{
+	case '{':	return JSONViewValue(ParseObject());
+	case '[':	return JSONViewValue(ParseArray());
+	case '"':	return JSONViewValue(ParseString());
+
+	case '}':
+	case ']':
+	case ',':
+	case ':':
+	case '\0':
+		m_Cursor.Error("Expected a value");
+
+	default:
+		return ParseScalar();
+	}
+}
+
+JSONViewObject JSONDocument::Parser::ParseObject()
+{
+	Expect('{');
+
+	if (++m_Depth > MAX_DEPTH)
+		m_Cursor.Error("Maximum nesting depth exceeded");
+
+	JSONViewObject retVal;
+	if (m_Cursor.Peek() == '}')
+	{
+		m_Cursor.Advance();
+		m_Depth--;
+		return retVal;
+	}
+
+	while (true)
+	{
+		if (m_Cursor.Peek() != '"')
+			m_Cursor.Error("Expected '\"'");
+
+		JSONViewString name = ParseString();
+		Expect(':');
+
+		retVal.emplace_back(name, ParseValue());
+
+		if (m_Cursor.Peek() == ',')
+			m_Cursor.Advance();
+		else
+		{
+			Expect('}');
+			break;
+		}
+	}
+
+	m_Depth--;
+	return retVal;
+}
+
+JSONViewArray JSONDocument::Parser::ParseArray()
+{
+	Expect('[');
+
+	if (++m_Depth > MAX_DEPTH)
+		m_Cursor.Error("Maximum nesting depth exceeded");
+
+	JSONViewArray retVal;
+	if (m_Cursor.Peek() == ']')
+	{
+		m_Cursor.Advance();
+		m_Depth--;
+		return retVal;
+	}
+
+	while (true)
+	{
+		retVal.push_back(ParseValue());
+
+		if (m_Cursor.Peek() == ',')
+			m_Cursor.Advance();
+		else
+		{
+			Expect(']');
+			break;
+		}
+	}
+
+	m_Depth--;
+	return retVal;
+}
+
+JSONViewString JSONDocument::Parser::ParseString()
+{
+	bool hasEscapes;
+	const auto raw = m_Cursor.GatherString(&hasEscapes);
+	return JSONViewString(raw, hasEscapes);
+}
+
+JSONViewValue JSONDocument::Parser::ParseScalar()
+{
+	const auto scalar = m_Cursor.GatherScalar();
+	if (scalar == "true"sv)
+		return JSONViewValue(true);
+	else if (scalar == "false"sv)
+		return JSONViewValue(false);
+	else if (scalar == "null"sv)
+		return JSONViewValue(nullptr);
+
+	return JSONViewValue(JSONStructuralIndex::ParseNumber(scalar));
+}
+
+void JSONDocument::Parser::Expect(char c)
+{
+	if (m_Cursor.Peek() != c)
+		m_Cursor.Error(StringTools::CSFormat("Expected '{0}'", c));
+
+	m_Cursor.Advance();
+}
+
+static void AppendUTF8(std::string& str, uint32_t codepoint)
+{
+	if (codepoint < 0x80)
+		str += char(codepoint);
+	else if (codepoint < 0x800)
+	{
+		str += char(0xC0 | (codepoint >> 6));
+		str += char(0x80 | (codepoint & 0x3F));
+	}
+	else if (codepoint < 0x10000)
+	{
+		str += char(0xE0 | (codepoint >> 12));
+		str += char(0x80 | ((codepoint >> 6) & 0x3F));
+		str += char(0x80 | (codepoint & 0x3F));
+	}
+	else
+	{
+		str += char(0xF0 | (codepoint >> 18));
+		str += char(0x80 | ((codepoint >> 12) & 0x3F));
+		str += char(0x80 | ((codepoint >> 6) & 0x3F));
+		str += char(0x80 | (codepoint & 0x3F));
+	}
+}
+
+static uint32_t ParseHex4(const std::string_view& raw, size_t offset)
+{
+	if (offset + 4 > raw.size())
+		throw json_parsing_error("Truncated \\u escape sequence");
+
+	uint32_t retVal = 0;
+	for (size_t i = offset; i < offset + 4; i++)
+	{
+		const char c = raw[i];
+		retVal <<= 4;
+		if (c >= '0' && c <= '9')
+			retVal |= c - '0';
+		else if (c >= 'a' && c <= 'f')
+			retVal |= c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F')
+			retVal |= c - 'A' + 10;
+		else
+			throw json_parsing_error(StringTools::CSFormat("Invalid hex digit '{0}' in \\u escape sequence", c));
+	}
+
+	return retVal;
+}
+
+std::string JSONViewString::Decode(const std::string_view& raw)
+{
+	std::string retVal;
+	retVal.reserve(raw.size());
+
+	size_t i = 0;
+	while (i < raw.size())
+	{
+		// Copy everything up to the next escape in one go
+		const size_t escape = raw.find('\\', i);
+		retVal.append(raw.data() + i, std::min(escape, raw.size()) - i);
+		if (escape == raw.npos)
+			break;
+
+		if (escape + 1 >= raw.size())
+			throw json_parsing_error("String ends with an incomplete escape sequence");
+
+		const char c = raw[escape + 1];
+		i = escape + 2;
+		switch (c)
+		{
+		case '"':	retVal += '"'; break;
+		case '\\':	retVal += '\\'; break;
+		case '/':	retVal += '/'; break;
+		case 'b':	retVal += '\b'; break;
+		case 'f':	retVal += '\f'; break;
+		case 'n':	retVal += '\n'; break;
+		case 'r':	retVal += '\r'; break;
+		case 't':	retVal += '\t'; break;
+		case 'u':
+		{
+			uint32_t codepoint = ParseHex4(raw, i);
+			i += 4;
+
+			// Surrogate pair
+			if (codepoint >= 0xD800 && codepoint <= 0xDBFF)
+			{
+				if (i + 6 > raw.size() || raw[i] != '\\' || raw[i + 1] != 'u')
+					throw json_parsing_error("Unpaired high surrogate in \\u escape sequence");
+
+				const uint32_t low = ParseHex4(raw, i + 2);
+				if (low < 0xDC00 || low > 0xDFFF)
+					throw json_parsing_error("Invalid low surrogate in \\u escape sequence");
+
+				codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+				i += 6;
+			}
+			else if (codepoint >= 0xDC00 && codepoint <= 0xDFFF)
+				throw json_parsing_error("Unpaired low surrogate in \\u escape sequence");
+
+			AppendUTF8(retVal, codepoint);
+			break;
+		}
+
+		default:
+			throw json_parsing_error(StringTools::CSFormat("Unknown escape sequence '\\{0}'", c));
+		}
+	}
+
+	return retVal;
+}
+
+double JSONViewObject::TryGetNumber(const std::string_view& name, double defaultValue, bool* success) const
+{
+	const auto found = TryGetValue(name);
+	if (success)
+		*success = !!found;
+
+	return found ? found->GetNumber() : defaultValue;
+}
+
+bool JSONViewObject::TryGetBool(const std::string_view& name, bool defaultValue, bool* success) const
+{
+	const auto found = TryGetValue(name);
+	if (success)
+		*success = !!found;
+
+	return found ? found->GetBool() : defaultValue;
+}
+
+std::string JSONViewObject::TryGetString(const std::string_view& name, const std::string_view& defaultValue, bool* success) const
+{
+	const auto found = TryGetValue(name);
+	if (success)
+		*success = !!found;
+
+	return found ? found->GetString().Decode() : std::string(defaultValue);
+}
+
+const double* JSONViewObject::TryGetNumber(const std::string_view& name) const
+{
+	const auto foundValue = TryGetValue(name);
+	return foundValue ? &foundValue->GetNumber() : nullptr;
+}
+
+const bool* JSONViewObject::TryGetBool(const std::string_view& name) const
+{
+	const auto foundValue = TryGetValue(name);
+	return foundValue ? &foundValue->GetBool() : nullptr;
+}
+
+const JSONViewString* JSONViewObject::TryGetString(const std::string_view& name) const
+{
+	const auto foundValue = TryGetValue(name);
+	return foundValue ? &foundValue->GetString() : nullptr;
+}
+
+const JSONViewArray* JSONViewObject::TryGetArray(const std::string_view& name) const
+{
+	const auto foundValue = TryGetValue(name);
+	return foundValue ? &foundValue->GetArray() : nullptr;
+}
+
+const JSONViewObject* JSONViewObject::TryGetObject(const std::string_view& name) const
+{
+	const auto foundValue = TryGetValue(name);
+	return foundValue ? &foundValue->GetObject() : nullptr;
+}
+
+const JSONViewValue* JSONViewObject::TryGetValue(const std::string_view& name) const
+{
+	for (const auto& pair : *this)
+	{
+		if (pair.first.Equals(name))
+			return &pair.second;
+	}
+
+	return nullptr;
+}
+
+const double& JSONViewObject::GetNumber(const std::string_view& name) const
+{
+	if (auto found = TryGetValue(name))
+		return found->GetNumber();
+
+	throw json_value_missing_error(StringTools::CSFormat("Missing required number value {0}", name));
+}
+
+const bool& JSONViewObject::GetBool(const std::string_view& name) const
+{
+	if (auto found = TryGetValue(name))
+		return found->GetBool();
+
+	throw json_value_missing_error(StringTools::CSFormat("Missing required boolean value {0}", name));
+}
+
+const JSONViewString& JSONViewObject::GetString(const std::string_view& name) const
+{
+	if (auto found = TryGetValue(name))
+		return found->GetString();
+
+	throw json_value_missing_error(StringTools::CSFormat("Missing required string value {0}", name));
+}
+
+const JSONViewArray& JSONViewObject::GetArray(const std::string_view& name) const
+{
+	if (auto found = TryGetValue(name))
+		return found->GetArray();
+
+	throw json_value_missing_error(StringTools::CSFormat("Missing required array value {0}", name));
+}
+
+const JSONViewObject& JSONViewObject::GetObject(const std::string_view& name) const
+{
+	if (auto found = TryGetValue(name))
+		return found->GetObject();
+
+	throw json_value_missing_error(StringTools::CSFormat("Missing required object value {0}", name));
+}
+
+const JSONViewValue& JSONViewObject::GetValue(const std::string_view& name) const
+{
+	if (auto found = TryGetValue(name))
+		return *found;
+
+	throw json_value_missing_error(StringTools::CSFormat("Missing required value {0}", name));
+}
+
+template<class T> static const T& GetViewData(const std::variant<std::monostate, double, JSONViewString, bool, JSONViewArray, JSONViewObject, std::nullptr_t>& data, JSONDataType type, const char* fnName)
+{
+	if (auto found = std::get_if<T>(&data))
+		return *found;
+
+	throw json_value_type_error(StringTools::CSFormat("Attempted to call {0}(), but data type was {1}.", fnName, type));
+}
+
+const double& JSONViewValue::GetNumber() const
+{
+	return GetViewData<double>(m_Data, GetType(), __FUNCTION__);
+}
+
+const bool& JSONViewValue::GetBool() const
+{
+	return GetViewData<bool>(m_Data, GetType(), __FUNCTION__);
+}
+
+const JSONViewString& JSONViewValue::GetString() const
+{
+	return GetViewData<JSONViewString>(m_Data, GetType(), __FUNCTION__);
+}
+
+const JSONViewArray& JSONViewValue::GetArray() const
+{
+	return GetViewData<JSONViewArray>(m_Data, GetType(), __FUNCTION__);
+}
+
+const JSONViewObject& JSONViewValue::GetObject() const
+{
+	return GetViewData<JSONViewObject>(m_Data, GetType(), __FUNCTION__);
+}
+
+JSONDataType JSONViewValue::GetType() const
+{
+	if (m_Data.index() == 0)
+		throw std::runtime_error("Accessing uninitialized JSONViewValue");
+
+	return JSONDataType(m_Data.index() - 1);
+}
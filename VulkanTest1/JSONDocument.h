@@ -0,0 +1,111 @@
+#pragma once
+#include "JSON.h"
+#include "MemoryMappedFile.h"
+
+#include <memory>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+// A string exactly as it appears in the source document. Escape sequences are
+// left untouched until someone actually asks for the decoded text.
+class JSONViewString
+{
+public:
+	JSONViewString() = default;
+	JSONViewString(const std::string_view& raw, bool hasEscapes) : m_Raw(raw), m_HasEscapes(hasEscapes) { }
+
+	const std::string_view& GetRaw() const { return m_Raw; }
+	bool HasEscapes() const { return m_HasEscapes; }
+
+	std::string Decode() const { return m_HasEscapes ? Decode(m_Raw) : std::string(m_Raw); }
+	bool Equals(const std::string_view& decoded) const { return m_HasEscapes ? Decode(m_Raw) == decoded : m_Raw == decoded; }
+
+	static std::string Decode(const std::string_view& raw);
+
+private:
+	std::string_view m_Raw;
+	bool m_HasEscapes = false;
+};
+
+class JSONViewValue;
+using JSONViewArray = std::vector<JSONViewValue>;
+
+// Keys are kept in document order, and lookups are linear. Asset definitions
+// have a handful of keys each, so this beats a tree in both time and memory.
+class JSONViewObject : public std::vector<std::pair<JSONViewString, JSONViewValue>>
+{
+public:
+	double TryGetNumber(const std::string_view& name, double defaultValue, bool* success = nullptr) const;
+	bool TryGetBool(const std::string_view& name, bool defaultValue, bool* success = nullptr) const;
+	std::string TryGetString(const std::string_view& name, const std::string_view& defaultValue, bool* success = nullptr) const;
+
+	const double* TryGetNumber(const std::string_view& name) const;
+	const bool* TryGetBool(const std::string_view& name) const;
+	const JSONViewString* TryGetString(const std::string_view& name) const;
+	const JSONViewArray* TryGetArray(const std::string_view& name) const;
+	const JSONViewObject* TryGetObject(const std::string_view& name) const;
+	const JSONViewValue* TryGetValue(const std::string_view& name) const;
+
+	///////////////////////////////////////////////////////////////////
+	// These throw json_value_missing_error or json_value_type_error //
+	///////////////////////////////////////////////////////////////////
+	const double& GetNumber(const std::string_view& name) const;
+	const bool& GetBool(const std::string_view& name) const;
+	const JSONViewString& GetString(const std::string_view& name) const;
+	const JSONViewArray& GetArray(const std::string_view& name) const;
+	const JSONViewObject& GetObject(const std::string_view& name) const;
+	const JSONViewValue& GetValue(const std::string_view& name) const;
+};
+
+class JSONViewValue
+{
+public:
+	JSONViewValue() = default;
+	explicit JSONViewValue(double number) : m_Data(number) { }
+	explicit JSONViewValue(const JSONViewString& str) : m_Data(str) { }
+	explicit JSONViewValue(bool boolean) : m_Data(boolean) { }
+	explicit JSONViewValue(JSONViewArray&& array) : m_Data(std::move(array)) { }
+	explicit JSONViewValue(JSONViewObject&& object) : m_Data(std::move(object)) { }
+	explicit JSONViewValue(std::nullptr_t) : m_Data(nullptr) { }
+
+	const double& GetNumber() const;
+	const bool& GetBool() const;
+	const JSONViewString& GetString() const;
+	const JSONViewArray& GetArray() const;
+	const JSONViewObject& GetObject() const;
+
+	JSONDataType GetType() const;
+
+private:
+	std::variant<std::monostate, double, JSONViewString, bool, JSONViewArray, JSONViewObject, std::nullptr_t> m_Data;
+};
+
+// Owns the source text of a document parsed by JSONSerializer::FromFileInSitu or
+// FromStringInSitu. Every string in the tree is a view into that text, so the
+// values must not outlive the document.
+class JSONDocument
+{
+public:
+	JSONDocument(const JSONDocument& other) = delete;
+	JSONDocument(JSONDocument&& other) = default;
+
+	const JSONViewValue& GetRoot() const { return m_Root; }
+	const JSONViewObject& GetObject() const { return m_Root.GetObject(); }
+	const JSONViewArray& GetArray() const { return m_Root.GetArray(); }
+
+	std::string_view GetSource() const { return m_File.empty() ? std::string_view(m_Buffer.get(), m_BufferSize) : m_File.GetView(); }
+
+private:
+	JSONDocument(MemoryMappedFile&& file);
+	JSONDocument(const std::string_view& str);
+	friend class JSONSerializer;
+
+	class Parser;
+
+	MemoryMappedFile m_File;
+	std::unique_ptr<char[]> m_Buffer;
+	size_t m_BufferSize = 0;
+
+	JSONViewValue m_Root;
+};
@@ -0,0 +1,349 @@
+#include "stdafx.h"
+#include "JSONReader.h"
+
+#include "Enums.h"
+#include "JSONDocument.h"
+#include "JSONStructuralIndex.h"
+
+JSONReader::JSONReader(const std::filesystem::path& path) :
+	m_File(path)
+{
+	JSONStructuralIndex::ValidateUTF8(m_File.GetView());
+	m_Source = JSONStructuralIndex::SkipBOM(m_File.GetView());
+}
+
+JSONReader::JSONReader(const std::string_view& str) :
+	m_Source(JSONStructuralIndex::SkipBOM(str))
+{
+}
+
+JSONEvent JSONReader::Next()
+{
+	if (m_Replay)
+	{
+		m_Replay = false;
+		return m_Event;
+	}
+
+	SkipWhitespace();
+
+	switch (m_State)
+	{
+	case State::Done:
+		return m_Event = JSONEvent::EndOfDocument;
+
+	case State::AfterValue:
+		if (m_Stack.empty())
+		{
+			if (m_Position < m_Source.size())
+				Error("Unexpected data after the root value");
+
+			m_State = State::Done;
+			return m_Event = JSONEvent::EndOfDocument;
+		}
+
+		if (Peek() == ',')
+		{
+			m_Position++;
+			SkipWhitespace();
+			return m_Event = (m_Stack.back() == '{') ? ReadKey() : ReadValue();
+		}
+
+		return m_Event = CloseContainer();
+
+	case State::FirstKey:
+		return m_Event = (Peek() == '}') ? CloseContainer() : ReadKey();
+
+	case State::FirstValue:
+		return m_Event = (Peek() == ']') ? CloseContainer() : ReadValue();
+
+	case State::Value:
+		return m_Event = ReadValue();
+	}
+
+	throw std::runtime_error(StringTools::CSFormat("Unknown JSONReader state {0}", Enums::value(m_State)));
+}
+
+std::string_view JSONReader::GetString() const
+{
+	if (m_Event != JSONEvent::Key && m_Event != JSONEvent::String)
+		throw json_value_type_error(StringTools::CSFormat("Attempted to call {0}(), but the current event was {1}.", __FUNCTION__, m_Event));
+
+	if (!m_StringHasEscapes)
+		return m_RawString;
+
+	if (!m_StringDecoded)
+	{
+		m_DecodedString = JSONViewString::Decode(m_RawString);
+		m_StringDecoded = true;
+	}
+
+	return m_DecodedString;
+}
+
+double JSONReader::GetNumber() const
+{
+	if (m_Event != JSONEvent::Number)
+		throw json_value_type_error(StringTools::CSFormat("Attempted to call {0}(), but the current event was {1}.", __FUNCTION__, m_Event));
+
+	return m_Number;
+}
+
+bool JSONReader::GetBool() const
+{
+	if (m_Event != JSONEvent::Bool)
+		throw json_value_type_error(StringTools::CSFormat("Attempted to call {0}(), but the current event was {1}.", __FUNCTION__, m_Event));
+
+	return m_Bool;
+}
+
+void JSONReader::Expect(JSONEvent event)
+{
+	const size_t start = m_Position;
+	if (Next() != event)
+		JSONStructuralIndex::Error(m_Source, start, StringTools::CSFormat("Expected {0} but found {1}", event, m_Event));
+}
+
+std::string JSONReader::ReadString()
+{
+	Expect(JSONEvent::String);
+	return std::string(GetString());
+}
+
+double JSONReader::ReadNumber()
+{
+	Expect(JSONEvent::Number);
+	return m_Number;
+}
+
+bool JSONReader::ReadBool()
+{
+	Expect(JSONEvent::Bool);
+	return m_Bool;
+}
+
+void JSONReader::SkipValue()
+{
+	switch (Next())
+	{
+	case JSONEvent::StartObject:
+	case JSONEvent::StartArray:
+		return SkipContainer();
+
+	case JSONEvent::String:
+	case JSONEvent::Number:
+	case JSONEvent::Bool:
+	case JSONEvent::Null:
+		return;
+
+	default:
+		throw std::runtime_error(StringTools::CSFormat("{0}() was called where no value was next (read {1} instead)", __FUNCTION__, m_Event));
+	}
+}
+
+void JSONReader::SkipContainer()
+{
+	if (m_Stack.empty())
+		throw std::runtime_error(StringTools::CSFormat("{0}() was called with no open object or array", __FUNCTION__));
+
+	// Only strings and brackets matter here. Everything else in the skipped
+	// section goes unvalidated, which is what makes skipping cheap.
+	const size_t targetDepth = m_Stack.size() - 1;
+	while (true)
+	{
+		m_Position = m_Source.find_first_of("\"{}[]"sv, m_Position);
+		if (m_Position == m_Source.npos)
+		{
+			m_Position = m_Source.size();
+			Error("Unexpected end of input");
+		}
+
+		const char c = m_Source[m_Position];
+		switch (c)
+		{
+		case '"':
+			ReadRawString();
+			break;
+
+		case '{':
+		case '[':
+			if (m_Stack.size() >= MAX_DEPTH)
+				Error("Maximum nesting depth exceeded");
+
+			m_Stack.push_back(c);
+			m_Position++;
+			break;
+
+		case '}':
+		case ']':
+			if (m_Stack.back() != (c == '}' ? '{' : '['))
+				Error("Mismatched closing bracket");
+
+			m_Stack.pop_back();
+			m_Position++;
+
+			if (m_Stack.size() == targetDepth)
+			{
+				m_State = State::AfterValue;
+				m_Event = (c == '}') ? JSONEvent::EndObject : JSONEvent::EndArray;
+				return;
+			}
+			break;
+		}
+	}
+}
+
+void JSONReader::SkipWhitespace()
+{
+	while (m_Position < m_Source.size())
+	{
+		const char c = m_Source[m_Position];
+		if (c != ' ' && c != '\t' && c != '\n' && c != '\r')
+			break;
+
+		m_Position++;
+	}
+}
+
+JSONEvent JSONReader::ReadValue()
+{
+	switch (Peek())
+	{
+	case '{':
+	case '[':
+	{
+		if (m_Stack.size() >= MAX_DEPTH)
+			Error("Maximum nesting depth exceeded");
+
+		const char c = m_Source[m_Position++];
+		m_Stack.push_back(c);
+		m_State = (c == '{') ? State::FirstKey : State::FirstValue;
+		return (c == '{') ? JSONEvent::StartObject : JSONEvent::StartArray;
+	}
+
+	case '"':
+		ReadRawString();
+		m_State = State::AfterValue;
+		return JSONEvent::String;
+
+	case '}':
+	case ']':
+	case ',':
+	case ':':
+	case '\0':
+		Error("Expected a value");
+
+	default:
+		m_State = State::AfterValue;
+		return ReadScalar();
+	}
+}
+
+JSONEvent JSONReader::ReadKey()
+{
+	if (Peek() != '"')
+		Error("Expected '\"'");
+
+	ReadRawString();
+
+	SkipWhitespace();
+	if (Peek() != ':')
+		Error("Expected ':'");
+
+	m_Position++;
+	m_State = State::Value;
+	return JSONEvent::Key;
+}
+
+JSONEvent JSONReader::ReadScalar()
+{
+	const size_t start = m_Position;
+	while (m_Position < m_Source.size())
+	{
+		const char c = m_Source[m_Position];
+		if (c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+			c == ',' || c == ':' || c == '}' || c == ']' || c == '{' || c == '[' || c == '"')
+		{
+			break;
+		}
+
+		m_Position++;
+	}
+
+	const std::string_view scalar = m_Source.substr(start, m_Position - start);
+	if (scalar == "true"sv || scalar == "false"sv)
+	{
+		m_Bool = scalar == "true"sv;
+		return JSONEvent::Bool;
+	}
+	else if (scalar == "null"sv)
+		return JSONEvent::Null;
+
+	m_Number = JSONStructuralIndex::ParseNumber(scalar);
+	return JSONEvent::Number;
+}
+
+void JSONReader::ReadRawString()
+{
+	assert(Peek() == '"');
+	const size_t start = ++m_Position;
+
+	m_StringHasEscapes = false;
+	m_StringDecoded = false;
+
+	while (true)
+	{
+		const size_t found = m_Source.find_first_of("\"\\"sv, m_Position);
+		if (found == m_Source.npos)
+			JSONStructuralIndex::Error(m_Source, start - 1, "Unterminated string");
+
+		if (m_Source[found] == '"')
+		{
+			m_RawString = m_Source.substr(start, found - start);
+			m_Position = found + 1;
+			return;
+		}
+
+		// Step over whatever is being escaped, even if it's a quote
+		m_StringHasEscapes = true;
+		m_Position = found + 2;
+	}
+}
+
+JSONEvent JSONReader::CloseContainer()
+{
+	const char open = m_Stack.back();
+	const char close = (open == '{') ? '}' : ']';
+	if (Peek() != close)
+		Error(open == '{' ? "Expected ',' or '}'" : "Expected ',' or ']'");
+
+	m_Position++;
+	m_Stack.pop_back();
+	m_State = State::AfterValue;
+	return (open == '{') ? JSONEvent::EndObject : JSONEvent::EndArray;
+}
+
+void JSONReader::Error(const std::string_view& msg) const
+{
+	JSONStructuralIndex::Error(m_Source, m_Position, msg);
+}
+
+std::ostream& operator<<(std::ostream& lhs, JSONEvent rhs)
+{
+	switch (rhs)
+	{
+	case JSONEvent::StartObject:	return lhs << "JSONEvent::StartObject"sv;
+	case JSONEvent::EndObject:		return lhs << "JSONEvent::EndObject"sv;
+	case JSONEvent::StartArray:		return lhs << "JSONEvent::StartArray"sv;
+	case JSONEvent::EndArray:		return lhs << "JSONEvent::EndArray"sv;
+	case JSONEvent::Key:			return lhs << "JSONEvent::Key"sv;
+	case JSONEvent::String:			return lhs << "JSONEvent::String"sv;
+	case JSONEvent::Number:			return lhs << "JSONEvent::Number"sv;
+	case JSONEvent::Bool:			return lhs << "JSONEvent::Bool"sv;
+	case JSONEvent::Null:			return lhs << "JSONEvent::Null"sv;
+	case JSONEvent::EndOfDocument:	return lhs << "JSONEvent::EndOfDocument"sv;
+
+	default:
+		return lhs << StringTools::CSFormat("<*** UNKNOWN JSONEvent {0} ***>", Enums::value(rhs));
+	}
+}
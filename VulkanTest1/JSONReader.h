@@ -0,0 +1,121 @@
+#pragma once
+#include "JSON.h"
+#include "MemoryMappedFile.h"
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class JSONEvent
+{
+	StartObject,
+	EndObject,
+	StartArray,
+	EndArray,
+	Key,
+	String,
+	Number,
+	Bool,
+	Null,
+	EndOfDocument,
+};
+
+extern std::ostream& operator<<(std::ostream& lhs, JSONEvent rhs);
+
+// Pull parser: each call to Next() reads just far enough to produce one event,
+// and nothing is kept around except the current nesting. Use this over
+// JSONSerializer when only a few values out of a large document are needed.
+//
+//	JSONReader reader(path);
+//	reader.Expect(JSONEvent::StartObject);
+//	while (reader.Next() == JSONEvent::Key)
+//	{
+//		if (reader.GetString() == "name"sv)
+//			name = reader.ReadString();
+//		else
+//			reader.SkipValue();
+//	}
+class JSONReader
+{
+public:
+	// Maps the file for the lifetime of the reader
+	JSONReader(const std::filesystem::path& path);
+
+	// Does not copy str, which must outlive the reader
+	JSONReader(const std::string_view& str);
+
+	JSONReader(const JSONReader& other) = delete;
+	JSONReader& operator=(const JSONReader& other) = delete;
+
+	// Reads the next event. Throws json_parsing_error on malformed input.
+	JSONEvent Next();
+	JSONEvent GetEvent() const { return m_Event; }
+
+	// Makes the next call to Next() return the current event again, for when
+	// whoever read it isn't the one who should handle it.
+	void Unread() { m_Replay = true; }
+
+	// Number of objects/arrays currently open
+	size_t GetDepth() const { return m_Stack.size(); }
+
+	// Valid after Key or String, until the next call to Next(). Escape sequences
+	// are only decoded if this is actually called.
+	std::string_view GetString() const;
+	double GetNumber() const;
+	bool GetBool() const;
+
+	// Reads the next event and throws json_parsing_error if it isn't the expected one.
+	void Expect(JSONEvent event);
+	std::string ReadString();
+	double ReadNumber();
+	bool ReadBool();
+
+	// Consumes the next value in its entirety. Use after Key to ignore the value.
+	void SkipValue();
+
+	// Consumes everything up to and including the end of the innermost open object or array.
+	void SkipContainer();
+
+private:
+	enum class State
+	{
+		Value,
+		FirstValue,
+		FirstKey,
+		AfterValue,
+		Done,
+	};
+
+	static constexpr size_t MAX_DEPTH = 512;
+
+	char Peek() const { return m_Position < m_Source.size() ? m_Source[m_Position] : '\0'; }
+	void SkipWhitespace();
+
+	JSONEvent ReadValue();
+	JSONEvent ReadKey();
+	JSONEvent ReadScalar();
+	void ReadRawString();
+	JSONEvent CloseContainer();
+
+	[[noreturn]] void Error(const std::string_view& msg) const;
+
+	MemoryMappedFile m_File;
+	std::string_view m_Source;
+	size_t m_Position = 0;
+
+	State m_State = State::Value;
+	JSONEvent m_Event = JSONEvent::EndOfDocument;
+	bool m_Replay = false;
+
+	// '{' or '[' for every open container
+	std::vector<char> m_Stack;
+
+	std::string_view m_RawString;
+	bool m_StringHasEscapes = false;
+	mutable std::string m_DecodedString;
+	mutable bool m_StringDecoded = false;
+
+	double m_Number = 0;
+	bool m_Bool = false;
+};
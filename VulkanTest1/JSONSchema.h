@@ -0,0 +1,217 @@
+#pragma once
+#include "JSONReader.h"
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Binds object keys directly to struct members, and reads them in a single pass
+// over a JSONReader without building a DOM. Keys are matched by a hash computed
+// at compile time.
+//
+//	static const auto s_Schema = MakeJSONSchema<Foo>(
+//		JSONBind<&Foo::m_Count>("count", JSONPresence::Required),
+//		JSONBind<&Foo::m_Names>("names"),
+//		JSONBind<Foo>("mode", [](JSONReader& reader, Foo& foo) { foo.m_Mode = ToMode(reader.ReadString()); }));
+//
+//	s_Schema.Read(reader, foo, &unknownFields);
+
+// FNV-1a
+constexpr uint32_t JSONKeyHash(const std::string_view& key)
+{
+	uint32_t hash = 2166136261u;
+	for (const char c : key)
+	{
+		hash ^= uint8_t(c);
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+// Reads one value into T. Specialize this for types that need their own conversion.
+// Structs with a static GetJSONSchema() are read as objects using that schema.
+template<class T, class = void> struct JSONValueReader;
+
+template<> struct JSONValueReader<bool>
+{
+	static void Read(JSONReader& reader, bool& value) { value = reader.ReadBool(); }
+};
+template<class T> struct JSONValueReader<T, std::enable_if_t<std::is_arithmetic_v<T>>>
+{
+	static void Read(JSONReader& reader, T& value) { value = T(reader.ReadNumber()); }
+};
+template<> struct JSONValueReader<std::string>
+{
+	static void Read(JSONReader& reader, std::string& value) { value = reader.ReadString(); }
+};
+template<> struct JSONValueReader<std::filesystem::path>
+{
+	static void Read(JSONReader& reader, std::filesystem::path& value) { reader.Expect(JSONEvent::String); value = reader.GetString(); }
+};
+template<class T> struct JSONValueReader<std::vector<T>>
+{
+	static void Read(JSONReader& reader, std::vector<T>& value)
+	{
+		reader.Expect(JSONEvent::StartArray);
+		value.clear();
+
+		while (reader.Next() != JSONEvent::EndArray)
+		{
+			// Let the element's reader see the event we just peeked at
+			reader.Unread();
+			JSONValueReader<T>::Read(reader, value.emplace_back());
+		}
+	}
+};
+template<class T> struct JSONValueReader<T, std::void_t<decltype(T::GetJSONSchema())>>
+{
+	static void Read(JSONReader& reader, T& value) { T::GetJSONSchema().Read(reader, value); }
+};
+
+enum class JSONPresence
+{
+	Optional,
+	Required,
+};
+
+template<class T> struct JSONField
+{
+	std::string_view m_Name;
+	uint32_t m_Hash;
+	JSONPresence m_Presence;
+	void(*m_Read)(JSONReader& reader, T& object);
+
+	// Used instead of m_Read for values that can be objects with a schema of
+	// their own, so keys they don't know are reported too
+	void(*m_ReadNested)(JSONReader& reader, T& object, std::vector<std::string>* unknownFields);
+};
+
+template<class T> struct JSONMemberTraits;
+template<class Class, class Value> struct JSONMemberTraits<Value Class::*>
+{
+	using class_type = Class;
+	using value_type = Value;
+};
+
+// Binds name to a data member, read with JSONValueReader
+template<auto Member> constexpr auto JSONBind(const std::string_view& name, JSONPresence presence = JSONPresence::Optional)
+{
+	using Traits = JSONMemberTraits<decltype(Member)>;
+	using T = typename Traits::class_type;
+
+	return JSONField<T>{ name, JSONKeyHash(name), presence,
+		[](JSONReader& reader, T& object) { JSONValueReader<typename Traits::value_type>::Read(reader, object.*Member); } };
+}
+
+// Binds name to a function that reads the value (starting with the next event) however it likes
+template<class T> constexpr JSONField<T> JSONBind(const std::string_view& name, void(*read)(JSONReader& reader, T& object),
+	JSONPresence presence = JSONPresence::Optional)
+{
+	return JSONField<T>{ name, JSONKeyHash(name), presence, read };
+}
+
+// Same, but read should pass unknownFields on to any schema it reads the value
+// with. Keys it doesn't know are reported as "name.key".
+template<class T> constexpr JSONField<T> JSONBind(const std::string_view& name,
+	void(*read)(JSONReader& reader, T& object, std::vector<std::string>* unknownFields), JSONPresence presence = JSONPresence::Optional)
+{
+	return JSONField<T>{ name, JSONKeyHash(name), presence, nullptr, read };
+}
+
+template<class T, size_t FieldCount> class JSONSchema
+{
+public:
+	JSONSchema(const std::array<JSONField<T>, FieldCount>& fields) : m_Fields(fields)
+	{
+		std::sort(m_Fields.begin(), m_Fields.end(), [](const JSONField<T>& lhs, const JSONField<T>& rhs) { return lhs.m_Hash < rhs.m_Hash; });
+
+		for (size_t i = 1; i < FieldCount; i++)
+			assert(m_Fields[i - 1].m_Hash != m_Fields[i].m_Hash);	// Hash collision or duplicate field, rename one
+	}
+
+	// Reads a whole object into object. Keys that aren't in the schema are skipped
+	// and added to unknownFields, if provided. Throws json_value_missing_error if any
+	// required fields are missing.
+	void Read(JSONReader& reader, T& object, std::vector<std::string>* unknownFields = nullptr) const
+	{
+		reader.Expect(JSONEvent::StartObject);
+		ReadMembers(reader, object, unknownFields);
+	}
+
+	// Same as Read, for when the reader has already consumed the StartObject event.
+	void ReadMembers(JSONReader& reader, T& object, std::vector<std::string>* unknownFields = nullptr) const
+	{
+		std::bitset<FieldCount> found;
+		while (reader.Next() == JSONEvent::Key)
+		{
+			const std::string_view key = reader.GetString();
+			if (const auto field = Find(key))
+			{
+				found.set(field - m_Fields.data());
+
+				if (field->m_ReadNested)
+					ReadNested(*field, reader, object, unknownFields);
+				else
+					field->m_Read(reader, object);
+			}
+			else
+			{
+				if (unknownFields)
+					unknownFields->emplace_back(key);
+
+				reader.SkipValue();
+			}
+		}
+
+		assert(reader.GetEvent() == JSONEvent::EndObject);
+
+		std::string missing;
+		for (size_t i = 0; i < FieldCount; i++)
+		{
+			if (m_Fields[i].m_Presence == JSONPresence::Required && !found[i])
+				missing.append(missing.empty() ? ""sv : ", "sv).append(m_Fields[i].m_Name);
+		}
+
+		if (!missing.empty())
+			throw json_value_missing_error(StringTools::CSFormat("Missing required field(s) {0}", missing));
+	}
+
+	const JSONField<T>* Find(const std::string_view& key) const
+	{
+		const uint32_t hash = JSONKeyHash(key);
+		const auto found = std::lower_bound(m_Fields.begin(), m_Fields.end(), hash,
+			[](const JSONField<T>& field, uint32_t hash) { return field.m_Hash < hash; });
+
+		if (found != m_Fields.end() && found->m_Hash == hash && found->m_Name == key)
+			return &*found;
+
+		return nullptr;
+	}
+
+private:
+	static void ReadNested(const JSONField<T>& field, JSONReader& reader, T& object, std::vector<std::string>* unknownFields)
+	{
+		const size_t firstNested = unknownFields ? unknownFields->size() : 0;
+		field.m_ReadNested(reader, object, unknownFields);
+
+		if (unknownFields)
+		{
+			for (size_t i = firstNested; i < unknownFields->size(); i++)
+				(*unknownFields)[i].insert(0, std::string(field.m_Name).append(1, '.'));
+		}
+	}
+
+	std::array<JSONField<T>, FieldCount> m_Fields;
+};
+
+template<class T, class... Fields> JSONSchema<T, sizeof...(Fields)> MakeJSONSchema(const Fields&... fields)
+{
+	return JSONSchema<T, sizeof...(Fields)>(std::array<JSONField<T>, sizeof...(Fields)>{ { fields... } });
+}
@@ -0,0 +1,375 @@
+#include "stdafx.h"
+#include "JSONStructuralIndex.h"
+
+#include "JSON.h"
+
+#if JSON_SIMD_AVX2
+#include <immintrin.h>
+#elif JSON_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static __forceinline uint32_t CountTrailingZeros(uint64_t value)
+{
+	assert(value);
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return index;
+#elif defined(_MSC_VER)
+	unsigned long index;
+	if (_BitScanForward(&index, uint32_t(value)))
+		return index;
+
+	_BitScanForward(&index, uint32_t(value >> 32));
+	return index + 32;
+#else
+	return __builtin_ctzll(value);
+#endif
+}
+
+// Bit i of the result is the xor of bits [0, i] of the input, ie. it is set for
+// every character between an opening quote (inclusive) and a closing quote (exclusive).
+static __forceinline uint64_t PrefixXor(uint64_t value)
+{
+	value ^= value << 1;
+	value ^= value << 2;
+	value ^= value << 4;
+	value ^= value << 8;
+	value ^= value << 16;
+	value ^= value << 32;
+	return value;
+}
+
+// Finds every character preceded by an odd-length run of backslashes. Runs are
+// resolved with a single carry-propagating subtraction rather than by scanning
+// backwards from each quote, so long runs of backslashes stay linear.
+// nextIsEscaped carries an unfinished run over to the next block.
+static __forceinline uint64_t FindEscaped(uint64_t backslashes, uint64_t& nextIsEscaped)
+{
+	constexpr uint64_t ODD_BITS = 0xAAAAAAAAAAAAAAAAull;
+
+	if (!backslashes)
+	{
+		const uint64_t escaped = nextIsEscaped;
+		nextIsEscaped = 0;
+		return escaped;
+	}
+
+	// A backslash that is itself escaped can't start an escape sequence
+	const uint64_t potentialEscapes = backslashes & ~nextIsEscaped;
+
+	// Subtracting each run's start bit from the odd-bit pattern flips the run's
+	// parity bits; what's left after the xor marks escape characters and the
+	// character following each odd-length run.
+	const uint64_t escapeAndTerminal = (((potentialEscapes << 1) | ODD_BITS) - potentialEscapes) ^ ODD_BITS;
+	const uint64_t escaped = escapeAndTerminal ^ (backslashes | nextIsEscaped);
+	const uint64_t escapes = escapeAndTerminal & backslashes;
+
+	nextIsEscaped = escapes >> 63;
+	return escaped;
+}
+
+JSONStructuralIndex::BlockMasks JSONStructuralIndex::ClassifyBlock(const char* block)
+{
+	BlockMasks retVal = {};
+
+#if JSON_SIMD_AVX2
+	for (size_t i = 0; i < 64; i += 32)
+	{
+		const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+		const auto matches = [&chunk](char c) { return _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(c)); };
+
+		// '[' and ']' are exactly 0x20 below '{' and '}'
+		const __m256i lowered = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+		const __m256i structurals = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(lowered, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(lowered, _mm256_set1_epi8('}'))),
+			_mm256_or_si256(matches(':'), matches(',')));
+
+		const __m256i whitespace = _mm256_or_si256(
+			_mm256_or_si256(matches(' '), matches('\t')),
+			_mm256_or_si256(matches('\n'), matches('\r')));
+
+		retVal.m_Quotes |= uint64_t(uint32_t(_mm256_movemask_epi8(matches('"')))) << i;
+		retVal.m_Backslashes |= uint64_t(uint32_t(_mm256_movemask_epi8(matches('\\')))) << i;
+		retVal.m_Structurals |= uint64_t(uint32_t(_mm256_movemask_epi8(structurals))) << i;
+		retVal.m_Whitespace |= uint64_t(uint32_t(_mm256_movemask_epi8(whitespace))) << i;
+	}
+#elif JSON_SIMD_SSE2
+	for (size_t i = 0; i < 64; i += 16)
+	{
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+		const auto matches = [&chunk](char c) { return _mm_cmpeq_epi8(chunk, _mm_set1_epi8(c)); };
+
+		// '[' and ']' are exactly 0x20 below '{' and '}'
+		const __m128i lowered = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+		const __m128i structurals = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(lowered, _mm_set1_epi8('{')), _mm_cmpeq_epi8(lowered, _mm_set1_epi8('}'))),
+			_mm_or_si128(matches(':'), matches(',')));
+
+		const __m128i whitespace = _mm_or_si128(
+			_mm_or_si128(matches(' '), matches('\t')),
+			_mm_or_si128(matches('\n'), matches('\r')));
+
+		retVal.m_Quotes |= uint64_t(_mm_movemask_epi8(matches('"'))) << i;
+		retVal.m_Backslashes |= uint64_t(_mm_movemask_epi8(matches('\\'))) << i;
+		retVal.m_Structurals |= uint64_t(_mm_movemask_epi8(structurals)) << i;
+		retVal.m_Whitespace |= uint64_t(_mm_movemask_epi8(whitespace)) << i;
+	}
+#else
+	for (size_t i = 0; i < 64; i++)
+	{
+		const uint64_t bit = uint64_t(1) << i;
+		switch (block[i])
+		{
+		case '"':	retVal.m_Quotes |= bit; break;
+		case '\\':	retVal.m_Backslashes |= bit; break;
+
+		case '{':
+		case '}':
+		case '[':
+		case ']':
+		case ':':
+		case ',':
+			retVal.m_Structurals |= bit;
+			break;
+
+		case ' ':
+		case '\t':
+		case '\n':
+		case '\r':
+			retVal.m_Whitespace |= bit;
+			break;
+		}
+	}
+#endif
+
+	return retVal;
+}
+
+JSONStructuralIndex::JSONStructuralIndex(const std::string_view& str) :
+	m_Source(str)
+{
+	if (str.size() > std::numeric_limits<uint32_t>::max())
+		throw json_parsing_error(StringTools::CSFormat("Document is too large to index ({0} bytes)", str.size()));
+
+	// Rough guess, real-world JSON tends to have a token every 6-10 bytes
+	m_Offsets.reserve(str.size() / 6 + 1);
+
+	uint64_t nextIsEscaped = 0;
+	uint64_t prevInString = 0;
+	uint64_t prevScalar = 0;
+
+	for (size_t base = 0; base < str.size(); base += 64)
+	{
+		// Pad the final partial block with whitespace, which never produces tokens
+		char padded[64];
+		const char* block = str.data() + base;
+		if (str.size() - base < 64)
+		{
+			memset(padded, ' ', sizeof(padded));
+			memcpy(padded, block, str.size() - base);
+			block = padded;
+		}
+
+		const BlockMasks masks = ClassifyBlock(block);
+
+		const uint64_t escaped = FindEscaped(masks.m_Backslashes, nextIsEscaped);
+		const uint64_t quotes = masks.m_Quotes & ~escaped;
+
+		const uint64_t inString = PrefixXor(quotes) ^ prevInString;
+		prevInString = uint64_t(int64_t(inString) >> 63);
+
+		// Anything outside of a string that isn't whitespace, a quote or a structural
+		// character belongs to a number or literal. Only the first character of each
+		// run is interesting.
+		const uint64_t scalars = ~(masks.m_Structurals | masks.m_Whitespace | quotes | inString);
+		const uint64_t scalarStarts = scalars & ~((scalars << 1) | prevScalar);
+		prevScalar = scalars >> 63;
+
+		uint64_t tokens = (masks.m_Structurals & ~inString) | quotes | scalarStarts;
+		while (tokens)
+		{
+			m_Offsets.push_back(uint32_t(base + CountTrailingZeros(tokens)));
+			tokens &= tokens - 1;
+		}
+	}
+
+	if (prevInString)
+	{
+		// The last quote we saw is the one that was never closed
+		const auto lastQuote = std::find_if(m_Offsets.rbegin(), m_Offsets.rend(), [&str](uint32_t offset) { return str[offset] == '"'; });
+		throw json_parsing_error(StringTools::CSFormat("Unterminated string starting at offset {0}", lastQuote != m_Offsets.rend() ? *lastQuote : 0));
+	}
+}
+
+std::string_view JSONStructuralIndex::SkipBOM(const std::string_view& str)
+{
+	constexpr auto BOM = u8"\xEF\xBB\xBF"sv;
+	if (str.substr(0, BOM.size()) == BOM)
+		return str.substr(BOM.size());
+
+	return str;
+}
+
+void JSONStructuralIndex::ValidateUTF8(const std::string_view& source)
+{
+	const size_t invalid = StringTools::UTF8FindInvalid(source);
+	if (invalid != source.npos)
+		Error(source, invalid, "Invalid UTF-8"sv);
+}
+
+// -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+// StringConverter is happy with a lot more than that: nan, inf, ".5", "5.", "01"...
+static bool IsJSONNumber(const std::string_view& str)
+{
+	const auto isDigit = [](char c) { return c >= '0' && c <= '9'; };
+
+	const char* it = str.data();
+	const char* const end = str.data() + str.size();
+
+	if (it != end && *it == '-')
+		++it;
+
+	if (it == end || !isDigit(*it))
+		return false;
+	if (*it++ != '0')
+	{
+		while (it != end && isDigit(*it))
+			++it;
+	}
+
+	if (it != end && *it == '.')
+	{
+		if (++it == end || !isDigit(*it))
+			return false;
+		while (it != end && isDigit(*it))
+			++it;
+	}
+
+	if (it != end && (*it == 'e' || *it == 'E'))
+	{
+		if (++it != end && (*it == '+' || *it == '-'))
+			++it;
+		if (it == end || !isDigit(*it))
+			return false;
+		while (it != end && isDigit(*it))
+			++it;
+	}
+
+	return it == end;
+}
+
+static bool IsMalformedNumber(const std::string_view& scalar)
+{
+	try
+	{
+		JSONStructuralIndex::ParseNumber(scalar);
+		return false;
+	}
+	catch (const json_parsing_error&)
+	{
+		return true;
+	}
+}
+
+void JSONStructuralIndex::UnitTests()
+{
+	assert(ParseNumber("0"sv) == 0);
+	assert(ParseNumber("-0.5e+2"sv) == -50);
+	assert(ParseNumber("10E-1"sv) == 1);
+	assert(ParseNumber("1e-400"sv) == 0);
+
+	for (const std::string_view& scalar : { "nan"sv, "inf"sv, "-Infinity"sv, ".5"sv, "5."sv, "01"sv, "-01"sv,
+		"+1"sv, "0x1p3"sv, "-"sv, "1e"sv, "1e+"sv, "1.e5"sv, "1-"sv })
+	{
+		assert(IsMalformedNumber(scalar));
+	}
+}
+
+double JSONStructuralIndex::ParseNumber(const std::string_view& scalar)
+{
+	if (!IsJSONNumber(scalar))
+		throw json_parsing_error(StringTools::CSFormat("Malformed number \"{0}\"", scalar));
+
+	double retVal;
+	const auto result = StringConverter::Parse(scalar, retVal);
+	if (result.ec == std::errc::result_out_of_range)
+		throw json_parsing_error(StringTools::CSFormat("Number \"{0}\" is out of range", scalar));
+	if (result.ec != std::errc() || result.ptr != scalar.data() + scalar.size())
+		throw json_parsing_error(StringTools::CSFormat("Malformed number \"{0}\"", scalar));
+
+	return retVal;
+}
+
+JSONStructuralIndex::Cursor::Cursor(const JSONStructuralIndex& index) :
+	m_Source(index.m_Source),
+	m_Next(index.m_Offsets.data()),
+	m_End(index.m_Offsets.data() + index.m_Offsets.size())
+{
+}
+
+std::string_view JSONStructuralIndex::Cursor::GatherString(bool* hasEscapes)
+{
+	assert(Peek() == '"');
+	const size_t start = *(m_Next++) + 1;
+
+	// The index always pairs up quotes, so the closing quote is the very next token
+	assert(Peek() == '"');
+	const size_t end = *(m_Next++);
+
+	const std::string_view retVal = m_Source.substr(start, end - start);
+	if (hasEscapes)
+		*hasEscapes = retVal.find('\\') != retVal.npos;
+
+	return retVal;
+}
+
+std::string_view JSONStructuralIndex::Cursor::GatherScalar()
+{
+	assert(!AtEnd());
+	const size_t start = *(m_Next++);
+
+	// Everything up until the next token, minus any whitespace in between
+	size_t end = GetOffset();
+	while (end > start)
+	{
+		const char c = m_Source[end - 1];
+		if (c != ' ' && c != '\t' && c != '\n' && c != '\r')
+			break;
+
+		end--;
+	}
+
+	return m_Source.substr(start, end - start);
+}
+
+void JSONStructuralIndex::Error(const std::string_view& source, size_t offset, const std::string_view& msg)
+{
+	size_t line = 1;
+	size_t column = 1;
+	for (size_t i = 0; i < offset; i++)
+	{
+		if (source[i] == '\n')
+		{
+			line++;
+			column = 1;
+		}
+		else
+			column++;
+	}
+
+	if (offset < source.size())
+		throw json_parsing_error(StringTools::CSFormat("{0} at line {1}, column {2} (found '{3}')", msg, line, column, source[offset]));
+	else
+		throw json_parsing_error(StringTools::CSFormat("{0} at line {1}, column {2} (found end of input)", msg, line, column));
+}
+
+void JSONStructuralIndex::Cursor::Error(const std::string_view& msg) const
+{
+	JSONStructuralIndex::Error(m_Source, GetOffset(), msg);
+}
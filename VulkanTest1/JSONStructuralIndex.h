@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#if defined(__AVX2__)
+#define JSON_SIMD_AVX2 1
+#elif defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSON_SIMD_SSE2 1
+#endif
+
+// First pass over a JSON document. Classifies the input 64 bytes at a time
+// (SSE2/AVX2 when available) and records the offset of every token start:
+// structural characters outside of strings, both quotes of every string, and
+// the first character of every number/literal. The parsers then walk this
+// list instead of scanning whitespace and string contents byte by byte.
+class JSONStructuralIndex
+{
+public:
+	JSONStructuralIndex(const std::string_view& str);
+
+	const std::string_view& GetSource() const { return m_Source; }
+	const std::vector<uint32_t>& GetOffsets() const { return m_Offsets; }
+
+	struct BlockMasks
+	{
+		uint64_t m_Quotes;
+		uint64_t m_Backslashes;
+		uint64_t m_Structurals;
+		uint64_t m_Whitespace;
+	};
+
+	// Bit i of each mask corresponds to block[i]. block must have 64 readable bytes.
+	static BlockMasks ClassifyBlock(const char* block);
+
+	// Strips the UTF-8 BOM some editors like to insert
+	static std::string_view SkipBOM(const std::string_view& str);
+
+	// Throws json_parsing_error at the first byte of source that isn't valid UTF-8.
+	// Only done for files, strings built in code are trusted.
+	static void ValidateUTF8(const std::string_view& source);
+
+	// Converts the text returned by Cursor::GatherScalar. Throws json_parsing_error
+	// if it isn't a complete number, exactly as JSON spells them.
+	static double ParseNumber(const std::string_view& scalar);
+
+	static void UnitTests();
+
+	// Throws json_parsing_error with msg and the line/column of offset in source.
+	[[noreturn]] static void Error(const std::string_view& source, size_t offset, const std::string_view& msg);
+
+	class Cursor
+	{
+	public:
+		Cursor(const JSONStructuralIndex& index);
+
+		// Current token character, or '\0' once every token has been consumed.
+		char Peek() const { return m_Next != m_End ? m_Source[*m_Next] : '\0'; }
+		size_t GetOffset() const { return m_Next != m_End ? *m_Next : m_Source.size(); }
+		bool AtEnd() const { return m_Next == m_End; }
+
+		void Advance() { m_Next++; }
+
+		// Current token must be an opening quote. Returns the raw (still escaped)
+		// string contents and moves past the closing quote.
+		std::string_view GatherString(bool* hasEscapes = nullptr);
+
+		// Current token must be the start of a number or literal. Returns its text
+		// and moves past it.
+		std::string_view GatherScalar();
+
+		[[noreturn]] void Error(const std::string_view& msg) const;
+
+	private:
+		std::string_view m_Source;
+		const uint32_t* m_Next;
+		const uint32_t* m_End;
+	};
+
+private:
+	std::string_view m_Source;
+	std::vector<uint32_t> m_Offsets;
+};
@@ -0,0 +1,507 @@
+#include "stdafx.h"
+#include "JSONTape.h"
+
+#include "JSONDocument.h"
+#include "JSONStructuralIndex.h"
+
+#include <algorithm>
+
+class JSONTapeDocument::Parser
+{
+public:
+	Parser(const JSONStructuralIndex& index, Entry* entries, uint32_t* keyTable, char* strings);
+
+	void ParseRoot();
+
+private:
+	static constexpr size_t MAX_DEPTH = 512;
+
+	void ParseValue();
+	void ParseObject();
+	void ParseArray();
+	void ParseString();
+	void ParseScalar();
+
+	void Expect(char c);
+
+	JSONStructuralIndex::Cursor m_Cursor;
+	size_t m_Depth = 0;
+
+	Entry* m_Entries;
+	uint32_t m_NextEntry = 0;
+
+	uint32_t* m_KeyTable;
+	uint32_t m_NextKey = 0;
+
+	char* m_NextString;
+
+	// Key offsets of the objects currently being parsed, innermost last
+	std::vector<uint32_t> m_PendingKeys;
+};
+
+JSONTapeDocument::JSONTapeDocument(const std::string_view& str)
+{
+	const std::string_view source = JSONStructuralIndex::SkipBOM(str);
+
+	const JSONStructuralIndex index(source);
+
+	// Every value and key starts at a different token, so the token count bounds
+	// both the tape and the key table. Decoded strings are never longer than their
+	// quoted source text, so that bounds the string storage (terminators included).
+	const size_t tokenCount = index.GetOffsets().size();
+	const size_t entryBytes = tokenCount * sizeof(Entry);
+	const size_t keyTableBytes = tokenCount * sizeof(uint32_t);
+	m_Arena = std::make_unique<char[]>(entryBytes + keyTableBytes + source.size());
+
+	Entry* entries = reinterpret_cast<Entry*>(m_Arena.get());
+	uint32_t* keyTable = reinterpret_cast<uint32_t*>(m_Arena.get() + entryBytes);
+	char* strings = m_Arena.get() + entryBytes + keyTableBytes;
+
+	Parser(index, entries, keyTable, strings).ParseRoot();
+
+	m_Entries = entries;
+	m_KeyTable = keyTable;
+}
+
+JSONTapeValue JSONTapeDocument::GetRoot() const
+{
+	return JSONTapeValue(m_Entries, m_KeyTable);
+}
+
+JSONTapeObject JSONTapeDocument::GetObject() const
+{
+	return GetRoot().GetObject();
+}
+
+JSONTapeArray JSONTapeDocument::GetArray() const
+{
+	return GetRoot().GetArray();
+}
+
+JSONTapeDocument::Parser::Parser(const JSONStructuralIndex& index, Entry* entries, uint32_t* keyTable, char* strings) :
+	m_Cursor(index),
+	m_Entries(entries),
+	m_KeyTable(keyTable),
+	m_NextString(strings)
+{
+}
+
+void JSONTapeDocument::Parser::ParseRoot()
+{
+	ParseValue();
+
+	if (!m_Cursor.AtEnd())
+		m_Cursor.Error("Unexpected data after the root value");
+}
+
+void JSONTapeDocument::Parser::ParseValue()
+{
+	switch (m_Cursor.Peek())
+	{
+	case '{':	return ParseObject();
+	case '[':	return ParseArray();
+	case '"':	return ParseString();
+
+	case '}':
+	case ']':
+	case ',':
+	case ':':
+	case '\0':
+		m_Cursor.Error("Expected a value");
+
+	default:
+		return ParseScalar();
+	}
+}
+
+void JSONTapeDocument::Parser::ParseObject()
+{
+	Expect('{');
+
+	if (++m_Depth > MAX_DEPTH)
+		m_Cursor.Error("Maximum nesting depth exceeded");
+
+	const uint32_t header = m_NextEntry++;
+	const size_t firstPendingKey = m_PendingKeys.size();
+
+	if (m_Cursor.Peek() == '}')
+		m_Cursor.Advance();
+	else
+	{
+		while (true)
+		{
+			if (m_Cursor.Peek() != '"')
+				m_Cursor.Error("Expected '\"'");
+
+			m_PendingKeys.push_back(m_NextEntry - header);
+			ParseString();
+			Expect(':');
+			ParseValue();
+
+			if (m_Cursor.Peek() == ',')
+				m_Cursor.Advance();
+			else
+			{
+				Expect('}');
+				break;
+			}
+		}
+	}
+
+	const auto keysBegin = m_PendingKeys.begin() + firstPendingKey;
+	const uint32_t count = uint32_t(m_PendingKeys.end() - keysBegin);
+
+	Entry& entry = m_Entries[header];
+	entry.m_Type = JSONDataType::Object;
+	entry.m_Size = count;
+	entry.m_Container.m_Skip = m_NextEntry - header;
+	entry.m_Container.m_SortedKeys = NO_SORTED_KEYS;
+
+	if (count >= SORTED_KEYS_THRESHOLD)
+	{
+		uint32_t* sortedKeys = m_KeyTable + m_NextKey;
+		std::copy(keysBegin, m_PendingKeys.end(), sortedKeys);
+
+		// Stable so that lookups find the first of any duplicate keys, same as a linear scan
+		const Entry* headerPtr = &entry;
+		std::stable_sort(sortedKeys, sortedKeys + count, [headerPtr](uint32_t lhs, uint32_t rhs)
+		{
+			return std::string_view(headerPtr[lhs].m_String, headerPtr[lhs].m_Size) <
+				std::string_view(headerPtr[rhs].m_String, headerPtr[rhs].m_Size);
+		});
+
+		entry.m_Container.m_SortedKeys = m_NextKey;
+		m_NextKey += count;
+	}
+
+	m_PendingKeys.erase(keysBegin, m_PendingKeys.end());
+	m_Depth--;
+}
+
+void JSONTapeDocument::Parser::ParseArray()
+{
+	Expect('[');
+
+	if (++m_Depth > MAX_DEPTH)
+		m_Cursor.Error("Maximum nesting depth exceeded");
+
+	const uint32_t header = m_NextEntry++;
+	uint32_t count = 0;
+
+	if (m_Cursor.Peek() == ']')
+		m_Cursor.Advance();
+	else
+	{
+		while (true)
+		{
+			ParseValue();
+			count++;
+
+			if (m_Cursor.Peek() == ',')
+				m_Cursor.Advance();
+			else
+			{
+				Expect(']');
+				break;
+			}
+		}
+	}
+
+	Entry& entry = m_Entries[header];
+	entry.m_Type = JSONDataType::Array;
+	entry.m_Size = count;
+	entry.m_Container.m_Skip = m_NextEntry - header;
+	entry.m_Container.m_SortedKeys = NO_SORTED_KEYS;
+
+	m_Depth--;
+}
+
+void JSONTapeDocument::Parser::ParseString()
+{
+	bool hasEscapes;
+	const auto raw = m_Cursor.GatherString(&hasEscapes);
+
+	char* const str = m_NextString;
+	size_t length;
+	if (hasEscapes)
+	{
+		const std::string decoded = JSONViewString::Decode(raw);
+		length = decoded.size();
+		memcpy(str, decoded.data(), length);
+	}
+	else
+	{
+		length = raw.size();
+		memcpy(str, raw.data(), length);
+	}
+
+	str[length] = '\0';
+	m_NextString += length + 1;
+
+	Entry& entry = m_Entries[m_NextEntry++];
+	entry.m_Type = JSONDataType::String;
+	entry.m_Size = uint32_t(length);
+	entry.m_String = str;
+}
+
+void JSONTapeDocument::Parser::ParseScalar()
+{
+	const auto scalar = m_Cursor.GatherScalar();
+
+	Entry& entry = m_Entries[m_NextEntry++];
+	entry.m_Size = 0;
+	if (scalar == "true"sv || scalar == "false"sv)
+	{
+		entry.m_Type = JSONDataType::Bool;
+		entry.m_Bool = scalar == "true"sv;
+	}
+	else if (scalar == "null"sv)
+	{
+		entry.m_Type = JSONDataType::Null;
+		entry.m_String = nullptr;
+	}
+	else
+	{
+		entry.m_Type = JSONDataType::Number;
+		entry.m_Number = JSONStructuralIndex::ParseNumber(scalar);
+	}
+}
+
+void JSONTapeDocument::Parser::Expect(char c)
+{
+	if (m_Cursor.Peek() != c)
+		m_Cursor.Error(StringTools::CSFormat("Expected '{0}'", c));
+
+	m_Cursor.Advance();
+}
+
+const JSONTapeDocument::Entry* JSONTapeValue::CheckType(const JSONTapeDocument::Entry* entry, JSONDataType type, const char* fnName)
+{
+	if (!entry)
+		throw std::runtime_error("Accessing empty JSONTapeValue");
+
+	if (entry->m_Type != type)
+		throw json_value_type_error(StringTools::CSFormat("Attempted to call {0}(), but data type was {1}.", fnName, entry->m_Type));
+
+	return entry;
+}
+
+double JSONTapeValue::GetNumber() const
+{
+	return CheckType(m_Entry, JSONDataType::Number, __FUNCTION__)->m_Number;
+}
+
+bool JSONTapeValue::GetBool() const
+{
+	return CheckType(m_Entry, JSONDataType::Bool, __FUNCTION__)->m_Bool;
+}
+
+std::string_view JSONTapeValue::GetString() const
+{
+	const auto entry = CheckType(m_Entry, JSONDataType::String, __FUNCTION__);
+	return std::string_view(entry->m_String, entry->m_Size);
+}
+
+JSONTapeArray JSONTapeValue::GetArray() const
+{
+	return JSONTapeArray(CheckType(m_Entry, JSONDataType::Array, __FUNCTION__), m_KeyTable);
+}
+
+JSONTapeObject JSONTapeValue::GetObject() const
+{
+	return JSONTapeObject(CheckType(m_Entry, JSONDataType::Object, __FUNCTION__), m_KeyTable);
+}
+
+JSONDataType JSONTapeValue::GetType() const
+{
+	if (!m_Entry)
+		throw std::runtime_error("Accessing empty JSONTapeValue");
+
+	return m_Entry->m_Type;
+}
+
+const JSONTapeDocument::Entry* JSONTapeValue::GetNext() const
+{
+	if (m_Entry->m_Type == JSONDataType::Array || m_Entry->m_Type == JSONDataType::Object)
+		return m_Entry + m_Entry->m_Container.m_Skip;
+
+	return m_Entry + 1;
+}
+
+JSONTapeArray::iterator JSONTapeArray::begin() const
+{
+	return iterator(JSONTapeValue(m_Header ? m_Header + 1 : nullptr, m_KeyTable));
+}
+
+JSONTapeArray::iterator JSONTapeArray::end() const
+{
+	return iterator(JSONTapeValue(m_Header ? m_Header + m_Header->m_Container.m_Skip : nullptr, m_KeyTable));
+}
+
+JSONTapeValue JSONTapeArray::operator[](size_t index) const
+{
+	if (index >= size())
+		throw std::out_of_range(StringTools::CSFormat("Index {0} is out of range for an array of size {1}", index, size()));
+
+	auto it = begin();
+	std::advance(it, index);
+	return *it;
+}
+
+JSONTapeObject::iterator::value_type JSONTapeObject::iterator::operator*() const
+{
+	return std::make_pair(std::string_view(m_Key->m_String, m_Key->m_Size), JSONTapeValue(m_Key + 1, m_KeyTable));
+}
+
+JSONTapeObject::iterator& JSONTapeObject::iterator::operator++()
+{
+	m_Key = JSONTapeValue(m_Key + 1, m_KeyTable).GetNext();
+	return *this;
+}
+
+JSONTapeObject::iterator JSONTapeObject::begin() const
+{
+	return iterator(m_Header ? m_Header + 1 : nullptr, m_KeyTable);
+}
+
+JSONTapeObject::iterator JSONTapeObject::end() const
+{
+	return iterator(m_Header ? m_Header + m_Header->m_Container.m_Skip : nullptr, m_KeyTable);
+}
+
+JSONTapeValue JSONTapeObject::TryGetValue(const std::string_view& name) const
+{
+	if (!m_Header)
+		return JSONTapeValue();
+
+	if (m_Header->m_Container.m_SortedKeys != JSONTapeDocument::NO_SORTED_KEYS)
+	{
+		const uint32_t* sortedBegin = m_KeyTable + m_Header->m_Container.m_SortedKeys;
+		const uint32_t* sortedEnd = sortedBegin + m_Header->m_Size;
+
+		const auto header = m_Header;
+		const auto getKey = [header](uint32_t offset) { return std::string_view(header[offset].m_String, header[offset].m_Size); };
+
+		const auto found = std::lower_bound(sortedBegin, sortedEnd, name,
+			[&getKey](uint32_t offset, const std::string_view& name) { return getKey(offset) < name; });
+
+		if (found != sortedEnd && getKey(*found) == name)
+			return JSONTapeValue(m_Header + *found + 1, m_KeyTable);
+
+		return JSONTapeValue();
+	}
+
+	for (auto it = begin(); it != end(); ++it)
+	{
+		const auto pair = *it;
+		if (pair.first == name)
+			return pair.second;
+	}
+
+	return JSONTapeValue();
+}
+
+double JSONTapeObject::TryGetNumber(const std::string_view& name, double defaultValue, bool* success) const
+{
+	const auto found = TryGetValue(name);
+	if (success)
+		*success = !!found;
+
+	return found ? found.GetNumber() : defaultValue;
+}
+
+bool JSONTapeObject::TryGetBool(const std::string_view& name, bool defaultValue, bool* success) const
+{
+	const auto found = TryGetValue(name);
+	if (success)
+		*success = !!found;
+
+	return found ? found.GetBool() : defaultValue;
+}
+
+std::string_view JSONTapeObject::TryGetString(const std::string_view& name, const std::string_view& defaultValue, bool* success) const
+{
+	const auto found = TryGetValue(name);
+	if (success)
+		*success = !!found;
+
+	return found ? found.GetString() : defaultValue;
+}
+
+const double* JSONTapeObject::TryGetNumber(const std::string_view& name) const
+{
+	const auto found = TryGetValue(name);
+	return found ? &JSONTapeValue::CheckType(found.m_Entry, JSONDataType::Number, __FUNCTION__)->m_Number : nullptr;
+}
+
+const bool* JSONTapeObject::TryGetBool(const std::string_view& name) const
+{
+	const auto found = TryGetValue(name);
+	return found ? &JSONTapeValue::CheckType(found.m_Entry, JSONDataType::Bool, __FUNCTION__)->m_Bool : nullptr;
+}
+
+std::optional<std::string_view> JSONTapeObject::TryGetString(const std::string_view& name) const
+{
+	const auto found = TryGetValue(name);
+	return found ? std::make_optional(found.GetString()) : std::nullopt;
+}
+
+JSONTapeArray JSONTapeObject::TryGetArray(const std::string_view& name) const
+{
+	const auto found = TryGetValue(name);
+	return found ? found.GetArray() : JSONTapeArray();
+}
+
+JSONTapeObject JSONTapeObject::TryGetObject(const std::string_view& name) const
+{
+	const auto found = TryGetValue(name);
+	return found ? found.GetObject() : JSONTapeObject();
+}
+
+double JSONTapeObject::GetNumber(const std::string_view& name) const
+{
+	if (auto found = TryGetValue(name))
+		return found.GetNumber();
+
+	throw json_value_missing_error(StringTools::CSFormat("Missing required number value {0}", name));
+}
+
+bool JSONTapeObject::GetBool(const std::string_view& name) const
+{
+	if (auto found = TryGetValue(name))
+		return found.GetBool();
+
+	throw json_value_missing_error(StringTools::CSFormat("Missing required boolean value {0}", name));
+}
+
+std::string_view JSONTapeObject::GetString(const std::string_view& name) const
+{
+	if (auto found = TryGetValue(name))
+		return found.GetString();
+
+	throw json_value_missing_error(StringTools::CSFormat("Missing required string value {0}", name));
+}
+
+JSONTapeArray JSONTapeObject::GetArray(const std::string_view& name) const
+{
+	if (auto found = TryGetValue(name))
+		return found.GetArray();
+
+	throw json_value_missing_error(StringTools::CSFormat("Missing required array value {0}", name));
+}
+
+JSONTapeObject JSONTapeObject::GetObject(const std::string_view& name) const
+{
+	if (auto found = TryGetValue(name))
+		return found.GetObject();
+
+	throw json_value_missing_error(StringTools::CSFormat("Missing required object value {0}", name));
+}
+
+JSONTapeValue JSONTapeObject::GetValue(const std::string_view& name) const
+{
+	if (auto found = TryGetValue(name))
+		return found;
+
+	throw json_value_missing_error(StringTools::CSFormat("Missing required value {0}", name));
+}
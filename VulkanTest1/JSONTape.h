@@ -0,0 +1,223 @@
+#pragma once
+#include "JSON.h"
+
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+class JSONTapeArray;
+class JSONTapeObject;
+class JSONTapeValue;
+
+// A whole document flattened into an array of fixed-size entries (the "tape"),
+// with every decoded string packed in behind it, all in a single allocation.
+// Arrays and objects are a header entry followed directly by their contents,
+// so walking the document never chases pointers, and freeing it is one delete.
+// Built by JSONSerializer::FromFileTape or FromStringTape.
+class JSONTapeDocument
+{
+public:
+	JSONTapeDocument(const JSONTapeDocument& other) = delete;
+	JSONTapeDocument(JSONTapeDocument&& other) = default;
+	JSONTapeDocument& operator=(const JSONTapeDocument& other) = delete;
+	JSONTapeDocument& operator=(JSONTapeDocument&& other) = default;
+
+	JSONTapeValue GetRoot() const;
+	JSONTapeObject GetObject() const;
+	JSONTapeArray GetArray() const;
+
+	// Objects with at least this many keys get a sorted key table and are searched
+	// with a binary search. Anything smaller is faster to just scan.
+	static constexpr uint32_t SORTED_KEYS_THRESHOLD = 16;
+
+private:
+	JSONTapeDocument(const std::string_view& str);
+	friend class JSONSerializer;
+	friend class JSONTapeValue;
+	friend class JSONTapeArray;
+	friend class JSONTapeObject;
+
+	class Parser;
+
+	struct Entry
+	{
+		JSONDataType m_Type;
+
+		// Length for strings, element/member count for arrays and objects
+		uint32_t m_Size;
+
+		union
+		{
+			double m_Number;
+			bool m_Bool;
+			const char* m_String;
+
+			struct
+			{
+				// Distance to the entry following the last one in this container
+				uint32_t m_Skip;
+
+				// Index of this object's run in the key table, or NO_SORTED_KEYS
+				uint32_t m_SortedKeys;
+			} m_Container;
+		};
+	};
+	static_assert(sizeof(Entry) == 16);
+
+	static constexpr uint32_t NO_SORTED_KEYS = std::numeric_limits<uint32_t>::max();
+
+	std::unique_ptr<char[]> m_Arena;
+	const Entry* m_Entries = nullptr;
+
+	// Offsets of key entries relative to their object header, sorted by key text
+	const uint32_t* m_KeyTable = nullptr;
+};
+
+class JSONTapeValue
+{
+public:
+	JSONTapeValue() = default;
+
+	// False for the empty value returned by the TryGet* functions
+	explicit operator bool() const { return !!m_Entry; }
+
+	double GetNumber() const;
+	bool GetBool() const;
+	std::string_view GetString() const;
+	JSONTapeArray GetArray() const;
+	JSONTapeObject GetObject() const;
+
+	JSONDataType GetType() const;
+
+private:
+	JSONTapeValue(const JSONTapeDocument::Entry* entry, const uint32_t* keyTable) : m_Entry(entry), m_KeyTable(keyTable) { }
+	friend class JSONTapeDocument;
+	friend class JSONTapeArray;
+	friend class JSONTapeObject;
+
+	// Entry following this value and everything inside it
+	const JSONTapeDocument::Entry* GetNext() const;
+
+	static const JSONTapeDocument::Entry* CheckType(const JSONTapeDocument::Entry* entry, JSONDataType type, const char* fnName);
+
+	const JSONTapeDocument::Entry* m_Entry = nullptr;
+	const uint32_t* m_KeyTable = nullptr;
+};
+
+// Elements are variable-length on the tape, so indexing is linear. Prefer iterating.
+class JSONTapeArray
+{
+public:
+	class iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = JSONTapeValue;
+		using difference_type = ptrdiff_t;
+		using pointer = const JSONTapeValue*;
+		using reference = JSONTapeValue;
+
+		JSONTapeValue operator*() const { return m_Value; }
+		const JSONTapeValue* operator->() const { return &m_Value; }
+		iterator& operator++() { m_Value.m_Entry = m_Value.GetNext(); return *this; }
+		iterator operator++(int) { iterator retVal(*this); ++(*this); return retVal; }
+
+		bool operator==(const iterator& other) const { return m_Value.m_Entry == other.m_Value.m_Entry; }
+		bool operator!=(const iterator& other) const { return !operator==(other); }
+
+	private:
+		iterator(const JSONTapeValue& value) : m_Value(value) { }
+		friend class JSONTapeArray;
+
+		JSONTapeValue m_Value;
+	};
+
+	JSONTapeArray() = default;
+
+	explicit operator bool() const { return !!m_Header; }
+
+	size_t size() const { return m_Header ? m_Header->m_Size : 0; }
+	bool empty() const { return !size(); }
+
+	iterator begin() const;
+	iterator end() const;
+
+	JSONTapeValue operator[](size_t index) const;
+
+private:
+	JSONTapeArray(const JSONTapeDocument::Entry* header, const uint32_t* keyTable) : m_Header(header), m_KeyTable(keyTable) { }
+	friend class JSONTapeValue;
+
+	const JSONTapeDocument::Entry* m_Header = nullptr;
+	const uint32_t* m_KeyTable = nullptr;
+};
+
+class JSONTapeObject
+{
+public:
+	class iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = std::pair<std::string_view, JSONTapeValue>;
+		using difference_type = ptrdiff_t;
+		using pointer = const value_type*;
+		using reference = value_type;
+
+		value_type operator*() const;
+		iterator& operator++();
+		iterator operator++(int) { iterator retVal(*this); ++(*this); return retVal; }
+
+		bool operator==(const iterator& other) const { return m_Key == other.m_Key; }
+		bool operator!=(const iterator& other) const { return !operator==(other); }
+
+	private:
+		iterator(const JSONTapeDocument::Entry* key, const uint32_t* keyTable) : m_Key(key), m_KeyTable(keyTable) { }
+		friend class JSONTapeObject;
+
+		const JSONTapeDocument::Entry* m_Key;
+		const uint32_t* m_KeyTable;
+	};
+
+	JSONTapeObject() = default;
+
+	explicit operator bool() const { return !!m_Header; }
+
+	size_t size() const { return m_Header ? m_Header->m_Size : 0; }
+	bool empty() const { return !size(); }
+
+	iterator begin() const;
+	iterator end() const;
+
+	double TryGetNumber(const std::string_view& name, double defaultValue, bool* success = nullptr) const;
+	bool TryGetBool(const std::string_view& name, bool defaultValue, bool* success = nullptr) const;
+	std::string_view TryGetString(const std::string_view& name, const std::string_view& defaultValue, bool* success = nullptr) const;
+
+	// These return nullptr/std::nullopt or an empty value if the key doesn't exist
+	const double* TryGetNumber(const std::string_view& name) const;
+	const bool* TryGetBool(const std::string_view& name) const;
+	std::optional<std::string_view> TryGetString(const std::string_view& name) const;
+	JSONTapeArray TryGetArray(const std::string_view& name) const;
+	JSONTapeObject TryGetObject(const std::string_view& name) const;
+	JSONTapeValue TryGetValue(const std::string_view& name) const;
+
+	///////////////////////////////////////////////////////////////////
+	// These throw json_value_missing_error or json_value_type_error //
+	///////////////////////////////////////////////////////////////////
+	double GetNumber(const std::string_view& name) const;
+	bool GetBool(const std::string_view& name) const;
+	std::string_view GetString(const std::string_view& name) const;
+	JSONTapeArray GetArray(const std::string_view& name) const;
+	JSONTapeObject GetObject(const std::string_view& name) const;
+	JSONTapeValue GetValue(const std::string_view& name) const;
+
+private:
+	JSONTapeObject(const JSONTapeDocument::Entry* header, const uint32_t* keyTable) : m_Header(header), m_KeyTable(keyTable) { }
+	friend class JSONTapeValue;
+
+	const JSONTapeDocument::Entry* m_Header = nullptr;
+	const uint32_t* m_KeyTable = nullptr;
+};
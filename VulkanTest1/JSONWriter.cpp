@@ -0,0 +1,204 @@
+#include "stdafx.h"
+#include "JSONWriter.h"
+
+#include "StringConverter.h"
+
+#include <cmath>
+
+void JSONWriter::StartObject()
+{
+	BeforeValue();
+	m_Buffer += '{';
+	m_Scopes.push_back({ true, true });
+}
+
+void JSONWriter::EndObject()
+{
+	assert(!m_Scopes.empty() && m_Scopes.back().m_IsObject && !m_AfterKey);
+
+	const bool empty = m_Scopes.back().m_Empty;
+	m_Scopes.pop_back();
+	if (!empty)
+		NewLine();
+
+	m_Buffer += '}';
+}
+
+void JSONWriter::StartArray()
+{
+	BeforeValue();
+	m_Buffer += '[';
+	m_Scopes.push_back({ false, true });
+}
+
+void JSONWriter::EndArray()
+{
+	assert(!m_Scopes.empty() && !m_Scopes.back().m_IsObject);
+
+	const bool empty = m_Scopes.back().m_Empty;
+	m_Scopes.pop_back();
+	if (!empty)
+		NewLine();
+
+	m_Buffer += ']';
+}
+
+void JSONWriter::Key(const std::string_view& name)
+{
+	assert(!m_Scopes.empty() && m_Scopes.back().m_IsObject && !m_AfterKey);
+
+	BeforeElement();
+	WriteEscaped(name);
+	m_Buffer += m_Minified ? ":"sv : ": "sv;
+	m_AfterKey = true;
+}
+
+void JSONWriter::String(const std::string_view& str)
+{
+	BeforeValue();
+	WriteEscaped(str);
+}
+
+void JSONWriter::Number(double number)
+{
+	BeforeValue();
+
+	// JSON has no way to represent these
+	if (!std::isfinite(number))
+	{
+		m_Buffer += "null"sv;
+		return;
+	}
+
+	char buffer[32];
+	const auto result = StringConverter::Format(buffer, std::end(buffer), number);
+	assert(result.ec == std::errc());
+
+	m_Buffer.append(buffer, result.ptr);
+}
+
+void JSONWriter::Bool(bool boolean)
+{
+	BeforeValue();
+	m_Buffer += boolean ? "true"sv : "false"sv;
+}
+
+void JSONWriter::Null()
+{
+	BeforeValue();
+	m_Buffer += "null"sv;
+}
+
+void JSONWriter::Value(const JSONValue& value)
+{
+	switch (value.GetType())
+	{
+	case JSONDataType::Number:	return Number(value.GetNumber());
+	case JSONDataType::String:	return String(value.GetString());
+	case JSONDataType::Bool:	return Bool(value.GetBool());
+	case JSONDataType::Null:	return Null();
+
+	case JSONDataType::Array:
+		StartArray();
+		for (const auto& element : value.GetArray())
+			Value(element);
+
+		return EndArray();
+
+	case JSONDataType::Object:
+		StartObject();
+		for (const auto& member : value.GetObject())
+		{
+			Key(member.first);
+			Value(member.second);
+		}
+
+		return EndObject();
+	}
+
+	throw json_value_type_error(StringTools::CSFormat("Unable to write a value of type {0}", value.GetType()));
+}
+
+void JSONWriter::Clear()
+{
+	m_Buffer.clear();
+	m_Scopes.clear();
+	m_AfterKey = false;
+}
+
+void JSONWriter::BeforeValue()
+{
+	if (m_AfterKey)
+	{
+		m_AfterKey = false;
+		return;
+	}
+
+	if (m_Scopes.empty())
+	{
+		assert(m_Buffer.empty());	// Only one root value per document
+		return;
+	}
+
+	assert(!m_Scopes.back().m_IsObject);
+	BeforeElement();
+}
+
+void JSONWriter::BeforeElement()
+{
+	Scope& scope = m_Scopes.back();
+	if (!scope.m_Empty)
+		m_Buffer += ',';
+
+	scope.m_Empty = false;
+	NewLine();
+}
+
+void JSONWriter::NewLine()
+{
+	if (m_Minified)
+		return;
+
+	m_Buffer += '\n';
+	m_Buffer.append(m_Scopes.size(), '\t');
+}
+
+void JSONWriter::WriteEscaped(const std::string_view& str)
+{
+	static constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+	m_Buffer.reserve(m_Buffer.size() + str.size() + 2);
+	m_Buffer += '"';
+
+	// Copy everything that doesn't need escaping in runs
+	size_t runStart = 0;
+	for (size_t i = 0; i < str.size(); i++)
+	{
+		const unsigned char c = str[i];
+		if (c >= 0x20 && c != '"' && c != '\\')
+			continue;
+
+		m_Buffer.append(str.data() + runStart, i - runStart);
+		runStart = i + 1;
+
+		switch (c)
+		{
+		case '"':	m_Buffer += "\\\""sv; break;
+		case '\\':	m_Buffer += "\\\\"sv; break;
+		case '\b':	m_Buffer += "\\b"sv; break;
+		case '\f':	m_Buffer += "\\f"sv; break;
+		case '\n':	m_Buffer += "\\n"sv; break;
+		case '\r':	m_Buffer += "\\r"sv; break;
+		case '\t':	m_Buffer += "\\t"sv; break;
+
+		default:
+			m_Buffer += "\\u00"sv;
+			m_Buffer += HEX_DIGITS[c >> 4];
+			m_Buffer += HEX_DIGITS[c & 0xF];
+			break;
+		}
+	}
+
+	m_Buffer.append(str.data() + runStart, str.size() - runStart);
+	m_Buffer += '"';
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "JSON.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Writes JSON text straight into a growable buffer, either from a JSONValue or
+// one event at a time. Commas, colons and (unless minified) newlines and tab
+// indentation are inserted automatically. Numbers use the shortest text that
+// reads back as exactly the same double.
+//
+//	JSONWriter writer;
+//	writer.StartObject();
+//	writer.Key("frameTime"sv);
+//	writer.Number(16.6);
+//	writer.EndObject();
+//	writer.GetString();		// {"frameTime": 16.6} (with newlines)
+class JSONWriter
+{
+public:
+	JSONWriter(bool minified = false) : m_Minified(minified) { }
+
+	void StartObject();
+	void EndObject();
+	void StartArray();
+	void EndArray();
+
+	// Inside an object, every value must be preceded by a key
+	void Key(const std::string_view& name);
+
+	void String(const std::string_view& str);
+	void Number(double number);
+	void Bool(bool boolean);
+	void Null();
+	void Value(const JSONValue& value);
+
+	const std::string& GetString() const { return m_Buffer; }
+
+	// Starts a new document, keeping the buffer's capacity around for the next one
+	void Clear();
+
+private:
+	struct Scope
+	{
+		bool m_IsObject;
+		bool m_Empty;
+	};
+
+	void BeforeValue();
+	void BeforeElement();
+	void NewLine();
+	void WriteEscaped(const std::string_view& str);
+
+	std::string m_Buffer;
+	std::vector<Scope> m_Scopes;
+	bool m_AfterKey = false;
+	bool m_Minified;
+};
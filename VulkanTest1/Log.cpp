@@ -2,28 +2,56 @@
 #include "Log.h"
 
 #include "Enums.h"
+#include "LogWriter.h"
 
 #include <algorithm>
 #include <clocale>
-#include <codecvt>
-#include "FixedWindows.h"
-#include <locale>
 
-LogType Log::s_Types = (LogType)(~std::underlying_type_t<LogType>(0));
+std::atomic<std::underlying_type_t<LogType>> Log::s_Types = ~std::underlying_type_t<LogType>(0);
 
 void Log::EnableType(LogType type)
 {
-	s_Types = LogType(Enums::value(s_Types) | Enums::value(type));
+	s_Types.fetch_or(Enums::value(type), std::memory_order_relaxed);
 }
 
-bool Log::IsTypeEnabled(LogType type)
+void Log::DisableType(LogType type)
 {
-	return (Enums::value(s_Types) & Enums::value(type)) == Enums::value(type);
+	s_Types.fetch_and(~Enums::value(type), std::memory_order_relaxed);
 }
 
-void Log::DisableType(LogType type)
+static int64_t GetRateLimitTime()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Log::RateLimit::RateLimit(uint32_t burst, std::chrono::nanoseconds refillInterval) :
+	m_Interval(refillInterval.count()),
+	m_Tolerance(refillInterval.count() * std::max<int64_t>(burst, 1))
+{
+}
+
+bool Log::RateLimit::TryAcquire(uint32_t& suppressed)
 {
-	s_Types = LogType(Enums::value(s_Types) & ~Enums::value(type));
+	// Tracks the time the bucket will be full again instead of a token count
+	// (GCRA), so the whole state is one atomic. Each message pushes that time
+	// back by one interval, and it may be at most burst intervals ahead of now.
+	const int64_t now = GetRateLimitTime();
+	int64_t fullTime = m_FullTime.load(std::memory_order_relaxed);
+	while (true)
+	{
+		const int64_t newFullTime = std::max(fullTime, now) + m_Interval;
+		if (newFullTime - now > m_Tolerance)
+		{
+			m_Suppressed.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		if (m_FullTime.compare_exchange_weak(fullTime, newFullTime, std::memory_order_relaxed))
+			break;
+	}
+
+	suppressed = m_Suppressed.exchange(0, std::memory_order_relaxed);
+	return true;
 }
 
 void Log::MsgRaw(LogType type, const std::string& str)
@@ -35,90 +63,84 @@ void Log::MsgRaw(LogType type, const std::string& str)
 	if (!IsTypeEnabled(type))
 		return;
 
-	std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
-	OutputDebugStringW(converter.from_bytes(str).c_str());
+	LogWriter::Instance().Write(str);
 }
 
-void Log::BlockMsgRaw(LogType type, std::string str, size_t charsPerLine)
+void Log::BlockMsgRaw(LogType type, const std::string_view& str, size_t charsPerLine)
 {
 	if (!charsPerLine)
 		throw std::invalid_argument("charsPerLine was 0");
 
+	if (!StringTools::UTF8Validate(str))
+		throw utf8_exception("Block message wasn't valid UTF-8");
+
 	constexpr auto BLOCK_CHAR = u8"█"sv;
 	constexpr auto START_BLOCK_CHARS = u8"\n████ "sv;
 	constexpr auto END_BLOCK_CHARS = u8" ████\n"sv;
 	constexpr auto NEWLINE_BLOCK_CHARS = u8" ████\n████ "sv;
 
-	constexpr size_t ENCODING_ERROR = (size_t)-1;
-	constexpr size_t INCOMPLETE_CHAR = (size_t)-2;
-
-	enum class Wrap
+	// The top border comes first, so measure before building. A line is as wide
+	// as its code point count, up to charsPerLine where it gets wrapped.
+	size_t maxWidth = 0;
+	size_t lineCount = 0;
+	for (size_t lineStart = 0; lineStart <= str.size(); lineCount++)
 	{
-		None,
-		Auto,
-		User,
-	} lastWrap = Wrap::None;
+		const size_t lineEnd = std::min(str.find('\n', lineStart), str.size());
+		const auto line = str.substr(lineStart, lineEnd - lineStart);
+		maxWidth = std::max(maxWidth, StringTools::UTF8FindCodePoint(line, charsPerLine) < line.size() ? charsPerLine : StringTools::UTF8CountCodePoints(line));
+		lineStart = lineEnd + 1;
+	}
 
-	size_t maxWidth = 0;
+	const size_t headerFooterWidth = maxWidth + 10;
+	const size_t maxWrapCount = lineCount + str.size() / charsPerLine;
 
-	str.insert(0, START_BLOCK_CHARS);
+	StringTools::ScratchString scratch;
+	std::string& out = scratch.Get();
+	out.reserve(str.size() + headerFooterWidth * BLOCK_CHAR.size() * 2 + maxWrapCount * NEWLINE_BLOCK_CHARS.size() +
+		START_BLOCK_CHARS.size() + maxWidth + END_BLOCK_CHARS.size() + 1);
 
-	const char* ptr = str.c_str();
-	size_t charsThisLine = 0;					// UTF-8 characters
-	size_t dataIdx = START_BLOCK_CHARS.size();	// Memory offset
-	while (ptr[dataIdx])
+	for (size_t i = 0; i < headerFooterWidth; i++)
+		out += BLOCK_CHAR;
+
+	out += START_BLOCK_CHARS;
+
+	std::string_view lastSegment;
+	for (size_t lineStart = 0; lineStart <= str.size(); )
 	{
-		if (ptr[dataIdx] == '\n')
-		{
-			str.replace(dataIdx, 1, NEWLINE_BLOCK_CHARS);
-			ptr = str.c_str();
-			dataIdx += NEWLINE_BLOCK_CHARS.size();
-			charsThisLine = 0;
-			lastWrap = Wrap::User;
-			continue;
-		}
-		else if (charsThisLine >= charsPerLine)
-		{
-			str.insert(dataIdx, NEWLINE_BLOCK_CHARS);
-			ptr = str.c_str();
-			dataIdx += NEWLINE_BLOCK_CHARS.size();
-			charsThisLine = 0;
-			lastWrap = Wrap::Auto;
-			continue;
-		}
+		const size_t lineEnd = std::min(str.find('\n', lineStart), str.size());
+		auto line = str.substr(lineStart, lineEnd - lineStart);
 
-		if (lastWrap == Wrap::Auto && !charsThisLine && ptr[dataIdx] == ' ')
+		// Wrap every charsPerLine characters, dropping a space at the start of the new line
+		while (true)
 		{
-			str.erase(dataIdx, 1);
-			ptr = str.c_str();
-		}
+			const size_t segmentEnd = StringTools::UTF8FindCodePoint(line, charsPerLine);
+			lastSegment = line.substr(0, segmentEnd);
+			out += lastSegment;
 
-		lastWrap = Wrap::None;
+			line.remove_prefix(segmentEnd);
+			if (line.empty())
+				break;
 
-		std::mbstate_t state = std::mbstate_t();
-		const auto length = StringTools::UTF8Size(&ptr[dataIdx], &ptr[str.size()]);
+			out += NEWLINE_BLOCK_CHARS;
+			if (line.front() == ' ')
+				line.remove_prefix(1);
+		}
 
-		assert(length > 0);
-		charsThisLine++;
-		dataIdx += length;
+		if (lineEnd < str.size())
+			out += NEWLINE_BLOCK_CHARS;
 
-		maxWidth = std::max(maxWidth, charsThisLine);
+		lineStart = lineEnd + 1;
 	}
 
 	// Pad spaces until we reach maxwidth
-	for (size_t i = 0; i < (maxWidth - charsThisLine); i++)
-		str.insert(str.size(), " "sv);
-
-	const size_t headerFooterWidth = maxWidth + 10;
-	for (size_t i = 0; i < headerFooterWidth; i++)
-		str.insert(0, BLOCK_CHAR);
+	out.append(maxWidth - StringTools::UTF8CountCodePoints(lastSegment), ' ');
 
-	str.insert(str.size(), END_BLOCK_CHARS);
+	out += END_BLOCK_CHARS;
 
 	for (size_t i = 0; i < headerFooterWidth; i++)
-		str.insert(str.size(), BLOCK_CHAR);
+		out += BLOCK_CHAR;
 
-	str.insert(str.size(), "\n"sv);
+	out += '\n';
 
-	MsgRaw(type, str);
+	MsgRaw(type, out);
 }
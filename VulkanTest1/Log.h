@@ -1,15 +1,28 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <string>
+#include "BinaryLog.h"
+#include "Enums.h"
 #include "StringTools.h"
 
 enum class LogType
 {
-	Misc,
-	ObjectLifetime,
-	Exception,
+	Misc = 1 << 0,
+	ObjectLifetime = 1 << 1,
+	Exception = 1 << 2,
 };
 
+// Build-time mask of the LogTypes that get compiled in at all. Messages of any
+// other type compile away, nothing in them is ever formatted. Override it in
+// the project's preprocessor definitions, e.g. LOG_COMPILED_TYPES=0x5 to strip
+// ObjectLifetime.
+#ifndef LOG_COMPILED_TYPES
+#define LOG_COMPILED_TYPES (~0u)
+#endif
+
 class Log final
 {
 public:
@@ -18,40 +31,148 @@ public:
 	Log(Log&&) = delete;
 	~Log() = delete;
 
-	template<LogType type = LogType::Misc, class... Args> static void TagMsg(std::string tag, const std::string& fmt, const Args&... args)
+	// Token bucket for messages that could otherwise fire every frame. Holds up
+	// to burst messages, and gets one more back every refillInterval. Declare
+	// one static per call site and pass it as the first argument:
+	//	static Log::RateLimit s_Limit(5, std::chrono::seconds(1));
+	//	Log::Msg(s_Limit, "Lost {0}", name);
+	// The next message to get through says how many were suppressed.
+	class RateLimit
 	{
-		MsgRaw(type, tag.append(StringTools::CSFormat(fmt, args...)).append("\n"sv));
-	}
+	public:
+		RateLimit(uint32_t burst, std::chrono::nanoseconds refillInterval);
+
+		// Returns true if a message can be sent now. If it can, suppressed is
+		// set to the number of messages turned away since the last one.
+		bool TryAcquire(uint32_t& suppressed);
+
+	private:
+		const int64_t m_Interval;
+		const int64_t m_Tolerance;
 
-	template<LogType type = LogType::Misc, class... Args> static void Msg(const char* fmt, const Args&... args)
+		// When the bucket will be full again, in steady_clock ns
+		std::atomic<int64_t> m_FullTime = 0;
+		std::atomic<uint32_t> m_Suppressed = 0;
+	};
+
+	template<LogType type = LogType::Misc, class... Args> static void TagMsg(const std::string_view& tag, const std::string_view& fmt, const Args&... args)
+	{
+		if constexpr (IsTypeCompiled(type))
+		{
+			if (IsTypeEnabled(type))
+				FormatMsg(type, tag, 0, fmt, args...);
+		}
+	}
+	template<LogType type = LogType::Misc, size_t N, class... Args> static void TagMsg(const std::string_view& tag, const StringTools::CSFormatString<N>& fmt, const Args&... args)
 	{
-		MsgRaw(type, StringTools::CSFormat(fmt, args...).append("\n"sv));
+		if constexpr (IsTypeCompiled(type))
+		{
+			if (IsTypeEnabled(type))
+				FormatMsg(type, tag, 0, fmt, args...);
+		}
 	}
+	template<LogType type = LogType::Misc, class Format, class... Args> static void TagMsg(RateLimit& limit, const std::string_view& tag, const Format& fmt, const Args&... args)
+	{
+		if constexpr (IsTypeCompiled(type))
+		{
+			uint32_t suppressed;
+			if (IsTypeEnabled(type) && limit.TryAcquire(suppressed))
+				FormatMsg(type, tag, suppressed, fmt, args...);
+		}
+	}
+
 	template<LogType type = LogType::Misc, class... Args> static void Msg(const std::string_view& fmt, const Args&... args)
 	{
-		MsgRaw(type, StringTools::CSFormat(std::string(fmt).append("\n"sv), args...));
+		if constexpr (IsTypeCompiled(type))
+		{
+			if (IsTypeEnabled(type))
+				FormatMsg(type, std::string_view(), 0, fmt, args...);
+		}
+	}
+	template<LogType type = LogType::Misc, size_t N, class... Args> static void Msg(const StringTools::CSFormatString<N>& fmt, const Args&... args)
+	{
+		if constexpr (IsTypeCompiled(type))
+		{
+			if (IsTypeEnabled(type))
+				FormatMsg(type, std::string_view(), 0, fmt, args...);
+		}
+	}
+	template<LogType type = LogType::Misc, class Format, class... Args> static void Msg(RateLimit& limit, const Format& fmt, const Args&... args)
+	{
+		if constexpr (IsTypeCompiled(type))
+		{
+			uint32_t suppressed;
+			if (IsTypeEnabled(type) && limit.TryAcquire(suppressed))
+				FormatMsg(type, std::string_view(), suppressed, fmt, args...);
+		}
 	}
-	template<LogType type = LogType::Misc, class... Args> static void Msg(std::string fmt, const Args&... args)
+
+	// For high-frequency messages. While a BinaryLog is open, this only records
+	// fmt's ID, a timestamp and the raw arguments, to be decoded later. Otherwise
+	// it's the same as Msg. fmt doesn't have to outlive the call, but string
+	// literals are the cheapest to look up.
+	template<LogType type = LogType::Misc, size_t N, class... Args> static void DeferredMsg(const char(&fmt)[N], const Args&... args)
 	{
-		MsgRaw(type, StringTools::CSFormat(fmt.append("\n"sv, args...)));
+		if constexpr (IsTypeCompiled(type))
+		{
+			if (!IsTypeEnabled(type))
+				return;
+
+			// Only a literal's length is N - 1, a buffer's text can end sooner
+			const char* const terminator = std::char_traits<char>::find(fmt, N - 1, '\0');
+			const std::string_view fmtView(fmt, terminator ? size_t(terminator - fmt) : N - 1);
+
+			if (BinaryLog::IsOpen())
+				BinaryLog::Write(fmtView, args...);
+			else
+				FormatMsg(type, std::string_view(), 0, fmtView, args...);
+		}
 	}
 
 	template<LogType type = LogType::Misc, size_t charsPerLine = 80, class... Args> static void BlockMsg(const char* fmt, const Args&... args)
 	{
-		BlockMsgRaw(type, StringTools::CSFormat(fmt, args...), charsPerLine);
+		if constexpr (IsTypeCompiled(type))
+		{
+			if (IsTypeEnabled(type))
+				BlockMsgRaw(type, StringTools::CSFormat(fmt, args...), charsPerLine);
+		}
 	}
 	template<LogType type = LogType::Misc, size_t charsPerLine = 80, class... Args> static void BlockMsg(const std::string& fmt, const Args&... args)
 	{
-		BlockMsgRaw(type, StringTools::CSFormat(fmt, args...), charsPerLine);
+		if constexpr (IsTypeCompiled(type))
+		{
+			if (IsTypeEnabled(type))
+				BlockMsgRaw(type, StringTools::CSFormat(fmt, args...), charsPerLine);
+		}
 	}
 
+	// Enabled types are checked before any arguments are formatted.
+	static constexpr bool IsTypeCompiled(LogType type) { return (LOG_COMPILED_TYPES & Enums::value(type)) == unsigned(Enums::value(type)); }
+
 	static void EnableType(LogType type);
-	static bool IsTypeEnabled(LogType type);
+	static bool IsTypeEnabled(LogType type)
+	{
+		return (s_Types.load(std::memory_order_relaxed) & Enums::value(type)) == Enums::value(type);
+	}
 	static void DisableType(LogType type);
 
 private:
+	// Formats into the thread's scratch string, so typical messages don't allocate
+	template<class Format, class... Args> static void FormatMsg(LogType type, const std::string_view& tag, uint32_t suppressed, const Format& fmt, const Args&... args)
+	{
+		StringTools::ScratchString str;
+		str.Get().append(tag);
+		StringTools::CSFormatTo(str.Get(), fmt, args...);
+
+		if (suppressed)
+			StringTools::CSFormatTo(str.Get(), " ({0} similar messages suppressed)"sv, suppressed);
+
+		str.Get().append("\n"sv);
+		MsgRaw(type, str.Get());
+	}
+
 	static void MsgRaw(LogType type, const std::string& str);
-	static void BlockMsgRaw(LogType type, std::string str, size_t charsPerLine = 80);
+	static void BlockMsgRaw(LogType type, const std::string_view& str, size_t charsPerLine = 80);
 
-	static LogType s_Types;
-};
\ No newline at end of file
+	static std::atomic<std::underlying_type_t<LogType>> s_Types;
+};
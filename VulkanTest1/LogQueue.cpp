@@ -0,0 +1,77 @@
+#include "stdafx.h"
+#include "LogQueue.h"
+
+#include <cstring>
+
+LogQueue::LogQueue(size_t capacity)
+{
+	size_t roundedCapacity = 2;
+	while (roundedCapacity < capacity)
+		roundedCapacity *= 2;
+
+	m_Slots = std::make_unique<Slot[]>(roundedCapacity);
+	m_Mask = roundedCapacity - 1;
+
+	// Slot i is free for the push at position i
+	for (size_t i = 0; i < roundedCapacity; i++)
+		m_Slots[i].m_Sequence.store(i, std::memory_order_relaxed);
+}
+
+LogQueue::~LogQueue() = default;
+
+bool LogQueue::TryPush(const std::string_view& text)
+{
+	Slot* slot;
+	uint64_t pos = m_WritePos.load(std::memory_order_relaxed);
+	while (true)
+	{
+		slot = &m_Slots[pos & m_Mask];
+
+		const uint64_t sequence = slot->m_Sequence.load(std::memory_order_acquire);
+		const int64_t difference = int64_t(sequence - pos);
+		if (difference == 0)
+		{
+			// Free, try to claim it. On failure pos is updated to the current position.
+			if (m_WritePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (difference < 0)
+		{
+			// Still holding the record from one lap ago
+			return false;
+		}
+		else
+		{
+			// Someone else claimed it first
+			pos = m_WritePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	slot->m_Size = text.size();
+	if (text.size() <= INLINE_TEXT_SIZE)
+		memcpy(slot->m_Text, text.data(), text.size());
+	else
+		slot->m_LongText.assign(text);
+
+	slot->m_Sequence.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+bool LogQueue::TryPop(std::string& output)
+{
+	const uint64_t pos = m_ReadPos.load(std::memory_order_relaxed);
+	Slot& slot = m_Slots[pos & m_Mask];
+
+	if (slot.m_Sequence.load(std::memory_order_acquire) != pos + 1)
+		return false;
+
+	if (slot.m_Size <= INLINE_TEXT_SIZE)
+		output.append(slot.m_Text, slot.m_Size);
+	else
+		output.append(slot.m_LongText);
+
+	// Free for the push one lap from now
+	slot.m_Sequence.store(pos + GetCapacity(), std::memory_order_release);
+	m_ReadPos.store(pos + 1, std::memory_order_release);
+	return true;
+}
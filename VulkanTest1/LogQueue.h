@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Bounded queue of finished log records, written by any number of threads and
+// read by one. Pushing never takes a lock or allocates (unless the record is
+// longer than any previous one that landed in the same slot): a producer claims
+// a slot by advancing the write position, copies its text in, then publishes
+// the slot by bumping its sequence number. This is Dmitry Vyukov's bounded MPMC
+// queue with the consumer side simplified, since only the log writer pops.
+class LogQueue
+{
+public:
+	// Rounded up to a power of 2.
+	LogQueue(size_t capacity);
+	LogQueue(const LogQueue& other) = delete;
+	~LogQueue();
+
+	LogQueue& operator=(const LogQueue& other) = delete;
+
+	size_t GetCapacity() const { return m_Mask + 1; }
+
+	// Returns false if the queue is full.
+	bool TryPush(const std::string_view& text);
+
+	// Appends the oldest record to output. Returns false if there is nothing
+	// (fully written) to pop. Consumer thread only.
+	bool TryPop(std::string& output);
+
+	// Number of pushes that have claimed a slot, ever. A record counted here
+	// may not be poppable yet if its producer is still copying it in.
+	uint64_t GetPushCount() const { return m_WritePos.load(std::memory_order_acquire); }
+	// Number of records popped, ever.
+	uint64_t GetPopCount() const { return m_ReadPos.load(std::memory_order_acquire); }
+
+private:
+	static constexpr size_t INLINE_TEXT_SIZE = 200;
+
+	struct alignas(64) Slot
+	{
+		std::atomic<uint64_t> m_Sequence;
+		size_t m_Size;
+		char m_Text[INLINE_TEXT_SIZE];
+
+		// Records that don't fit inline. Keeps its capacity between uses.
+		std::string m_LongText;
+	};
+
+	std::unique_ptr<Slot[]> m_Slots;
+	size_t m_Mask;
+
+	// Separate cache lines, the producers hammer one and the consumer the other
+	alignas(64) std::atomic<uint64_t> m_WritePos = 0;
+	alignas(64) std::atomic<uint64_t> m_ReadPos = 0;
+};
@@ -0,0 +1,61 @@
+#include "stdafx.h"
+#include "LogSinks.h"
+
+#include <cstdio>
+
+#ifdef _WIN32
+#include "FixedWindows.h"
+#endif
+
+void StdoutLogSink::Write(const std::string_view& text)
+{
+	fwrite(text.data(), sizeof(char), text.size(), stdout);
+}
+
+void StdoutLogSink::Flush()
+{
+	fflush(stdout);
+}
+
+FileLogSink::FileLogSink(const std::filesystem::path& path, bool append)
+{
+	m_File.open(path, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+	if (!m_File.good())
+		throw std::runtime_error(StringTools::CSFormat("Failed to open log file {0}", path));
+}
+
+void FileLogSink::Write(const std::string_view& text)
+{
+	m_File.write(text.data(), text.size());
+}
+
+void FileLogSink::Flush()
+{
+	m_File.flush();
+}
+
+#ifdef _WIN32
+void DebuggerLogSink::Write(const std::string_view& text)
+{
+	if (text.empty())
+		return;
+
+	// One UTF-16 code unit per UTF-8 byte is always enough
+	if (m_WideText.size() < text.size() + 1)
+		m_WideText.resize(text.size() + 1);
+
+	const int length = MultiByteToWideChar(CP_UTF8, 0, text.data(), int(text.size()), m_WideText.data(), int(m_WideText.size()));
+	m_WideText[length] = L'\0';
+
+	OutputDebugStringW(m_WideText.c_str());
+}
+#endif
+
+std::unique_ptr<ILogSink> CreateDefaultLogSink()
+{
+#ifdef _WIN32
+	return std::make_unique<DebuggerLogSink>();
+#else
+	return std::make_unique<StdoutLogSink>();
+#endif
+}
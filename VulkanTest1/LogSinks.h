@@ -0,0 +1,42 @@
+#pragma once
+#include "ILogSink.h"
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+
+class StdoutLogSink : public ILogSink
+{
+public:
+	void Write(const std::string_view& text) override;
+	void Flush() override;
+};
+
+class FileLogSink : public ILogSink
+{
+public:
+	FileLogSink(const std::filesystem::path& path, bool append = false);
+
+	void Write(const std::string_view& text) override;
+	void Flush() override;
+
+private:
+	std::ofstream m_File;
+};
+
+#ifdef _WIN32
+// Shows up in the Visual Studio output window.
+class DebuggerLogSink : public ILogSink
+{
+public:
+	void Write(const std::string_view& text) override;
+
+private:
+	// Reused between writes, so converting to UTF-16 doesn't allocate once it's grown
+	std::wstring m_WideText;
+};
+#endif
+
+// DebuggerLogSink on Windows, StdoutLogSink everywhere else.
+std::unique_ptr<ILogSink> CreateDefaultLogSink();
@@ -0,0 +1,214 @@
+#include "stdafx.h"
+#include "LogWriter.h"
+
+#include "LogQueue.h"
+#include "LogSinks.h"
+
+#include <cstdlib>
+
+static constexpr size_t MAX_BATCH_SIZE = 64 * 1024;
+
+LogWriter::LogWriter()
+{
+	m_Sinks.push_back(CreateDefaultLogSink());
+}
+
+LogWriter& LogWriter::Instance()
+{
+	static LogWriter* s_Instance = new LogWriter();
+	return *s_Instance;
+}
+
+void LogWriter::Start(const LogWriterSettings& settings)
+{
+	std::lock_guard<std::mutex> lock(m_StateMutex);
+	if (IsRunning())
+		throw std::logic_error("LogWriter was already started");
+
+	m_Settings = settings;
+	m_Batch.reserve(MAX_BATCH_SIZE + 1024);
+
+	// Reused after Stop() unless it's too small, see m_Queues
+	if (m_Queues.empty() || m_Queues.back()->GetCapacity() < settings.m_QueueCapacity)
+	{
+		m_Queues.push_back(std::make_unique<LogQueue>(settings.m_QueueCapacity));
+		m_Queue.store(m_Queues.back().get(), std::memory_order_release);
+	}
+
+	{
+		std::lock_guard<std::mutex> writtenLock(m_WrittenMutex);
+		m_WrittenCount = m_Queues.back()->GetPopCount();
+		m_ThreadExited = false;
+	}
+
+	m_Exiting = false;
+	m_Thread = std::thread(&LogWriter::ThreadMain, this);
+	m_Running.store(true, std::memory_order_release);
+
+	// Don't lose whatever's still queued when main() returns
+	static bool s_AtExitRegistered = false;
+	if (!s_AtExitRegistered)
+	{
+		std::atexit([]() { LogWriter::Instance().Stop(); });
+		s_AtExitRegistered = true;
+	}
+}
+
+void LogWriter::Stop()
+{
+	std::lock_guard<std::mutex> lock(m_StateMutex);
+	if (!IsRunning())
+		return;
+
+	// Anything logged from here on goes straight to the sinks
+	m_Running.store(false, std::memory_order_release);
+	m_Exiting = true;
+	m_WakeThread.notify_one();
+	m_Thread.join();
+
+	// Pick up records from threads that were partway through pushing when the thread finished
+	while (WriteBatch())
+		;
+}
+
+void LogWriter::Write(const std::string_view& text)
+{
+	if (!IsRunning())
+		return WriteToSinks(text);
+
+	LogQueue& queue = *m_Queue.load(std::memory_order_acquire);
+	if (queue.TryPush(text))
+	{
+		// Only bother the writer when it's getting full
+		if (queue.GetPushCount() - queue.GetPopCount() >= queue.GetCapacity() / 2)
+			WakeThread();
+
+		return;
+	}
+
+	if (m_Settings.m_OverflowPolicy == LogOverflowPolicy::Block)
+	{
+		do
+		{
+			WakeThread();
+			std::this_thread::yield();
+
+		} while (!queue.TryPush(text));
+
+		return;
+	}
+
+	m_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+	WakeThread();
+}
+
+void LogWriter::Flush()
+{
+	// Direct writes are flushed as they happen
+	if (!IsRunning())
+		return;
+
+	const uint64_t target = m_Queue.load(std::memory_order_acquire)->GetPushCount();
+	WakeThread();
+
+	std::unique_lock<std::mutex> lock(m_WrittenMutex);
+	m_RecordsWritten.wait(lock, [this, target]() { return m_WrittenCount >= target || m_ThreadExited; });
+}
+
+void LogWriter::AddSink(std::unique_ptr<ILogSink>&& sink)
+{
+	std::lock_guard<std::mutex> lock(m_SinkMutex);
+	if (m_DefaultSinks)
+	{
+		m_Sinks.clear();
+		m_DefaultSinks = false;
+	}
+
+	m_Sinks.push_back(std::move(sink));
+}
+
+void LogWriter::RemoveAllSinks()
+{
+	std::lock_guard<std::mutex> lock(m_SinkMutex);
+	m_Sinks.clear();
+	m_DefaultSinks = false;
+}
+
+void LogWriter::ThreadMain()
+{
+	while (true)
+	{
+		const bool exiting = m_Exiting;
+
+		if (WriteBatch())
+			continue;
+
+		if (exiting)
+			break;
+
+		// Nothing to do, nap until woken or the poll interval runs out. Records
+		// pushed just before we got here are caught on the next lap.
+		std::unique_lock<std::mutex> lock(m_WakeMutex);
+		m_ThreadSleeping = true;
+		m_WakeThread.wait_for(lock, m_Settings.m_PollInterval);
+		m_ThreadSleeping = false;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_WrittenMutex);
+		m_ThreadExited = true;
+	}
+
+	m_RecordsWritten.notify_all();
+}
+
+void LogWriter::WakeThread()
+{
+	if (m_ThreadSleeping.load(std::memory_order_relaxed))
+		m_WakeThread.notify_one();
+}
+
+size_t LogWriter::WriteBatch()
+{
+	m_Batch.clear();
+
+	LogQueue& queue = *m_Queue.load(std::memory_order_relaxed);
+	size_t count = 0;
+	while (m_Batch.size() < MAX_BATCH_SIZE && queue.TryPop(m_Batch))
+		count++;
+
+	if (m_Settings.m_OverflowPolicy == LogOverflowPolicy::Count)
+	{
+		const uint64_t dropped = m_DroppedCount.load(std::memory_order_relaxed);
+		if (dropped != m_ReportedDroppedCount)
+		{
+			StringTools::CSFormatTo(m_Batch, "[Log] Queue full, dropped {0} records\n"sv, dropped - m_ReportedDroppedCount);
+			m_ReportedDroppedCount = dropped;
+		}
+	}
+
+	if (!m_Batch.empty())
+		WriteToSinks(m_Batch);
+
+	if (count)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_WrittenMutex);
+			m_WrittenCount += count;
+		}
+
+		m_RecordsWritten.notify_all();
+	}
+
+	return count;
+}
+
+void LogWriter::WriteToSinks(const std::string_view& text)
+{
+	std::lock_guard<std::mutex> lock(m_SinkMutex);
+	for (auto& sink : m_Sinks)
+	{
+		sink->Write(text);
+		sink->Flush();
+	}
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include "ILogSink.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+class LogQueue;
+
+// What to do with a record when the queue is full.
+enum class LogOverflowPolicy
+{
+	// Throw it away.
+	Drop,
+	// Wait for the writer thread to make room. Never use this if a sink could
+	// end up waiting on the logging thread.
+	Block,
+	// Throw it away, and have the writer report how many were lost.
+	Count,
+};
+
+struct LogWriterSettings
+{
+	// Records, not bytes. Each slot holds up to ~200 bytes inline.
+	size_t m_QueueCapacity = 4096;
+
+	LogOverflowPolicy m_OverflowPolicy = LogOverflowPolicy::Count;
+
+	// How long the writer thread sleeps when there's nothing to do. Producers
+	// don't wake it for every record (that would be the syscall we're trying to
+	// avoid), only when the queue starts filling up.
+	std::chrono::milliseconds m_PollInterval = std::chrono::milliseconds(2);
+};
+
+// Hands finished log records to the sinks. Until Start() is called (and after
+// Stop()), records are written straight through on the calling thread. While
+// running, they go through a lock-free queue and a background thread writes
+// them out in batches.
+class LogWriter
+{
+public:
+	// Never destroyed, so logging from static destructors still works.
+	static LogWriter& Instance();
+
+	void Start(const LogWriterSettings& settings = LogWriterSettings());
+	// Writes out everything queued so far and joins the writer thread.
+	void Stop();
+	bool IsRunning() const { return m_Running.load(std::memory_order_acquire); }
+
+	void Write(const std::string_view& text);
+
+	// Returns once everything written before this call has reached the sinks.
+	void Flush();
+
+	// The platform default sink is installed until the first call to AddSink or RemoveAllSinks.
+	void AddSink(std::unique_ptr<ILogSink>&& sink);
+	void RemoveAllSinks();
+
+	uint64_t GetDroppedCount() const { return m_DroppedCount.load(std::memory_order_relaxed); }
+
+private:
+	LogWriter();
+	LogWriter(const LogWriter& other) = delete;
+	~LogWriter() = delete;
+
+	void ThreadMain();
+	void WakeThread();
+
+	// Returns the number of records written. Writer thread only.
+	size_t WriteBatch();
+	// Writes and flushes every sink
+	void WriteToSinks(const std::string_view& text);
+
+	LogWriterSettings m_Settings;
+
+	// The current queue is always the last one. Replaced ones are never freed,
+	// a thread that saw us running just before Stop() may still be pushing to
+	// one (and whatever it pushes after the final WriteBatch() is lost).
+	std::vector<std::unique_ptr<LogQueue>> m_Queues;
+	std::atomic<LogQueue*> m_Queue = nullptr;
+	std::thread m_Thread;
+	std::atomic<bool> m_Running = false;
+	std::atomic<bool> m_Exiting = false;
+
+	// Protects starting and stopping
+	std::mutex m_StateMutex;
+
+	std::mutex m_WakeMutex;
+	std::condition_variable m_WakeThread;
+	std::atomic<bool> m_ThreadSleeping = false;
+
+	// Records that have made it through the sinks, for Flush()
+	std::mutex m_WrittenMutex;
+	std::condition_variable m_RecordsWritten;
+	uint64_t m_WrittenCount = 0;
+	bool m_ThreadExited = false;
+
+	std::atomic<uint64_t> m_DroppedCount = 0;
+	uint64_t m_ReportedDroppedCount = 0;
+
+	// Taken for every write to the sinks, by whichever thread is writing
+	std::mutex m_SinkMutex;
+	std::vector<std::unique_ptr<ILogSink>> m_Sinks;
+	bool m_DefaultSinks = true;
+
+	std::string m_Batch;
+};
@@ -3,6 +3,7 @@
 
 #include "Log.h"
 #include "Swapchain.h"
+#include "TaskGraph.h"
 #include "Texture.h"
 
 const vk::Queue& LogicalDevice::GetQueue(QueueType q) const
@@ -19,9 +20,23 @@ uint32_t LogicalDevice::GetQueueFamily(QueueType q) const
 
 void LogicalDevice::DrawFrame()
 {
+	// Swap out fallbacks for anything that has finished loading since last time
+	if (MaterialManager::Instance().GetLoadGeneration() != m_RecordedMaterialGeneration)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_QueueMutex);
+			GetQueue(QueueType::Graphics).waitIdle();
+		}
+		RecordCommandBuffers();
+	}
+
 	m_BuiltinUniformBuffers->Update();
 	m_TestDrawable->Update();
 
+	// Anything that finished loading since last frame. Being on the same queue
+	// ahead of the frame is enough for the frame to see it, nothing waits here.
+	m_UploadBatch->Submit();
+
 	using namespace std::chrono_literals;
 	const auto result = Get().acquireNextImageKHR(m_Swapchain->Get(), std::chrono::nanoseconds(1s).count(), *m_ImageAvailableSemaphore, nullptr);
 	assert(result.result == vk::Result::eSuccess);
@@ -45,6 +60,7 @@ void LogicalDevice::DrawFrame()
 		submitInfo.setPSignalSemaphores(signalSempahores);
 		submitInfo.setSignalSemaphoreCount(std::size(signalSempahores));
 
+		std::lock_guard<std::mutex> lock(m_QueueMutex);
 		GetQueue(QueueType::Graphics).submit(submitInfo, nullptr);
 	}
 
@@ -62,6 +78,7 @@ void LogicalDevice::DrawFrame()
 
 		presentInfo.setPImageIndices(&imageIndex);
 
+		std::lock_guard<std::mutex> lock(m_QueueMutex);
 		vk::Result mainPresentResult = GetQueue(QueueType::Presentation).presentKHR(presentInfo);
 		assert(mainPresentResult == vk::Result::eSuccess);
 	}
@@ -99,13 +116,27 @@ void LogicalDevice::SubmitCommandBuffers(const vk::CommandBuffer& cmdBuf, QueueT
 }
 
 void LogicalDevice::SubmitCommandBuffers(const std::initializer_list<vk::CommandBuffer>& cmdBufs, QueueType q) const
+{
+	const vk::UniqueFence fence = SubmitCommandBuffersAsync(cmdBufs, q);
+
+	// Waiting on just our own work, and outside the lock, so frames can keep
+	// being submitted while a worker thread uploads something
+	Get().waitForFences(fence.get(), true, UINT64_MAX);
+}
+
+vk::UniqueFence LogicalDevice::SubmitCommandBuffersAsync(const std::initializer_list<vk::CommandBuffer>& cmdBufs, QueueType q) const
 {
 	vk::SubmitInfo submitInfo;
 	submitInfo.setCommandBufferCount(cmdBufs.size());
 	submitInfo.setPCommandBuffers(cmdBufs.begin());
 
-	GetQueue(q).submit(submitInfo, nullptr);
-	Get().waitIdle();
+	vk::UniqueFence fence = Get().createFenceUnique(vk::FenceCreateInfo());
+	{
+		std::lock_guard<std::mutex> lock(m_QueueMutex);
+		GetQueue(q).submit(submitInfo, fence.get());
+	}
+
+	return fence;
 }
 
 LogicalDevice::LogicalDevice(const std::shared_ptr<PhysicalDeviceData>& physicalDevice) :
@@ -113,7 +144,7 @@ LogicalDevice::LogicalDevice(const std::shared_ptr<PhysicalDeviceData>& physical
 {
 	m_InitData = m_PhysicalDeviceData->GetInitData();
 
-	Log::Msg<LogType::ObjectLifetime>(__FUNCSIG__);
+	Log::DeferredMsg<LogType::ObjectLifetime>(__FUNCSIG__);
 	ChooseQueueFamilies();
 
 	InitDevice();
@@ -126,6 +157,7 @@ LogicalDevice::LogicalDevice(const std::shared_ptr<PhysicalDeviceData>& physical
 	m_MaterialDataManagerInstance.emplace(*this);
 	m_MaterialManagerInstance.emplace(*this);
 	m_TextureManagerInstance.emplace(*this);
+	InitManagers();
 
 	InitSwapchain();
 	InitRenderPass();
@@ -137,7 +169,15 @@ LogicalDevice::LogicalDevice(const std::shared_ptr<PhysicalDeviceData>& physical
 
 LogicalDevice::~LogicalDevice()
 {
-	Log::Msg<LogType::ObjectLifetime>(__FUNCSIG__);
+	Log::DeferredMsg<LogType::ObjectLifetime>(__FUNCSIG__);
+
+	// Materials wait on their textures, so they have to finish first
+	m_MaterialManagerInstance->WaitForAsyncLoads();
+	m_TextureManagerInstance->WaitForAsyncLoads();
+
+	// Submits and waits for anything still pending, and frees its command
+	// buffers while there's still a pool
+	m_UploadBatch.reset();
 
 	Get().waitIdle();
 
@@ -216,6 +256,31 @@ void LogicalDevice::InitDevice()
 	m_Queues[Enums::value(QueueType::Presentation)] = m_LogicalDevice->getQueue(GetQueueFamily(QueueType::Presentation), presentationQueueIndex);
 }
 
+void LogicalDevice::InitManagers()
+{
+	Log::TagMsg(TAG, "Loading resources...");
+
+	// Each Reload() also calls Instance() on whatever it needs, so this order is
+	// only for speed: anything not waiting on something else starts right away
+	TaskGraph graph;
+	const auto shaderModules = graph.Add("Shader modules", []() { ShaderModuleDataManager::Instance(); });
+	const auto shaderGroupData = graph.Add("Shader group data", []() { ShaderGroupDataManager::Instance(); }, { shaderModules });
+	const auto shaderGroups = graph.Add("Shader groups", []() { ShaderGroupManager::Instance(); }, { shaderGroupData });
+	const auto materialData = graph.Add("Material data", []() { MaterialDataManager::Instance(); }, { shaderGroups });
+	const auto textures = graph.Add("Textures", []() { TextureManager::Instance(); });
+	graph.Add("Materials", []() { MaterialManager::Instance(); }, { materialData, textures });
+
+	graph.Run(ThreadPool::Default());
+
+	for (TaskGraph::TaskID i = 0; i < graph.size(); i++)
+	{
+		Log::TagMsg(TAG, "    {0}: started at {1} ms, took {2} ms",
+					graph.GetName(i), graph.GetStartTime(i).count(), graph.GetDuration(i).count());
+	}
+
+	Log::TagMsg(TAG, "Loaded resources in {0} ms", graph.GetTotalDuration().count());
+}
+
 void LogicalDevice::InitDescriptorPool()
 {
 	const vk::DescriptorPoolSize poolSizes[] =
@@ -312,8 +377,10 @@ void LogicalDevice::InitCommandPool()
 
 	vk::CommandPoolCreateInfo createInfo;
 	createInfo.queueFamilyIndex = GetQueueFamily(QueueType::Graphics);
+	createInfo.setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer);	// For RecordCommandBuffers()
 
 	m_CommandPool = Get().createCommandPoolUnique(createInfo);
+	m_UploadBatch.emplace(*this);
 }
 
 void LogicalDevice::InitCommandBuffers()
@@ -327,12 +394,26 @@ void LogicalDevice::InitCommandBuffers()
 	allocInfo.setLevel(vk::CommandBufferLevel::ePrimary);
 	allocInfo.setCommandBufferCount(framebuffers.size());
 
-	m_CommandBuffers = Get().allocateCommandBuffersUnique(allocInfo);
+	{
+		const auto poolLock = LockCommandPool();
+		m_CommandBuffers = Get().allocateCommandBuffersUnique(allocInfo);
+	}
 
 	m_TestDrawable.emplace(*this);
 
 	//auto testTexture = Texture::Create("../statue.jpg", this);
 
+	RecordCommandBuffers();
+}
+
+void LogicalDevice::RecordCommandBuffers()
+{
+	// Read first, anything finishing while we record gets picked up next frame
+	m_RecordedMaterialGeneration = MaterialManager::Instance().GetLoadGeneration();
+
+	const auto& framebuffers = m_Swapchain->GetFramebuffers();
+	const auto poolLock = LockCommandPool();
+
 	for (size_t i = 0; i < framebuffers.size(); i++)
 	{
 		const auto& cmdBuffer = m_CommandBuffers[i];
@@ -377,7 +458,13 @@ void LogicalDevice::InitSemaphores()
 
 void LogicalDevice::RecreateSwapchain()
 {
-	Get().waitIdle();
+	// Nothing new should be created against the old render pass
+	MaterialManager::Instance().WaitForAsyncLoads();
+
+	{
+		std::lock_guard<std::mutex> lock(m_QueueMutex);
+		Get().waitIdle();
+	}
 
 	((ISwapchain_LogicalDeviceFriends*)&m_Swapchain.value())->Recreate(
 		std::make_shared<SwapchainData>(GetData().GetPhysicalDevice(), GetData().GetWindowSurface()));
@@ -11,9 +11,11 @@
 #include "Swapchain.h"
 #include "TestDrawable.h"
 #include "TextureManager.h"
+#include "UploadBatch.h"
 #include "Util.h"
 
 #include <memory>
+#include <mutex>
 
 class Mesh;
 class Texture;
@@ -54,6 +56,22 @@ public:
 	void SubmitCommandBuffers(const vk::CommandBuffer& cmdBuf, QueueType q = QueueType::Graphics) const;
 	void SubmitCommandBuffers(const std::initializer_list<vk::CommandBuffer>& cmdBufs, QueueType q = QueueType::Graphics) const;
 
+	// Returns right after submitting, with a fence that's signaled once the
+	// command buffers have finished.
+	vk::UniqueFence SubmitCommandBuffersAsync(const std::initializer_list<vk::CommandBuffer>& cmdBufs, QueueType q = QueueType::Graphics) const;
+
+	// Shared by everything uploading to the device. DrawFrame() submits it
+	// ahead of every frame.
+	UploadBatch& GetUploadBatch() { return m_UploadBatch.value(); }
+
+	// Textures and materials can be created on worker threads, and Vulkan wants
+	// pools used from one thread at a time. Hold this from AllocCommandBuffer()
+	// until the command buffer has been recorded and submitted, and again while
+	// freeing it.
+	std::unique_lock<std::mutex> LockCommandPool() const { return std::unique_lock<std::mutex>(m_CommandPoolMutex); }
+	// For allocating and freeing descriptor sets from GetDescriptorPool().
+	std::unique_lock<std::mutex> LockDescriptorPool() const { return std::unique_lock<std::mutex>(m_DescriptorPoolMutex); }
+
 	// a LogicalDevice should never be assigned, this is here to make
 	// passing references everywhere to ourselves a safer prospect
 	LogicalDevice& operator=(const LogicalDevice& rhs) = delete;
@@ -62,11 +80,13 @@ public:
 private:
 	void InitDevice();
 	void InitDescriptorPool();
+	void InitManagers();
 	void InitSwapchain();
 	void InitRenderPass();
 	void InitFramebuffers();
 	void InitCommandPool();
 	void InitCommandBuffers();
+	void RecordCommandBuffers();
 	void InitSemaphores();
 
 	void RecreateSwapchain();
@@ -81,7 +101,7 @@ private:
 	std::shared_ptr<PhysicalDeviceData> m_PhysicalDeviceData;
 	vk::UniqueDevice m_LogicalDevice;
 
-	// These need to be initialized in a specific order
+	// These need to be constructed in a specific order. InitManagers() loads them.
 	std::optional<ShaderModuleDataManager> m_ShaderModuleDataManagerInstance;
 	std::optional<ShaderGroupManager> m_ShaderGroupManagerInstance;
 	std::optional<ShaderGroupDataManager> m_ShaderGroupDataManagerInstance;
@@ -96,8 +116,17 @@ private:
 	vk::UniqueRenderPass m_RenderPass;
 	vk::UniqueCommandPool m_CommandPool;
 	std::vector<vk::UniqueCommandBuffer> m_CommandBuffers;
+	std::optional<UploadBatch> m_UploadBatch;	// Needs m_CommandPool
 	vk::UniqueDescriptorPool m_DescriptorPool;
 
+	mutable std::mutex m_CommandPoolMutex;
+	mutable std::mutex m_DescriptorPoolMutex;
+	mutable std::mutex m_QueueMutex;		// Every queue, and the device as a whole for waitIdle()
+
+	// MaterialManager's load generation when m_CommandBuffers were recorded, so
+	// they can be recorded again once materials that were still loading are ready
+	uint32_t m_RecordedMaterialGeneration = 0;
+
 	std::optional<BuiltinUniformBuffers> m_BuiltinUniformBuffers;
 
 	vk::UniqueSemaphore m_ImageAvailableSemaphore;
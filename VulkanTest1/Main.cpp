@@ -2,16 +2,20 @@
 #include "Main.h"
 
 #include <assert.h>
+#include "BinaryLog.h"
 #include <chrono>
 #include <clocale>
 #include "FixedWindows.h"
 #include <glm/glm.hpp>
 #include "GlobalValues.h"
 #include "JSON.h"
+#include "JSONStructuralIndex.h"
 #include "Log.h"
 #include "LogicalDevice.h"
+#include "LogWriter.h"
 #include "ShaderGroupData.h"
 #include "StringTools.h"
+#include "TextureManager.h"
 #include "Vulkan.h"
 
 
@@ -59,6 +63,20 @@ int CALLBACK WinMain(
 	_In_ LPSTR lpCmdLine,
 	_In_ int nCmdShow)
 {
+	LogWriter::Instance().Start();
+
+#ifdef NDEBUG
+	// Lifetime tracing stays on in release builds, read it back with LogDecoder
+	BinaryLog::Open("VulkanTest1.binlog");
+#endif
+
+	// Build machines only want the textures cooked, no window or device
+	if (std::string_view(lpCmdLine).find("-cook"sv) != std::string_view::npos)
+	{
+		TextureManager::CookAll();
+		return 0;
+	}
+
 	Log::BlockMsg(u8"{00} EPIC MEME START 🔥🔥🔥", u8"🔥🔥🔥");
 
 	try
@@ -111,4 +129,5 @@ _Main::_Main()
 	m_AppInstance = nullptr;
 
 	StringTools::UnitTests();
+	JSONStructuralIndex::UnitTests();
 }
\ No newline at end of file
@@ -56,6 +56,13 @@ void Material::InitDescriptorSet()
 {
 	m_Bindings.clear();
 
+	// Get all our textures decoding at once, the loop below waits on them one by one
+	for (const auto& input : GetData().GetInputs())
+	{
+		if (const auto textureName = std::get_if<std::string>(&input.second))
+			TextureManager::Instance().Prefetch(*textureName);
+	}
+
 	for (const auto& shaderModuleData : GetData().GetShaderGroup().GetData().GetShaderModulesData())
 	{
 		if (!shaderModuleData)
@@ -100,8 +107,8 @@ void Material::InitDescriptorSet()
 					texPtr->GetImageType() == vk::ImageType::e3D && dimension.m_Type.image.dim == spv::Dim::Dim3D)
 				{
 					newBinding.m_Binding.setBinding(dimension.m_BindingID);
-					newBinding.m_FullName = dimension.m_FullName;
-					newBinding.m_FriendlyName = dimension.m_FriendlyName;
+					newBinding.m_FullName = Atom(dimension.m_FullName);
+					newBinding.m_FriendlyName = Atom(dimension.m_FriendlyName);
 					break;
 				}
 			}
@@ -133,7 +140,7 @@ void Material::InitDescriptorSet()
 			DescriptorSetCreateInfo::Binding& outBinding = setCreateInfo->m_Data.back();
 
 			outBinding.m_BindingIndex = inBinding.m_Binding.binding;
-			outBinding.m_DebugName = inBinding.m_FullName;
+			outBinding.m_DebugName = inBinding.m_FullName.GetView();
 			outBinding.m_Stages = inBinding.m_Binding.stageFlags;
 			outBinding.m_Data = inBinding.m_Data.value();
 		}
@@ -208,7 +215,10 @@ void Material::SetupTexModeSpecConstants(GraphicsPipelineCreateInfo::Specializat
 		const auto wat = variant_type_index_v<std::shared_ptr<Texture>, decltype(texBinding.m_Data.value())>;
 		assert(texBinding.m_Data.value().index() == wat);
 
-		const std::string texModeConstantName = "_texMode_" + texBinding.m_FriendlyName;
+		// Only ever looked up, so if no shader declared it there's no point interning it
+		const Atom texModeConstantName = Atom::Find(std::string("_texMode_"sv).append(texBinding.m_FriendlyName.GetView()));
+		if (texModeConstantName.empty())
+			continue;
 
 		for (const auto& shaderModuleData : GetData().GetShaderGroup().GetData().GetShaderModulesData())
 		{
@@ -295,7 +305,7 @@ void Material::SetupParamSpecConstants(GraphicsPipelineCreateInfo::Specializatio
 
 size_t Material::LayoutBinding::hash::operator()(const LayoutBinding& x) const
 {
-	return std::hash<decltype(x.m_FullName)>{}(x.m_FullName);
+	return x.m_FullName.GetHash();
 }
 
 bool Material::LayoutBinding::operator==(const LayoutBinding& rhs) const
@@ -1,4 +1,5 @@
 #pragma once
+#include "Atom.h"
 #include "GraphicsPipeline.h"
 #include "IMaterial.h"
 
@@ -45,8 +46,8 @@ private:
 
 	struct LayoutBinding
 	{
-		std::string m_FullName;
-		std::string m_FriendlyName;
+		Atom m_FullName;
+		Atom m_FriendlyName;
 		vk::DescriptorSetLayoutBinding m_Binding;
 		std::optional<std::variant<std::shared_ptr<Buffer>, std::shared_ptr<Texture>>> m_Data;
 
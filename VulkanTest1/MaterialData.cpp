@@ -2,72 +2,94 @@
 #include "MaterialData.h"
 
 #include "ContentPaths.h"
+#include "JSONSchema.h"
 #include "ShaderGroup.h"
 #include "ShaderGroupData.h"
 #include "ShaderGroupManager.h"
 #include "ShaderModuleData.h"
 
 MaterialData::MaterialData(const std::filesystem::path& path) :
-	MaterialData(name_from_path(ContentPaths::Materials(), path), JSONSerializer::FromFile(path).GetObject())
+	MaterialData(name_from_path(ContentPaths::Materials(), path), JSONReader(path))
 {
 }
 
 MaterialData::MaterialData(const std::string& name, const std::string& jsonStr) :
-	MaterialData(name, JSONSerializer::FromString(jsonStr).GetObject())
+	MaterialData(name, JSONReader(std::string_view(jsonStr)))
 {
 }
 
-MaterialData::MaterialData(const std::string& name, const JSONObject& json) :
+MaterialData::MaterialData(const std::string& name, JSONReader&& reader) :
 	m_Name(name)
 {
-	const JSONObject& shaderGroup = json.GetObject("shaderGroup");
+	static const auto s_ShaderGroupSchema = MakeJSONSchema<Definition>(
+		JSONBind<&Definition::m_ShaderGroupName>("name", JSONPresence::Required),
+		JSONBind<Definition>("inputs", &LoadInputs, JSONPresence::Required));
 
-	const auto& shaderGroupName = shaderGroup.GetString("name");
-	m_ShaderGroup = ShaderGroupManager::Instance().Find(shaderGroupName);
+	static const auto s_Schema = MakeJSONSchema<Definition>(
+		JSONBind<Definition>("shaderGroup", [](JSONReader& reader, Definition& definition, std::vector<std::string>* unknownFields)
+			{ s_ShaderGroupSchema.Read(reader, definition, unknownFields); }, JSONPresence::Required));
+
+	Definition definition;
+	std::vector<std::string> unknownFields;
+	s_Schema.Read(reader, definition, &unknownFields);
+
+	for (const auto& field : unknownFields)
+		Log::TagMsg(TAG, "Warning: Unknown field \"{0}\" in material \"{1}\"", field, m_Name);
+
+	m_ShaderGroup = ShaderGroupManager::Instance().Find(definition.m_ShaderGroupName);
 
 	if (!m_ShaderGroup)
-		throw MissingShaderGroupException(m_Name, shaderGroupName);
+		throw MissingShaderGroupException(m_Name, definition.m_ShaderGroupName);
+
+	for (const auto& input : definition.m_UnsupportedInputs)
+		Log::TagMsg(TAG, "Warning: Shader group input \"{0}\" in material \"{1}\" is not a bool, number or string", input, m_Name);
 
-	for (const auto& value : shaderGroup.GetObject("inputs"))
+	for (auto& input : definition.m_Inputs)
 	{
-		const auto& type = value.second.GetType();
-		const auto& name = value.first;
 		// Search through all parameters of all shaders in this group, looking for
 		// a reference of this parameter. This is to just make sure you don't have
 		// misspelled parameters/non-hooked-up parameters sitting around in materials.
 		bool found = false;
 		for (const auto& shaderDef : m_ShaderGroup->GetData().GetShaderModulesData())
 		{
-			if (!shaderDef)
-				continue;
-
-			if (shaderDef->HasInputFriendly(name))
+			if (shaderDef && shaderDef->HasInputFriendly(input.first))
 			{
-				switch (value.second.GetType())
-				{
-				case JSONDataType::Bool:
-					m_Inputs.insert(std::make_pair(value.first, value.second.GetBool()));
-					break;
-				case JSONDataType::Number:
-					m_Inputs.insert(std::make_pair(value.first, value.second.GetNumber()));
-					break;
-				case JSONDataType::String:
-					m_Inputs.insert(std::make_pair(value.first, value.second.GetString()));
-					break;
-
-				default:
-					Log::TagMsg(TAG, "Warning: Unknown shader group input \"{0}\" of type {1} in material \"{2}\"", value.first, type, m_Name);
-				}
-
 				found = true;
 				break;
 			}
 		}
 
-		if (!found)
-			Log::TagMsg(TAG, "Warning: Unknown shader group parameter \"{0}\" referenced in material \"{1}\"", name, m_Name);
+		if (found)
+			m_Inputs.insert(std::move(input));
+		else
+			Log::TagMsg(TAG, "Warning: Unknown shader group parameter \"{0}\" referenced in material \"{1}\"", input.first, m_Name);
 	}
+}
 
-	if (!m_ShaderGroup)
-		throw std::runtime_error(StringTools::CSFormat("Encountered unknown shader group \"{0}\"", shaderGroupName));
-}
\ No newline at end of file
+void MaterialData::LoadInputs(JSONReader& reader, Definition& definition)
+{
+	reader.Expect(JSONEvent::StartObject);
+	while (reader.Next() == JSONEvent::Key)
+	{
+		const Atom name(reader.GetString());
+		switch (reader.Next())
+		{
+		case JSONEvent::Bool:
+			definition.m_Inputs.emplace_back(name, reader.GetBool());
+			break;
+		case JSONEvent::Number:
+			definition.m_Inputs.emplace_back(name, reader.GetNumber());
+			break;
+		case JSONEvent::String:
+			definition.m_Inputs.emplace_back(name, std::string(reader.GetString()));
+			break;
+
+		case JSONEvent::StartObject:
+		case JSONEvent::StartArray:
+			reader.SkipContainer();
+			[[fallthrough]];
+		default:
+			definition.m_UnsupportedInputs.emplace_back(name.GetView());
+		}
+	}
+}
@@ -1,7 +1,9 @@
 #pragma once
-#include "JSON.h"
+#include "Atom.h"
+#include "JSONReader.h"
 
 #include <filesystem>
+#include <unordered_map>
 
 class ShaderGroup;
 
@@ -10,7 +12,7 @@ class MaterialData
 public:
 	MaterialData(const std::filesystem::path& path);
 	MaterialData(const std::string& name, const std::string& jsonStr);
-	MaterialData(const std::string& name, const JSONObject& json);
+	MaterialData(const std::string& name, JSONReader&& reader);
 
 	const auto& GetName() const { return m_Name; }
 	const auto& GetInputs() const { return m_Inputs; }
@@ -38,7 +40,19 @@ public:
 private:
 	static constexpr char TAG[] = "[MaterialData] ";
 
+	using InputValue = std::variant<bool, double, std::string>;
+
+	// Everything in the file, before it's checked against the shader group
+	struct Definition
+	{
+		std::string m_ShaderGroupName;
+		std::vector<std::pair<Atom, InputValue>> m_Inputs;
+		std::vector<std::string> m_UnsupportedInputs;
+	};
+
+	static void LoadInputs(JSONReader& reader, Definition& definition);
+
 	std::string m_Name;
 	std::shared_ptr<const ShaderGroup> m_ShaderGroup;
-	std::map<std::string, std::variant<bool, double, std::string>> m_Inputs;
+	std::unordered_map<Atom, InputValue> m_Inputs;
 };
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "MaterialDataManager.h"
 
 #include "MaterialData.h"
+#include "ShaderGroupManager.h"
 
 MaterialDataManager::MaterialDataManager(LogicalDevice& device) :
 	DataStoreType(device)
@@ -14,22 +15,12 @@ void MaterialDataManager::Reload()
 
 	ClearData();
 
-	for (auto& item : std::filesystem::recursive_directory_iterator(s_TexturesFolderPath))
-	{
-		const auto& type = item.status().type();
-		if (type != std::filesystem::file_type::regular)
-			continue;
-
-		const auto& path = item.path();
-		if (!path.has_extension())
-			continue;
-
-		const auto& extension = path.extension();
-		if (extension != ".json")
-			continue;
+	// Materials look up their shader groups while loading
+	ShaderGroupManager::Instance();
 
+	AddFiles(FindFiles(s_TexturesFolderPath, ".json"), [](const std::filesystem::path& path)
+	{
 		std::shared_ptr<const MaterialData> data(std::make_shared<MaterialData>(path));
-
-		AddPair(data->GetName(), data);
-	}
+		return std::make_pair(data->GetName(), data);
+	});
 }
\ No newline at end of file
@@ -4,21 +4,26 @@
 #include "Material.h"
 #include "MaterialData.h"
 #include "MaterialDataManager.h"
+#include "TextureManager.h"
 
 MaterialManager::MaterialManager(LogicalDevice& device) :
 	DataStoreType(device)
 {
+	EnableAsyncLoading("fallback");
 }
 
 void MaterialManager::Reload()
 {
 	ClearData();
 
+	// Materials can be created on worker threads, which look up textures
+	TextureManager::Instance();
+
 	for (const auto& entry : MaterialDataManager::Instance())
 	{
-		const auto& data = entry.second.Get();
+		const auto& data = entry.Get();
 
-		AddPair(data->GetName(), std::make_shared<Material>(data, m_Device));
+		AddPair(data->GetName(), data);
 	}
 }
 
@@ -26,6 +31,12 @@ void MaterialManager::RecreatePipelines()
 {
 	for (auto& entry : Instance())
 	{
-		entry.second.Get()->GetPipeline().RecreatePipeline();
+		if (const auto material = entry.TryGet())
+			material->GetPipeline().RecreatePipeline();
 	}
 }
+
+std::shared_ptr<Material> MaterialManager::Transform(const std::shared_ptr<const MaterialData>& data) const
+{
+	return std::make_shared<Material>(data, m_Device);
+}
@@ -3,13 +3,19 @@
 
 class LogicalDevice;
 class Material;
+class MaterialData;
 
-class MaterialManager final : public DataStore<MaterialManager, Material>
+class MaterialManager final : public DataStore<MaterialManager, Material, const MaterialData>
 {
 public:
 	MaterialManager(LogicalDevice& device);
 
 	void Reload() override;
 
+	// Only the materials that have been loaded so far, the rest will pick up
+	// the current render pass whenever they do get loaded.
 	void RecreatePipelines();
+
+private:
+	std::shared_ptr<Material> Transform(const std::shared_ptr<const MaterialData>& data) const override;
 };
\ No newline at end of file
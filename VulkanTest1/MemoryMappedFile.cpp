@@ -0,0 +1,125 @@
+#include "stdafx.h"
+#include "MemoryMappedFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MemoryMappedFile::MemoryMappedFile(const std::filesystem::path& path)
+{
+#ifdef _WIN32
+	m_File = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_File == INVALID_HANDLE_VALUE)
+	{
+		m_File = nullptr;
+		throw std::runtime_error(StringTools::CSFormat("Failed to open \"{0}\" for mapping (error {1})", path.string(), GetLastError()));
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(m_File, &fileSize))
+	{
+		Close();
+		throw std::runtime_error(StringTools::CSFormat("Failed to get the size of \"{0}\" (error {1})", path.string(), GetLastError()));
+	}
+
+	m_Size = size_t(fileSize.QuadPart);
+
+	// Zero-length files can't be mapped, but they're still valid (empty) files.
+	if (!m_Size)
+		return;
+
+	m_Mapping = CreateFileMappingW(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_Mapping)
+	{
+		Close();
+		throw std::runtime_error(StringTools::CSFormat("Failed to create a file mapping for \"{0}\" (error {1})", path.string(), GetLastError()));
+	}
+
+	m_Data = static_cast<const char*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!m_Data)
+	{
+		Close();
+		throw std::runtime_error(StringTools::CSFormat("Failed to map a view of \"{0}\" (error {1})", path.string(), GetLastError()));
+	}
+#else
+	m_File = open(path.c_str(), O_RDONLY);
+	if (m_File < 0)
+		throw std::runtime_error(StringTools::CSFormat("Failed to open \"{0}\" for mapping (errno {1})", path.string(), errno));
+
+	struct stat fileStat;
+	if (fstat(m_File, &fileStat))
+	{
+		Close();
+		throw std::runtime_error(StringTools::CSFormat("Failed to get the size of \"{0}\" (errno {1})", path.string(), errno));
+	}
+
+	m_Size = size_t(fileStat.st_size);
+	if (!m_Size)
+		return;
+
+	void* mapped = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, m_File, 0);
+	if (mapped == MAP_FAILED)
+	{
+		Close();
+		throw std::runtime_error(StringTools::CSFormat("Failed to map \"{0}\" (errno {1})", path.string(), errno));
+	}
+
+	m_Data = static_cast<const char*>(mapped);
+	madvise(mapped, m_Size, MADV_SEQUENTIAL);
+#endif
+}
+
+MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+	Close();
+}
+
+MemoryMappedFile& MemoryMappedFile::operator=(MemoryMappedFile&& other) noexcept
+{
+	if (this == &other)
+		return *this;
+
+	Close();
+
+	std::swap(m_Data, other.m_Data);
+	std::swap(m_Size, other.m_Size);
+	std::swap(m_File, other.m_File);
+#ifdef _WIN32
+	std::swap(m_Mapping, other.m_Mapping);
+#endif
+
+	return *this;
+}
+
+void MemoryMappedFile::Close()
+{
+#ifdef _WIN32
+	if (m_Data)
+		UnmapViewOfFile(m_Data);
+	if (m_Mapping)
+		CloseHandle(m_Mapping);
+	if (m_File)
+		CloseHandle(m_File);
+
+	m_Mapping = nullptr;
+	m_File = nullptr;
+#else
+	if (m_Data)
+		munmap(const_cast<char*>(m_Data), m_Size);
+	if (m_File >= 0)
+		close(m_File);
+
+	m_File = -1;
+#endif
+
+	m_Data = nullptr;
+	m_Size = 0;
+}
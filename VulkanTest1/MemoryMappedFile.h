@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+// Read-only view of an entire file, backed by the OS page cache instead of a
+// heap copy. The mapping stays valid (and at the same address) for the lifetime
+// of the object, including across moves.
+class MemoryMappedFile
+{
+public:
+	MemoryMappedFile() = default;
+	MemoryMappedFile(const std::filesystem::path& path);
+	MemoryMappedFile(const MemoryMappedFile& other) = delete;
+	MemoryMappedFile(MemoryMappedFile&& other) noexcept;
+	~MemoryMappedFile();
+
+	MemoryMappedFile& operator=(const MemoryMappedFile& other) = delete;
+	MemoryMappedFile& operator=(MemoryMappedFile&& other) noexcept;
+
+	const char* data() const { return m_Data; }
+	size_t size() const { return m_Size; }
+	bool empty() const { return !m_Size; }
+
+	std::string_view GetView() const { return std::string_view(m_Data, m_Size); }
+	operator std::string_view() const { return GetView(); }
+
+private:
+	void Close();
+
+	const char* m_Data = nullptr;
+	size_t m_Size = 0;
+
+#ifdef _WIN32
+	void* m_File = nullptr;
+	void* m_Mapping = nullptr;
+#else
+	int m_File = -1;
+#endif
+};
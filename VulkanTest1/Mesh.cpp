@@ -33,7 +33,7 @@ void Mesh::Draw(const vk::CommandBuffer& cmdBuf) const
 Mesh::Mesh(const std::shared_ptr<const IVertexList>& vertexList, LogicalDevice& device) :
 	m_Device(device)
 {
-	Log::Msg<LogType::ObjectLifetime>(__FUNCSIG__);
+	Log::DeferredMsg<LogType::ObjectLifetime>(__FUNCSIG__);
 
 	m_Buffer.emplace(device, vertexList->GetVertexDataSize() + vertexList->GetIndexDataSize(),
 					 vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst,
@@ -41,14 +41,18 @@ Mesh::Mesh(const std::shared_ptr<const IVertexList>& vertexList, LogicalDevice&
 
 	m_VertexList = vertexList;
 
-	Buffer tempBuffer(device, GetBuffer().GetCreateInfo().size,
-					  vk::BufferUsageFlagBits::eTransferSrc,
-					  vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+	auto stagingBuffer = std::make_unique<Buffer>(device, GetBuffer().GetCreateInfo().size,
+												  vk::BufferUsageFlagBits::eTransferSrc,
+												  vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
 
-	void* data = device->mapMemory(tempBuffer.GetDeviceMemory(), 0, GetBuffer().GetCreateInfo().size);
-	memcpy(data, vertexList->GetVertexData(), vertexList->GetVertexDataSize());
-	memcpy((char*)data + vertexList->GetVertexDataSize(), vertexList->GetIndexData(), vertexList->GetIndexDataSize());
-	device->unmapMemory(tempBuffer.GetDeviceMemory());
+	stagingBuffer->Write(vertexList->GetVertexData(), vertexList->GetVertexDataSize(), 0);
+	stagingBuffer->Write(vertexList->GetIndexData(), vertexList->GetIndexDataSize(), vertexList->GetVertexDataSize());
 
-	tempBuffer.CopyTo(GetBuffer());
+	m_UploadToken = device.GetUploadBatch().CopyBuffer(std::move(stagingBuffer), GetBuffer());
+}
+
+Mesh::~Mesh()
+{
+	// The device might not have got to the upload yet
+	m_UploadToken.Wait();
 }
\ No newline at end of file
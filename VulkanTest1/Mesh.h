@@ -1,5 +1,6 @@
 #pragma once
 #include "Buffer.h"
+#include "UploadBatch.h"
 
 class IVertexList;
 class LogicalDevice;
@@ -9,6 +10,7 @@ class Mesh
 public:
 	static std::unique_ptr<Mesh> Create(const std::shared_ptr<const IVertexList>& vertexList);
 	static std::unique_ptr<Mesh> Create(const std::shared_ptr<const IVertexList>& vertexList, LogicalDevice& device);
+	~Mesh();
 
 	void Draw(const vk::CommandBuffer& buffer) const;
 
@@ -25,4 +27,5 @@ private:
 
 	std::shared_ptr<const IVertexList> m_VertexList;
 	std::optional<Buffer> m_Buffer;
+	UploadToken m_UploadToken;
 };
\ No newline at end of file
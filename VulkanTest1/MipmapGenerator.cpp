@@ -0,0 +1,312 @@
+#include "stdafx.h"
+#include "MipmapGenerator.h"
+
+#include <cmath>
+#include <vector>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIPMAP_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// Which source texels make up each destination texel along one axis, and
+	// how much each of them counts. Taps for destination texel i are
+	// [m_Start[i], m_Start[i + 1]).
+	struct FilterTaps
+	{
+		std::vector<uint32_t> m_Start;
+		std::vector<uint32_t> m_Index;
+		std::vector<float> m_Weight;
+	};
+
+	constexpr uint32_t CHANNELS = 4;
+	constexpr double PI = 3.14159265358979323846;
+
+	// In destination texels. 3 lobes either side, with alpha 4, is what most
+	// offline texture tools settle on.
+	constexpr double KAISER_WIDTH = 3;
+	constexpr double KAISER_ALPHA = 4;
+}
+
+uint32_t MipmapGenerator::GetLevelCount(uint32_t width, uint32_t height)
+{
+	uint32_t retVal = 1;
+	for (uint32_t size = std::max(width, height); size > 1; size >>= 1)
+		retVal++;
+
+	return retVal;
+}
+
+size_t MipmapGenerator::GetChainSize(uint32_t width, uint32_t height, uint32_t levelCount)
+{
+	size_t retVal = 0;
+	for (uint32_t level = 0; level < levelCount; level++)
+		retVal += size_t(GetLevelSize(width, level)) * GetLevelSize(height, level) * CHANNELS;
+
+	return retVal;
+}
+
+static uint32_t MapIndex(int64_t index, uint32_t size, bool wrap)
+{
+	if (wrap)
+		return uint32_t(((index % size) + size) % size);
+
+	return uint32_t(std::clamp<int64_t>(index, 0, size - 1));
+}
+
+// Zeroth order modified Bessel function of the first kind
+static double BesselI0(double x)
+{
+	double sum = 1;
+	double term = 1;
+	const double quarterXSquared = x * x / 4;
+	for (int k = 1; k < 32 && term > sum * 1e-12; k++)
+	{
+		term *= quarterXSquared / (double(k) * k);
+		sum += term;
+	}
+
+	return sum;
+}
+
+static double Kaiser(double x)
+{
+	const double t = x / KAISER_WIDTH;
+	if (t <= -1 || t >= 1)
+		return 0;
+
+	const double sinc = (x == 0) ? 1 : std::sin(PI * x) / (PI * x);
+	return sinc * BesselI0(KAISER_ALPHA * std::sqrt(1 - t * t)) / BesselI0(KAISER_ALPHA);
+}
+
+static FilterTaps ComputeTaps(uint32_t srcSize, uint32_t dstSize, MipmapFilter filter, bool wrap)
+{
+	FilterTaps retVal;
+	retVal.m_Start.reserve(dstSize + 1);
+
+	const double scale = double(srcSize) / dstSize;
+	for (uint32_t i = 0; i < dstSize; i++)
+	{
+		const size_t start = retVal.m_Weight.size();
+		retVal.m_Start.push_back(uint32_t(start));
+
+		if (filter == MipmapFilter::Kaiser)
+		{
+			const double center = (i + 0.5) * scale;
+			const double support = KAISER_WIDTH * scale;
+			for (int64_t j = int64_t(std::floor(center - support)); j <= int64_t(std::ceil(center + support)); j++)
+			{
+				const double weight = Kaiser((j + 0.5 - center) / scale);
+				if (weight == 0)
+					continue;
+
+				retVal.m_Index.push_back(MapIndex(j, srcSize, wrap));
+				retVal.m_Weight.push_back(float(weight));
+			}
+		}
+		else
+		{
+			// How much of each source texel falls inside this destination texel
+			const double lo = i * scale;
+			const double hi = (i + 1) * scale;
+			for (int64_t j = int64_t(std::floor(lo)); j < int64_t(std::ceil(hi)); j++)
+			{
+				const double weight = std::min<double>(hi, j + 1) - std::max<double>(lo, j);
+				if (weight <= 0)
+					continue;
+
+				retVal.m_Index.push_back(MapIndex(j, srcSize, wrap));
+				retVal.m_Weight.push_back(float(weight));
+			}
+		}
+
+		float sum = 0;
+		for (size_t t = start; t < retVal.m_Weight.size(); t++)
+			sum += retVal.m_Weight[t];
+		for (size_t t = start; t < retVal.m_Weight.size(); t++)
+			retVal.m_Weight[t] /= sum;
+	}
+
+	retVal.m_Start.push_back(uint32_t(retVal.m_Weight.size()));
+	return retVal;
+}
+
+// Any size to any smaller size, one axis at a time
+static void Resample(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, uint32_t dstWidth, uint32_t dstHeight,
+	MipmapFilter filter, bool wrapU, bool wrapV)
+{
+	const FilterTaps tapsX = ComputeTaps(srcWidth, dstWidth, filter, wrapU);
+	const FilterTaps tapsY = ComputeTaps(srcHeight, dstHeight, filter, wrapV);
+
+	// Horizontal pass, dstWidth x srcHeight
+	std::vector<float> horizontal(size_t(dstWidth) * srcHeight * CHANNELS);
+	for (uint32_t y = 0; y < srcHeight; y++)
+	{
+		const uint8_t* srcRow = src + size_t(y) * srcWidth * CHANNELS;
+		float* outRow = horizontal.data() + size_t(y) * dstWidth * CHANNELS;
+
+		for (uint32_t x = 0; x < dstWidth; x++)
+		{
+			float sum[CHANNELS] = {};
+			for (uint32_t t = tapsX.m_Start[x]; t < tapsX.m_Start[x + 1]; t++)
+			{
+				const uint8_t* texel = srcRow + size_t(tapsX.m_Index[t]) * CHANNELS;
+				for (uint32_t c = 0; c < CHANNELS; c++)
+					sum[c] += texel[c] * tapsX.m_Weight[t];
+			}
+
+			std::copy(std::begin(sum), std::end(sum), outRow + size_t(x) * CHANNELS);
+		}
+	}
+
+	// Vertical pass
+	for (uint32_t y = 0; y < dstHeight; y++)
+	{
+		uint8_t* dstRow = dst + size_t(y) * dstWidth * CHANNELS;
+		for (uint32_t x = 0; x < dstWidth; x++)
+		{
+			float sum[CHANNELS] = {};
+			for (uint32_t t = tapsY.m_Start[y]; t < tapsY.m_Start[y + 1]; t++)
+			{
+				const float* texel = horizontal.data() + (size_t(tapsY.m_Index[t]) * dstWidth + x) * CHANNELS;
+				for (uint32_t c = 0; c < CHANNELS; c++)
+					sum[c] += texel[c] * tapsY.m_Weight[t];
+			}
+
+			// Kaiser's negative lobes can overshoot
+			for (uint32_t c = 0; c < CHANNELS; c++)
+				dstRow[size_t(x) * CHANNELS + c] = uint8_t(std::clamp(sum[c] + 0.5f, 0.0f, 255.0f));
+		}
+	}
+}
+
+// Exactly half the width, and half the height unless it's already 1. Rounds
+// to nearest, same as Resample() would for this case.
+static void DownsampleBox2x(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst)
+{
+	const uint32_t dstWidth = srcWidth / 2;
+	const uint32_t dstHeight = std::max(srcHeight / 2, 1u);
+	const size_t srcStride = size_t(srcWidth) * CHANNELS;
+
+	for (uint32_t y = 0; y < dstHeight; y++)
+	{
+		const uint8_t* row0 = src + srcStride * (srcHeight > 1 ? y * 2 : 0);
+		const uint8_t* row1 = (srcHeight > 1) ? (row0 + srcStride) : row0;
+		uint8_t* out = dst + size_t(y) * dstWidth * CHANNELS;
+
+		uint32_t x = 0;
+#if MIPMAP_SIMD_SSE2
+		// 8 source texels from each row in, 4 texels out
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i rounding = _mm_set1_epi16(2);
+		for (; x + 4 <= dstWidth; x += 4)
+		{
+			const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + size_t(x) * 8));
+			const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + size_t(x) * 8 + 16));
+			const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + size_t(x) * 8));
+			const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + size_t(x) * 8 + 16));
+
+			// Vertical sums, two texels per register
+			const __m128i v01 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+			const __m128i v23 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+			const __m128i v45 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+			const __m128i v67 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+			// Horizontal sums: even texels plus odd texels
+			__m128i sum0 = _mm_add_epi16(_mm_unpacklo_epi64(v01, v23), _mm_unpackhi_epi64(v01, v23));
+			__m128i sum1 = _mm_add_epi16(_mm_unpacklo_epi64(v45, v67), _mm_unpackhi_epi64(v45, v67));
+			sum0 = _mm_srli_epi16(_mm_add_epi16(sum0, rounding), 2);
+			sum1 = _mm_srli_epi16(_mm_add_epi16(sum1, rounding), 2);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + size_t(x) * CHANNELS), _mm_packus_epi16(sum0, sum1));
+		}
+#endif
+
+		for (; x < dstWidth; x++)
+		{
+			for (uint32_t c = 0; c < CHANNELS; c++)
+			{
+				const size_t i = size_t(x) * 8 + c;
+				out[size_t(x) * CHANNELS + c] = uint8_t((row0[i] + row0[i + CHANNELS] + row1[i] + row1[i + CHANNELS] + 2) / 4);
+			}
+		}
+	}
+}
+
+// Fraction of texels that pass an alpha test at reference, with alpha scaled
+static float ComputeAlphaCoverage(const uint8_t* pixels, size_t count, float reference, float scale)
+{
+	const float threshold = reference * 255;
+
+	size_t passed = 0;
+	for (size_t i = 0; i < count; i++)
+		passed += (pixels[i * CHANNELS + 3] * scale > threshold);
+
+	return float(passed) / count;
+}
+
+static void ScaleAlphaToCoverage(uint8_t* pixels, size_t count, float reference, float coverage)
+{
+	// Coverage only ever goes up with scale, so binary search for the smallest
+	// scale that gets there
+	float lo = 0;
+	float hi = 4;
+	while (hi < 256 && ComputeAlphaCoverage(pixels, count, reference, hi) < coverage)
+		hi *= 2;
+
+	for (int i = 0; i < 16; i++)
+	{
+		const float mid = (lo + hi) / 2;
+		if (ComputeAlphaCoverage(pixels, count, reference, mid) < coverage)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	for (size_t i = 0; i < count; i++)
+	{
+		uint8_t& alpha = pixels[i * CHANNELS + 3];
+		alpha = uint8_t(std::min(alpha * hi + 0.5f, 255.0f));
+	}
+}
+
+void MipmapGenerator::Generate(uint8_t* chain, uint32_t width, uint32_t height, uint32_t levelCount, const Settings& settings)
+{
+	if (settings.m_Filter == MipmapFilter::None)
+		return;
+
+	// Nothing to preserve if everything (or nothing) passes, and scaling would
+	// only make fully opaque images partly transparent
+	float coverage = 0;
+	bool preserveCoverage = false;
+	if (settings.m_Filter == MipmapFilter::AlphaCoverage)
+	{
+		coverage = ComputeAlphaCoverage(chain, size_t(width) * height, settings.m_AlphaReference, 1);
+		preserveCoverage = (coverage > 0 && coverage < 1);
+	}
+
+	for (uint32_t level = 1; level < levelCount; level++)
+	{
+		const uint8_t* src = chain + GetLevelOffset(width, height, level - 1);
+		uint8_t* dst = chain + GetLevelOffset(width, height, level);
+
+		const uint32_t srcWidth = GetLevelSize(width, level - 1);
+		const uint32_t srcHeight = GetLevelSize(height, level - 1);
+		const uint32_t dstWidth = GetLevelSize(width, level);
+		const uint32_t dstHeight = GetLevelSize(height, level);
+
+		const bool evenHalving = (srcWidth % 2 == 0) && (srcHeight % 2 == 0 || srcHeight == 1);
+		if (settings.m_Filter != MipmapFilter::Kaiser && evenHalving)
+			DownsampleBox2x(src, srcWidth, srcHeight, dst);
+		else
+		{
+			const MipmapFilter filter = (settings.m_Filter == MipmapFilter::Kaiser) ? MipmapFilter::Kaiser : MipmapFilter::Box;
+			Resample(src, srcWidth, srcHeight, dst, dstWidth, dstHeight, filter, settings.m_WrapU, settings.m_WrapV);
+		}
+
+		if (preserveCoverage)
+			ScaleAlphaToCoverage(dst, size_t(dstWidth) * dstHeight, settings.m_AlphaReference, coverage);
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+enum class MipmapFilter
+{
+	// Just the full size image
+	None,
+
+	// Average of the texels each one covers. Sharp enough, and fast.
+	Box,
+
+	// Kaiser windowed sinc. Sharper than Box without much ringing, but a lot
+	// slower.
+	Kaiser,
+
+	// Box, then alpha scaled so the same fraction of every level passes an
+	// alpha test as of the full size image. Keeps cutout sprites and foliage
+	// from thinning out into nothing in the distance.
+	AlphaCoverage,
+};
+
+// Builds mip chains for tightly packed RGBA8 images on the CPU. Filtering is
+// done on the values as stored, which is right for UNORM formats.
+class MipmapGenerator final
+{
+public:
+	MipmapGenerator() = delete;
+	MipmapGenerator(const MipmapGenerator& other) = delete;
+	MipmapGenerator(MipmapGenerator&& other) = delete;
+	~MipmapGenerator() = delete;
+
+	struct Settings
+	{
+		MipmapFilter m_Filter = MipmapFilter::Box;
+
+		// Alpha test threshold that MipmapFilter::AlphaCoverage preserves
+		float m_AlphaReference = 0.5f;
+
+		// Whether the filters wrap around at the edges instead of clamping,
+		// which should match the sampler's address modes
+		bool m_WrapU = false;
+		bool m_WrapV = false;
+	};
+
+	// All the way down to 1x1.
+	static uint32_t GetLevelCount(uint32_t width, uint32_t height);
+	static uint32_t GetLevelSize(uint32_t size, uint32_t level) { return std::max<uint32_t>(size >> level, 1); }
+
+	// Every level one after another, without padding.
+	static size_t GetChainSize(uint32_t width, uint32_t height, uint32_t levelCount);
+	static size_t GetLevelOffset(uint32_t width, uint32_t height, uint32_t level) { return GetChainSize(width, height, level); }
+
+	// chain starts with level 0 and has room for GetChainSize() bytes. Fills in
+	// levels 1 through levelCount - 1, each one from the level before it.
+	static void Generate(uint8_t* chain, uint32_t width, uint32_t height, uint32_t levelCount, const Settings& settings);
+};
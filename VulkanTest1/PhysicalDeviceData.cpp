@@ -37,6 +37,8 @@ const vk::Bool32* PhysicalDeviceData::GetFeaturePtr(const vk::PhysicalDeviceFeat
 	{
 	case DeviceFeature::SamplerAnisotropy:
 		return &features.samplerAnisotropy;
+	case DeviceFeature::TextureCompressionBC:
+		return &features.textureCompressionBC;
 	}
 
 	assert(false);
@@ -82,6 +84,11 @@ bool PhysicalDeviceData::HasFeature(DeviceFeature feature) const
 	return *GetFeaturePtr(m_Features, feature);
 }
 
+bool PhysicalDeviceData::IsFeatureEnabled(DeviceFeature feature) const
+{
+	return *GetFeaturePtr(m_InitData->m_Features, feature);
+}
+
 std::vector<std::pair<uint32_t, vk::QueueFamilyProperties>> PhysicalDeviceData::GetQueueFamilies(const vk::QueueFlags& queueFlags)
 {
 	std::vector<std::pair<uint32_t, vk::QueueFamilyProperties>> retVal;
@@ -135,6 +142,14 @@ void PhysicalDeviceData::IncludeSwapchainRating(const SwapchainData& scData)
 }
 
 uint32_t PhysicalDeviceData::FindMemoryType(uint32_t typeFilter, const vk::MemoryPropertyFlags & properties) const
+{
+	if (const auto retVal = TryFindMemoryType(typeFilter, properties))
+		return *retVal;
+
+	throw rkrp_vulkan_exception("failed to find suitable memory type!");
+}
+
+std::optional<uint32_t> PhysicalDeviceData::TryFindMemoryType(uint32_t typeFilter, const vk::MemoryPropertyFlags& properties) const
 {
 	for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++)
 	{
@@ -142,7 +157,7 @@ uint32_t PhysicalDeviceData::FindMemoryType(uint32_t typeFilter, const vk::Memor
 			return i;
 	}
 
-	throw rkrp_vulkan_exception("failed to find suitable memory type!");
+	return std::nullopt;
 }
 
 void PhysicalDeviceData::RateDeviceSuitability()
@@ -265,6 +280,7 @@ void PhysicalDeviceData::RateDeviceFeatures()
 	static constexpr std::pair<DeviceFeature, float> OPTIONAL_FEATURES[] =
 	{
 		{ DeviceFeature::SamplerAnisotropy, 10.0f },
+		{ DeviceFeature::TextureCompressionBC, 5.0f },
 	};
 
 	for (const auto& feature : REQUIRED_FEATURES)
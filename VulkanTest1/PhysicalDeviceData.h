@@ -38,6 +38,8 @@ public:
 
 	bool HasExtension(const std::string_view& name) const;
 	bool HasFeature(DeviceFeature feature) const;
+	// Supported, and turned on for the logical device
+	bool IsFeatureEnabled(DeviceFeature feature) const;
 	const std::vector<vk::ExtensionProperties>& GetSupportedExtensions() const { return m_SupportedExtensions; }
 	const std::vector<vk::LayerProperties>& GetSupportedLayers() const { return m_SupportedLayers; }
 
@@ -60,6 +62,7 @@ public:
 	void IncludeSwapchainRating(const SwapchainData& scData);
 
 	uint32_t FindMemoryType(uint32_t typeFilter, const vk::MemoryPropertyFlags& properties) const;
+	std::optional<uint32_t> TryFindMemoryType(uint32_t typeFilter, const vk::MemoryPropertyFlags& properties) const;
 
 private:
 	PhysicalDeviceData();
@@ -3,39 +3,60 @@
 
 #include "BuiltinUniformBuffers.h"
 #include "ContentPaths.h"
+#include "JSONSchema.h"
 #include "ShaderModuleData.h"
 #include "ShaderModuleDataManager.h"
 
 #include <fstream>
 
+struct ShaderGroupData::ShaderDefinition
+{
+	std::string m_File;
+
+	static const auto& GetJSONSchema()
+	{
+		static const auto s_Schema = MakeJSONSchema<ShaderDefinition>(
+			JSONBind<&ShaderDefinition::m_File>("file", JSONPresence::Required));
+
+		return s_Schema;
+	}
+};
+
 ShaderGroupData::ShaderGroupData(const std::filesystem::path& path) :
-	ShaderGroupData(name_from_path(ContentPaths::Shaders(), path), JSONSerializer::FromFile(path).GetObject())
+	ShaderGroupData(name_from_path(ContentPaths::Shaders(), path), JSONReader(path))
 {
 }
 
 ShaderGroupData::ShaderGroupData(const std::string& name, const std::string& str) :
-	ShaderGroupData(name, JSONSerializer::FromString(str).GetObject())
+	ShaderGroupData(name, JSONReader(std::string_view(str)))
 {
 }
 
-ShaderGroupData::ShaderGroupData(const std::string& name, const JSONObject& json) :
+ShaderGroupData::ShaderGroupData(const std::string& name, JSONReader&& reader) :
 	m_Name(name)
 {
-	LoadShaders(json);
+	static const auto s_Schema = MakeJSONSchema<ShaderGroupData>(
+		JSONBind<ShaderGroupData>("shaders", &LoadShaders, JSONPresence::Required));
+
+	std::vector<std::string> unknownFields;
+	s_Schema.Read(reader, *this, &unknownFields);
+
+	for (const auto& field : unknownFields)
+		Log::TagMsg(TAG, "Warning: Unknown field \"{0}\" in shader group \"{1}\"", field, m_Name);
 }
 
-void ShaderGroupData::LoadShaders(const JSONObject& root)
+void ShaderGroupData::LoadShaders(JSONReader& reader, ShaderGroupData& data)
 {
-	for (const JSONValue& value : root.GetArray("shaders"))
-	{
-		const JSONObject& shaderObj = value.GetObject();
+	std::vector<ShaderDefinition> shaders;
+	JSONValueReader<std::vector<ShaderDefinition>>::Read(reader, shaders);
 
-		const auto& file = shaderObj.GetString("file");
-		const auto moduleData = ShaderModuleDataManager::Instance().Find(file);
+	for (const auto& shader : shaders)
+	{
+		const auto moduleData = ShaderModuleDataManager::Instance().Find(shader.m_File);
 		assert(moduleData);
 
 		const auto index = Enums::value(moduleData->GetType());
-		assert(!m_ShaderModulesData[index]);
-		m_ShaderModulesData[index] = moduleData;
+		assert(!data.m_ShaderModulesData[index]);
+		data.m_ShaderModulesData[index] = moduleData;
 	}
-}
\ No newline at end of file
+}
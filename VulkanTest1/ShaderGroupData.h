@@ -1,6 +1,6 @@
 #pragma once
 #include "BaseException.h"
-#include "JSON.h"
+#include "JSONReader.h"
 #include "ShaderParameterType.h"
 #include "ShaderType.h"
 
@@ -13,7 +13,7 @@ class ShaderGroupData
 public:
 	ShaderGroupData(const std::filesystem::path& path);
 	ShaderGroupData(const std::string& name, const std::string& str);
-	ShaderGroupData(const std::string& name, const JSONObject& json);
+	ShaderGroupData(const std::string& name, JSONReader&& reader);
 
 	class ParseException : public BaseException<>
 	{
@@ -26,7 +26,11 @@ public:
 	const auto& GetShaderModulesData() const { return m_ShaderModulesData; }
 
 private:
-	void LoadShaders(const JSONObject& root);
+	static constexpr char TAG[] = "[ShaderGroupData] ";
+
+	struct ShaderDefinition;
+
+	static void LoadShaders(JSONReader& reader, ShaderGroupData& data);
 
 	std::filesystem::path m_Path;
 	std::string m_Name;
@@ -3,6 +3,7 @@
 
 #include "ContentPaths.h"
 #include "ShaderGroupData.h"
+#include "ShaderModuleDataManager.h"
 
 #include <filesystem>
 
@@ -15,22 +16,12 @@ void ShaderGroupDataManager::Reload()
 {
 	ClearData();
 
-	for (auto& item : std::filesystem::recursive_directory_iterator(ContentPaths::Shaders()))
-	{
-		const auto& type = item.status().type();
-		if (type != std::filesystem::file_type::regular)
-			continue;
-
-		const auto& path = item.path();
-		if (!path.has_extension())
-			continue;
-
-		const auto& extension = path.extension();
-		if (extension != ".json")
-			continue;
+	// Shader groups look up their shader modules while loading
+	ShaderModuleDataManager::Instance();
 
+	AddFiles(FindFiles(ContentPaths::Shaders(), ".json"), [](const std::filesystem::path& path)
+	{
 		std::shared_ptr<const ShaderGroupData> data(std::make_shared<ShaderGroupData>(path));
-
-		AddPair(name_from_path(ContentPaths::Shaders(), data->GetName()), data);
-	}
+		return std::make_pair(name_from_path(ContentPaths::Shaders(), data->GetName()), data);
+	});
 }
\ No newline at end of file
@@ -11,7 +11,7 @@ ShaderModule::ShaderModule(const std::shared_ptr<const ShaderModuleData>& data,
 	m_Data(data),
 	m_Device(device)
 {
-	Log::Msg<LogType::ObjectLifetime>(__FUNCSIG__);
+	Log::DeferredMsg<LogType::ObjectLifetime>(__FUNCSIG__);
 
 	vk::ShaderModuleCreateInfo createInfo;
 
@@ -40,7 +40,7 @@ ShaderModuleData::ShaderModuleData(const std::filesystem::path& path) :
 	LoadSpecConstants(compiler);
 }
 
-const bool ShaderModuleData::HasInputFriendly(const std::string& friendly) const
+const bool ShaderModuleData::HasInputFriendly(const Atom& friendly) const
 {
 	return (m_InputConstants.find(friendly) != m_InputConstants.end() ||
 			m_InputTextures.find(friendly) != m_InputTextures.end() ||
@@ -102,7 +102,7 @@ void ShaderModuleData::LoadInputParams(const spirv_cross::Compiler& spirvComp)
 			newParam.m_Members.insert(std::make_pair(member.m_FriendlyName, member));
 		}
 
-		AssertAR(, m_InputVariables.insert(std::make_pair(newParam.m_FullName, newParam)), .second);
+		AssertAR(, m_InputVariables.insert(std::make_pair(Atom(newParam.m_FullName), newParam)), .second);
 	}
 
 	for (const auto& inputTexture : resources.sampled_images)
@@ -116,7 +116,8 @@ void ShaderModuleData::LoadInputParams(const spirv_cross::Compiler& spirvComp)
 		newParam.m_FullName = inputTexture.name;
 		newParam.ParseFullName();
 
-		const auto found = m_InputTextures.find(newParam.m_FriendlyName);
+		const Atom friendlyName(newParam.m_FriendlyName);
+		const auto found = m_InputTextures.find(friendlyName);
 		if (found != m_InputTextures.end())
 		{
 			found->second.m_Dimensions.push_back(newParam);
@@ -125,7 +126,7 @@ void ShaderModuleData::LoadInputParams(const spirv_cross::Compiler& spirvComp)
 		{
 			InputTexture newTexture;
 			newTexture.m_Dimensions.push_back(newParam);
-			AssertAR(, m_InputTextures.insert(std::make_pair(newParam.m_FriendlyName, newTexture)), .second);
+			AssertAR(, m_InputTextures.insert(std::make_pair(friendlyName, newTexture)), .second);
 		}
 	}
 }
@@ -150,9 +151,9 @@ void ShaderModuleData::LoadSpecConstants(const spirv_cross::Compiler& spirvComp)
 		newConstant.ParseFullName();
 
 		if (Enums::has_flag(newConstant.m_Decoration, InputConstant::Decoration::Parameter))
-			AssertAR(, m_InputConstants.insert(std::make_pair(newConstant.m_FriendlyName, newConstant)), .second);
+			AssertAR(, m_InputConstants.insert(std::make_pair(Atom(newConstant.m_FriendlyName), newConstant)), .second);
 		else
-			AssertAR(, m_InputConstants.insert(std::make_pair(newConstant.m_FullName, newConstant)), .second);
+			AssertAR(, m_InputConstants.insert(std::make_pair(Atom(newConstant.m_FullName), newConstant)), .second);
 	}
 }
 
@@ -1,4 +1,5 @@
 #pragma once
+#include "Atom.h"
 #include "BaseException.h"
 #include "ShaderParameterType.h"
 #include "ShaderType.h"
@@ -7,6 +8,7 @@
 
 #include <filesystem>
 #include <map>
+#include <unordered_map>
 
 namespace spirv_cross
 {
@@ -87,7 +89,7 @@ public:
 	const auto& GetInputSpecConstants() const { return m_InputConstants; }
 	const auto& GetInputTextures() const { return m_InputTextures; }
 
-	const bool HasInputFriendly(const std::string& friendly) const;
+	const bool HasInputFriendly(const Atom& friendly) const;
 
 private:
 	void LoadShaderType(const spirv_cross::Compiler& spirvComp);
@@ -106,9 +108,9 @@ private:
 
 	std::pair<std::vector<uint32_t>, size_t> m_CodeBytes;
 
-	std::map<std::string, InputVariable> m_InputVariables;		// Uniforms/whatever
-	std::map<std::string, InputTexture> m_InputTextures;		// Uniform sampler1D/2D/3D
-	std::map<std::string, InputConstant> m_InputConstants;		// Specialization constants
+	std::unordered_map<Atom, InputVariable> m_InputVariables;		// Uniforms/whatever
+	std::unordered_map<Atom, InputTexture> m_InputTextures;		// Uniform sampler1D/2D/3D
+	std::unordered_map<Atom, InputConstant> m_InputConstants;	// Specialization constants
 
 	ShaderType m_Type;
 	std::filesystem::path m_Path;
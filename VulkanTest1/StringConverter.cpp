@@ -1,2 +1,324 @@
 #include "stdafx.h"
 #include "StringConverter.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#ifndef _WIN32
+#include <locale.h>
+#endif
+
+namespace
+{
+	// What the text of a decimal number works out to, before it's rounded to a
+	// float or double: m_Mantissa * 10^m_Exponent.
+	struct DecimalNumber
+	{
+		enum class Kind
+		{
+			Finite,
+			Infinity,
+			NaN,
+		} m_Kind = Kind::Finite;
+
+		bool m_Negative = false;
+		uint64_t m_Mantissa = 0;
+		int64_t m_Exponent = 0;
+
+		// More than 19 significant digits, m_Mantissa only has the first 19
+		bool m_Truncated = false;
+	};
+
+	constexpr double POWERS_OF_10[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+	};
+	constexpr float POWERS_OF_10_FLOAT[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+}
+
+static bool MatchesNoCase(const char* it, const char* end, const std::string_view& lowercase)
+{
+	if (size_t(end - it) < lowercase.size())
+		return false;
+
+	for (size_t i = 0; i < lowercase.size(); i++)
+	{
+		if ((it[i] | 0x20) != lowercase[i])
+			return false;
+	}
+
+	return true;
+}
+
+// Returns the end of the number, or nullptr if there isn't one.
+static const char* ParseDecimal(const std::string_view& str, DecimalNumber& number)
+{
+	const char* it = str.data();
+	const char* const end = str.data() + str.size();
+
+	if (it != end && *it == '-')
+	{
+		number.m_Negative = true;
+		++it;
+	}
+
+	if (it != end && (*it | 0x20) == 'i')
+	{
+		if (!MatchesNoCase(it, end, "inf"sv))
+			return nullptr;
+
+		number.m_Kind = DecimalNumber::Kind::Infinity;
+		return it + (MatchesNoCase(it, end, "infinity"sv) ? 8 : 3);
+	}
+	if (it != end && (*it | 0x20) == 'n')
+	{
+		if (!MatchesNoCase(it, end, "nan"sv))
+			return nullptr;
+
+		number.m_Kind = DecimalNumber::Kind::NaN;
+		return it + 3;
+	}
+
+	constexpr size_t MAX_DIGITS = 19;	// Always fits in a uint64_t
+	size_t digitCount = 0;				// Significant ones, not counting leading zeros
+	bool anyDigits = false;
+
+	for (; it != end && *it >= '0' && *it <= '9'; ++it)
+	{
+		anyDigits = true;
+		if (digitCount < MAX_DIGITS)
+		{
+			number.m_Mantissa = number.m_Mantissa * 10 + unsigned(*it - '0');
+			digitCount += (number.m_Mantissa != 0);
+		}
+		else
+		{
+			number.m_Exponent++;
+			number.m_Truncated |= (*it != '0');
+		}
+	}
+
+	if (it != end && *it == '.')
+	{
+		const char* fraction = it + 1;
+		for (; fraction != end && *fraction >= '0' && *fraction <= '9'; ++fraction)
+		{
+			anyDigits = true;
+			if (digitCount < MAX_DIGITS)
+			{
+				number.m_Mantissa = number.m_Mantissa * 10 + unsigned(*fraction - '0');
+				digitCount += (number.m_Mantissa != 0);
+				number.m_Exponent--;
+			}
+			else
+				number.m_Truncated |= (*fraction != '0');
+		}
+
+		// "5." is a number, "." isn't
+		if (anyDigits)
+			it = fraction;
+	}
+
+	if (!anyDigits)
+		return nullptr;
+
+	// The exponent is only part of the number if it has at least one digit
+	if (it != end && (*it | 0x20) == 'e')
+	{
+		const char* exponentIt = it + 1;
+		bool exponentNegative = false;
+		if (exponentIt != end && (*exponentIt == '-' || *exponentIt == '+'))
+			exponentNegative = (*exponentIt++ == '-');
+
+		if (exponentIt != end && *exponentIt >= '0' && *exponentIt <= '9')
+		{
+			// Anything past this is out of range for a double anyway, whatever the mantissa
+			constexpr int64_t MAX_EXPONENT = 100000;
+
+			int64_t exponent = 0;
+			for (; exponentIt != end && *exponentIt >= '0' && *exponentIt <= '9'; ++exponentIt)
+				exponent = std::min(exponent * 10 + (*exponentIt - '0'), MAX_EXPONENT);
+
+			number.m_Exponent += exponentNegative ? -exponent : exponent;
+			it = exponentIt;
+		}
+	}
+
+	return it;
+}
+
+#ifdef _WIN32
+static _locale_t GetCLocale()
+{
+	static const _locale_t s_Locale = _create_locale(LC_ALL, "C");
+	return s_Locale;
+}
+#else
+static locale_t GetCLocale()
+{
+	static const locale_t s_Locale = newlocale(LC_ALL_MASK, "C", (locale_t)0);
+	return s_Locale;
+}
+#endif
+
+// The fast paths only handle numbers where a single multiply or divide is
+// exact. Everything else goes through the C runtime, pinned to the "C" locale.
+template<class T> static std::from_chars_result ParseSlow(const std::string_view& str, const char* numberEnd, T& value)
+{
+	// strtod wants a null terminator, which str may not have
+	const size_t length = size_t(numberEnd - str.data());
+	char stackBuffer[128];
+	std::string heapBuffer;
+	char* buffer = stackBuffer;
+	if (length >= std::size(stackBuffer))
+	{
+		heapBuffer.assign(str.data(), length);
+		buffer = heapBuffer.data();
+	}
+	else
+	{
+		memcpy(stackBuffer, str.data(), length);
+		stackBuffer[length] = '\0';
+	}
+
+	errno = 0;
+	char* parsedEnd;
+	T parsed;
+#ifdef _WIN32
+	if constexpr (std::is_same_v<T, float>)
+		parsed = _strtof_l(buffer, &parsedEnd, GetCLocale());
+	else
+		parsed = _strtod_l(buffer, &parsedEnd, GetCLocale());
+#else
+	if constexpr (std::is_same_v<T, float>)
+		parsed = strtof_l(buffer, &parsedEnd, GetCLocale());
+	else
+		parsed = strtod_l(buffer, &parsedEnd, GetCLocale());
+#endif
+
+	assert(parsedEnd == buffer + length);
+
+	// ERANGE is also set on underflow, but the denormal or zero that comes back
+	// is still the correctly rounded value. Only overflowing to infinity is
+	// out of range.
+	if (errno == ERANGE && std::isinf(parsed))
+		return { numberEnd, std::errc::result_out_of_range };
+
+	value = parsed;
+	return { numberEnd, std::errc() };
+}
+
+std::from_chars_result StringConverter::Parse(const std::string_view& str, double& value)
+{
+	DecimalNumber number;
+	const char* const numberEnd = ParseDecimal(str, number);
+	if (!numberEnd)
+		return { str.data(), std::errc::invalid_argument };
+
+	if (number.m_Kind != DecimalNumber::Kind::Finite)
+	{
+		const double special = (number.m_Kind == DecimalNumber::Kind::Infinity) ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+		value = number.m_Negative ? -special : special;
+		return { numberEnd, std::errc() };
+	}
+
+	// Clinger's fast path: integers up to 2^53 and powers of 10 up to 10^22 are
+	// both exact as doubles, so one correctly rounded operation gives the answer
+	constexpr uint64_t MAX_EXACT_MANTISSA = uint64_t(1) << 53;
+	if (!number.m_Truncated && number.m_Mantissa <= MAX_EXACT_MANTISSA)
+	{
+		double result = double(number.m_Mantissa);
+		bool exact = true;
+		if (number.m_Mantissa == 0)
+			result = 0;
+		else if (number.m_Exponent < 0 && number.m_Exponent >= -22)
+			result /= POWERS_OF_10[-number.m_Exponent];
+		else if (number.m_Exponent >= 0 && number.m_Exponent <= 22)
+			result *= POWERS_OF_10[number.m_Exponent];
+		else if (number.m_Exponent > 22 && number.m_Exponent <= 22 + 15)
+		{
+			// Something like 12e30, where the mantissa can soak up the extra
+			// zeroes and still be exact
+			const double scaled = result * POWERS_OF_10[number.m_Exponent - 22];
+			exact = (scaled <= double(MAX_EXACT_MANTISSA));
+			result = scaled * POWERS_OF_10[22];
+		}
+		else
+			exact = false;
+
+		if (exact)
+		{
+			value = number.m_Negative ? -result : result;
+			return { numberEnd, std::errc() };
+		}
+	}
+
+	return ParseSlow(str, numberEnd, value);
+}
+
+std::from_chars_result StringConverter::Parse(const std::string_view& str, float& value)
+{
+	DecimalNumber number;
+	const char* const numberEnd = ParseDecimal(str, number);
+	if (!numberEnd)
+		return { str.data(), std::errc::invalid_argument };
+
+	if (number.m_Kind != DecimalNumber::Kind::Finite)
+	{
+		const float special = (number.m_Kind == DecimalNumber::Kind::Infinity) ? std::numeric_limits<float>::infinity() : std::numeric_limits<float>::quiet_NaN();
+		value = number.m_Negative ? -special : special;
+		return { numberEnd, std::errc() };
+	}
+
+	// Same as for doubles, with 2^24 and 10^10. Rounding via a double first
+	// would round twice, which is occasionally off by one.
+	if (!number.m_Truncated && number.m_Mantissa <= (uint64_t(1) << 24) &&
+		number.m_Exponent >= -10 && number.m_Exponent <= 10)
+	{
+		float result = float(number.m_Mantissa);
+		if (number.m_Exponent < 0)
+			result /= POWERS_OF_10_FLOAT[-number.m_Exponent];
+		else
+			result *= POWERS_OF_10_FLOAT[number.m_Exponent];
+
+		value = number.m_Negative ? -result : result;
+		return { numberEnd, std::errc() };
+	}
+
+	return ParseSlow(str, numberEnd, value);
+}
+
+std::to_chars_result StringConverter::Format(char* first, char* last, double value)
+{
+	// v141 has no floating point std::to_chars, so this tries the fewest digits
+	// first and keeps the first one that reads back as the same number. 17
+	// digits always does.
+	int length = 0;
+	for (int precision = 15; precision <= 17; precision++)
+	{
+#ifdef _WIN32
+		length = _snprintf_l(first, size_t(last - first), "%.*g", GetCLocale(), precision, value);
+#else
+		const locale_t previous = uselocale(GetCLocale());
+		length = snprintf(first, size_t(last - first), "%.*g", precision, value);
+		uselocale(previous);
+#endif
+
+		// _snprintf_l returns -1 instead of the length it needed
+		if (length < 0 || length >= last - first)
+			return { last, std::errc::value_too_large };
+
+		double parsed;
+		if (Parse(std::string_view(first, size_t(length)), parsed).ec == std::errc() && parsed == value)
+			break;
+	}
+
+	return { first + length, std::errc() };
+}
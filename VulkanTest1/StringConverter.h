@@ -1,10 +1,18 @@
 #pragma once
 #include <cassert>
+#include <charconv>
 #include <cstdint>
-#include <string>
-#include <sstream>
+#include <limits>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
 #include <utility>
 
+// Number parsing with std::from_chars semantics: never looks past the end of the
+// string_view, doesn't skip leading whitespace or accept a leading '+', and
+// ignores the current C locale. On failure ec is set and value is left alone:
+// std::errc::invalid_argument (ptr == str.data()) if there was no number at
+// all, or std::errc::result_out_of_range (ptr past the digits) if it didn't fit.
 class StringConverter final
 {
 public:
@@ -13,54 +21,96 @@ public:
 	StringConverter(StringConverter&& other) = delete;
 	~StringConverter() = delete;
 
+	// base can be anything from 2 to 36. No "0x" style prefix is accepted.
+	template<class T> static constexpr std::from_chars_result Parse(const std::string_view& str, T& value, int base = 10);
+
+	// Decimal, with an optional fraction and exponent, or inf/infinity/nan.
+	// Correctly rounded. Too small to represent rounds to a denormal or zero,
+	// only too big is out of range.
+	static std::from_chars_result Parse(const std::string_view& str, float& value);
+	static std::from_chars_result Parse(const std::string_view& str, double& value);
+
+	// The shortest "%g" style text that Parse() reads back as exactly value,
+	// always with a '.' whatever the C locale says. Not null terminated.
+	// std::errc::value_too_large if it doesn't fit, 32 chars is always enough.
+	static std::to_chars_result Format(char* first, char* last, double value);
+
 	template<class ValueT> static ValueT From(const std::string_view& str, size_t* charsRead = nullptr, bool* success = nullptr);
 
-	static uint32_t ToUInt32(const std::string_view& str, size_t* charsRead = nullptr, bool* success = nullptr);
-	static uint64_t ToUInt64(const std::string_view& str, size_t* charsRead = nullptr, bool* success = nullptr);
+	static uint32_t ToUInt32(const std::string_view& str, size_t* charsRead = nullptr, bool* success = nullptr) { return From<uint32_t>(str, charsRead, success); }
+	static uint64_t ToUInt64(const std::string_view& str, size_t* charsRead = nullptr, bool* success = nullptr) { return From<uint64_t>(str, charsRead, success); }
+
+private:
+	// 0-35 for digits and letters, something >= 36 for anything else
+	static constexpr unsigned DigitValue(char c)
+	{
+		if (c >= '0' && c <= '9')
+			return unsigned(c - '0');
+		if (c >= 'a' && c <= 'z')
+			return unsigned(c - 'a' + 10);
+		if (c >= 'A' && c <= 'Z')
+			return unsigned(c - 'A' + 10);
+
+		return ~0u;
+	}
 };
 
-template<>
-__forceinline uint32_t StringConverter::From<uint32_t>(const std::string_view& str, size_t* charsRead, bool* success)
+template<class T> inline constexpr std::from_chars_result StringConverter::Parse(const std::string_view& str, T& value, int base)
 {
-	return ToUInt32(str, charsRead, success);
-}
+	static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>);
+	assert(base >= 2 && base <= 36);
 
-template<>
-__forceinline uint64_t StringConverter::From<uint64_t>(const std::string_view& str, size_t* charsRead, bool* success)
-{
-	return ToUInt64(str, charsRead, success);
-}
+	using UnsignedT = std::make_unsigned_t<T>;
 
-inline uint32_t StringConverter::ToUInt32(const std::string_view & str, size_t* charsRead, bool* success)
-{
-	uint32_t retVal;
-	int read;
+	const char* it = str.data();
+	const char* const end = str.data() + str.size();
 
-	if (charsRead)
-		read = sscanf_s(str.data(), "%u%zn", &retVal, charsRead);
-	else
-		read = sscanf_s(str.data(), "%u", &retVal);
+	bool negative = false;
+	if constexpr (std::is_signed_v<T>)
+	{
+		if (it != end && *it == '-')
+		{
+			negative = true;
+			++it;
+		}
+	}
 
-	assert(read == 0 || read == 1);
-	if (success)
-		*success = (read == 1);
+	const UnsignedT limit = negative ? UnsignedT(UnsignedT(std::numeric_limits<T>::max()) + 1) : UnsignedT(std::numeric_limits<T>::max());
 
-	return retVal;
+	const char* const digitsStart = it;
+	UnsignedT result = 0;
+	bool overflow = false;
+	for (; it != end; ++it)
+	{
+		const unsigned digit = DigitValue(*it);
+		if (digit >= unsigned(base))
+			break;
+
+		// Keep going after overflowing, ptr has to end up past all the digits
+		if (result > (limit - digit) / unsigned(base))
+			overflow = true;
+		else
+			result = UnsignedT(result * unsigned(base) + digit);
+	}
+
+	if (it == digitsStart)
+		return { str.data(), std::errc::invalid_argument };
+	if (overflow)
+		return { it, std::errc::result_out_of_range };
+
+	value = negative ? T(UnsignedT(0) - result) : T(result);
+	return { it, std::errc() };
 }
 
-inline uint64_t StringConverter::ToUInt64(const std::string_view& str, size_t* charsRead, bool* success)
+template<class ValueT> inline ValueT StringConverter::From(const std::string_view& str, size_t* charsRead, bool* success)
 {
-	uint64_t retVal;
-	int read;
+	ValueT retVal{};
+	const auto result = Parse(str, retVal);
 
 	if (charsRead)
-		read = sscanf_s(str.data(), "%llu%zn", &retVal, charsRead);
-	else
-		read = sscanf_s(str.data(), "%llu", &retVal);
-
-	assert(read == 0 || read == 1);
+		*charsRead = size_t(result.ptr - str.data());
 	if (success)
-		*success = (read == 1);
+		*success = (result.ec == std::errc());
 
 	return retVal;
-}
\ No newline at end of file
+}
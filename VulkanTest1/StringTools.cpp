@@ -4,6 +4,20 @@
 #include <cassert>
 #include <cuchar>
 #include <sstream>
+#include <streambuf>
+#include <unordered_map>
+
+#if defined(__AVX2__)
+#define UTF8_SIMD_AVX2 1
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UTF8_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 void StringTools::UnitTests()
 {
@@ -16,6 +30,53 @@ void StringTools::UnitTests()
 	assert(IsEscaped(testString, 11));
 	assert(!IsEscaped(testString, 23));
 	assert(IsEscaped(testString, 24));
+
+	static_assert(CSFMT("{0} and {1}, \\{2}").GetTokenCount() == 2);
+	static_assert(CSFMT("{ {0} }").GetTokenCount() == 1);
+	static_assert(CSFMT("{:}").GetTokenCount() == 0);
+	assert(CSFormat("{1} {0}{0} \\{0}", "a"sv, 2) == "2 aa \\{0}");
+	assert(CSFormat(CSFMT("{1} {0}{0} \\{0}"), "a"sv, 2) == "2 aa \\{0}");
+
+	assert(CSFormat("{0} {1} {2} {3} {4}", -42, 16.6666666, 1e20f, true, 'x') == "-42 16.6667 1e+20 1 x");
+	assert(CSFormat("{0} {1}", std::optional<int>(3), std::filesystem::path("a/b.json")) == "{optional: 3} a/b.json");
+
+	std::string appended = "prefix ";
+	CSFormatTo(appended, CSFMT("{0}"), "suffix");
+	assert(appended == "prefix suffix");
+
+	const std::string_view utf8 = u8"ASCII text long enough to fill a couple of blocks, then é, 🔥 and ████"sv;
+	assert(UTF8Validate(utf8));
+	assert(UTF8CountCodePoints(utf8) == 69);
+	assert(UTF8FindCodePoint(utf8, 56) == 56);
+	assert(UTF8FindCodePoint(utf8, 57) == 58);
+	assert(UTF8FindCodePoint(utf8, 69) == utf8.size());
+	assert(UTF8FindInvalid("abc\xC0\x80"sv) == 3);		// Overlong
+	assert(UTF8FindInvalid("abc\xED\xA0\x80"sv) == 3);	// Surrogate
+	assert(UTF8FindInvalid("abc\xF0\x9F\x94"sv) == 3);	// Truncated
+
+	static_assert(CSFMT("{99999999999999999999999}").GetTokenCount() == 0);	// ID doesn't fit in a size_t
+	assert(StringConverter::ToUInt32("4294967295 ") == 4294967295u);
+	assert(StringConverter::From<int8_t>("-128") == -128);
+
+	bool success = true;
+	size_t charsRead = 0;
+	StringConverter::ToUInt32("4294967296", &charsRead, &success);
+	assert(!success && charsRead == 10);
+	StringConverter::ToUInt64(" 1", &charsRead, &success);
+	assert(!success && charsRead == 0);
+
+	uint32_t hex = 0;
+	assert(StringConverter::Parse("fF", hex, 16).ec == std::errc() && hex == 0xFF);
+	assert(StringConverter::From<double>("-1.5e3x", &charsRead) == -1500 && charsRead == 6);
+	assert(StringConverter::From<double>("0.1") == 0.1);
+	assert(StringConverter::From<double>("2.2250738585072011e-308") == 2.2250738585072011e-308);	// Slow path
+	assert(StringConverter::From<float>("3.4028235e38") == 3.4028235e38f);
+	assert(StringConverter::From<float>("1e", &charsRead) == 1 && charsRead == 1);
+	assert(StringConverter::From<double>("1e-400", nullptr, &success) == 0 && success);		// Underflows to zero
+	assert(StringConverter::From<double>("5e-324", nullptr, &success) > 0 && success);		// Smallest denormal
+	assert(StringConverter::From<float>("1e-50", nullptr, &success) == 0 && success);
+	StringConverter::From<double>("1e400", nullptr, &success);
+	assert(!success);
 }
 
 bool StringTools::BeginsWith(const std::string& full, const std::string& beginning)
@@ -64,111 +125,327 @@ size_t StringTools::UTF8Size(const char* ptr, const char* endPtr)
 	throw utf8_exception("Malformed utf-8 byte");
 }
 
-std::vector<StringTools::CSToken> StringTools::ParseCSTokens(const std::string_view& str)
+#if UTF8_SIMD_AVX2 || UTF8_SIMD_SSE2
+#define UTF8_SIMD 1
+
+#if UTF8_SIMD_AVX2
+static constexpr size_t UTF8_BLOCK_SIZE = 32;
+
+// Bit i is set if block[i] isn't ASCII
+static __forceinline uint32_t NonASCIIMask(const char* block)
 {
-	enum class GatherMode
-	{
-		Fresh,
-		GatheringMode,
-		GatheredMode,
-		GatheredID,
-		GatheringData,
+	return uint32_t(_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block))));
+}
+
+// Bit i is set if block[i] starts a code point, ie. isn't a continuation byte.
+// Continuation bytes (0x80-0xBF) are exactly the ones below -64 as signed chars.
+static __forceinline uint32_t LeadByteMask(const char* block)
+{
+	const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+	return ~uint32_t(_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(-64), bytes)));
+}
+#else
+static constexpr size_t UTF8_BLOCK_SIZE = 16;
 
-		// Throw this CSToken away, it's malformed somehow
-		Garbage,
-	} gatherMode = GatherMode::Fresh;
+static __forceinline uint32_t NonASCIIMask(const char* block)
+{
+	return uint32_t(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block))));
+}
 
-	std::vector<CSToken> retVal;
+static __forceinline uint32_t LeadByteMask(const char* block)
+{
+	const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+	return ~uint32_t(_mm_movemask_epi8(_mm_cmplt_epi8(bytes, _mm_set1_epi8(-64)))) & 0xFFFF;
+}
+#endif
 
-	size_t i = 0;
-	size_t braceLevel = 0;
+static __forceinline uint32_t CountBits(uint32_t value)
+{
+	// popcnt isn't guaranteed on SSE2-only machines
+	value = value - ((value >> 1) & 0x55555555);
+	value = (value & 0x33333333) + ((value >> 2) & 0x33333333);
+	return (((value + (value >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+}
+
+static __forceinline uint32_t CountTrailingZeros(uint32_t value)
+{
+	assert(value);
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, value);
+	return index;
+#else
+	return __builtin_ctz(value);
+#endif
+}
+#endif
 
-	bool isEscaped = false;
+static __forceinline bool IsUTF8Continuation(uint8_t c)
+{
+	return (c & 0xC0) == 0x80;
+}
 
-	CSToken current;
+// Length of the valid sequence starting at data, or 0 if there isn't one.
+// See https://www.unicode.org/versions/Unicode10.0.0/ch03.pdf, table 3-7.
+static size_t ValidateUTF8Sequence(const uint8_t* data, size_t remaining)
+{
+	const uint8_t lead = data[0];
+	if (lead < 0x80)
+		return 1;
 
-	for (auto charIter = str.begin(); charIter != str.end(); charIter++)
+	// The second byte's range is narrower after the leads that could otherwise
+	// encode overlong forms, surrogates or code points past U+10FFFF
+	size_t length;
+	uint8_t secondMin = 0x80;
+	uint8_t secondMax = 0xBF;
+	if (lead >= 0xC2 && lead <= 0xDF)
+		length = 2;
+	else if (lead >= 0xE0 && lead <= 0xEF)
 	{
-		const char& c = *charIter;
-		if (isEscaped)
-			isEscaped = false;
-		else if (c == '\\')
-			isEscaped = true;
-		else if (c == '{')
-		{
-			braceLevel++;
+		length = 3;
+		if (lead == 0xE0)
+			secondMin = 0xA0;
+		else if (lead == 0xED)
+			secondMax = 0x9F;
+	}
+	else if (lead >= 0xF0 && lead <= 0xF4)
+	{
+		length = 4;
+		if (lead == 0xF0)
+			secondMin = 0x90;
+		else if (lead == 0xF4)
+			secondMax = 0x8F;
+	}
+	else
+		return 0;
 
-			if (braceLevel == 1)
-			{
-				gatherMode = GatherMode::Fresh;
+	if (remaining < length || data[1] < secondMin || data[1] > secondMax)
+		return 0;
 
-				current.m_ID = 0;
-				current.m_FullTokenStart = i;
-				current.m_ModeStart = current.m_ModeEnd = 0;
-				current.m_DataStart = current.m_DataEnd = 0;
+	for (size_t i = 2; i < length; i++)
+	{
+		if (!IsUTF8Continuation(data[i]))
+			return 0;
+	}
+
+	return length;
+}
+
+size_t StringTools::UTF8FindInvalid(const std::string_view& str)
+{
+	const uint8_t* const data = reinterpret_cast<const uint8_t*>(str.data());
+	const size_t size = str.size();
+
+	size_t i = 0;
+	while (i < size)
+	{
+#if UTF8_SIMD
+		// Most of our text is ASCII, skip it a block at a time
+		if (size - i >= UTF8_BLOCK_SIZE)
+		{
+			const uint32_t nonASCII = NonASCIIMask(str.data() + i);
+			if (!nonASCII)
+			{
+				i += UTF8_BLOCK_SIZE;
+				continue;
 			}
+
+			i += CountTrailingZeros(nonASCII);
 		}
-		else if (c == ':' && braceLevel == 1)
+#endif
+
+		const size_t length = ValidateUTF8Sequence(data + i, size - i);
+		if (!length)
+			return i;
+
+		i += length;
+	}
+
+	return str.npos;
+}
+
+size_t StringTools::UTF8CountCodePoints(const std::string_view& str)
+{
+	size_t retVal = 0;
+	size_t i = 0;
+
+#if UTF8_SIMD
+	for (; str.size() - i >= UTF8_BLOCK_SIZE; i += UTF8_BLOCK_SIZE)
+		retVal += CountBits(LeadByteMask(str.data() + i));
+#endif
+
+	for (; i < str.size(); i++)
+	{
+		if (!IsUTF8Continuation(uint8_t(str[i])))
+			retVal++;
+	}
+
+	return retVal;
+}
+
+size_t StringTools::UTF8FindCodePoint(const std::string_view& str, size_t index)
+{
+	size_t i = 0;
+
+#if UTF8_SIMD
+	for (; str.size() - i >= UTF8_BLOCK_SIZE; i += UTF8_BLOCK_SIZE)
+	{
+		uint32_t leads = LeadByteMask(str.data() + i);
+		const size_t count = CountBits(leads);
+		if (index < count)
 		{
-			if (gatherMode == GatherMode::Fresh || gatherMode == GatherMode::GatheredMode)
-				gatherMode = GatherMode::Garbage;
-			else
-				gatherMode = GatherMode::GatheringData;
+			// It's in this block, clear the lowest set bit until it's the one we want
+			for (; index; index--)
+				leads &= leads - 1;
 
-			current.m_DataStart = i + 1;
+			return i + CountTrailingZeros(leads);
 		}
-		else if (c == '}')
+
+		index -= count;
+	}
+#endif
+
+	for (; i < str.size(); i++)
+	{
+		if (IsUTF8Continuation(uint8_t(str[i])))
+			continue;
+
+		if (!index)
+			return i;
+
+		index--;
+	}
+
+	return str.size();
+}
+
+const std::vector<StringTools::CSToken>& StringTools::GetCachedCSTokens(const std::string_view& fmt, std::vector<CSToken>& uncached)
+{
+	struct CacheEntry
+	{
+		std::string m_Format;
+		std::vector<CSToken> m_Tokens;
+	};
+
+	// Keyed by hash so lookups don't need to build a std::string. Almost every
+	// format string is a literal, so this stays small. Entries are never removed,
+	// since an argument being formatted can format something else while the
+	// caller is still using its tokens.
+	static constexpr size_t MAX_CACHED_FORMATS = 1024;
+	thread_local std::unordered_map<size_t, CacheEntry> s_Cache;
+
+	const size_t hash = std::hash<std::string_view>()(fmt);
+	if (const auto found = s_Cache.find(hash); found != s_Cache.end())
+	{
+		if (found->second.m_Format == fmt)
+			return found->second.m_Tokens;
+	}
+	else if (s_Cache.size() < MAX_CACHED_FORMATS)
+	{
+		CacheEntry& entry = s_Cache[hash];
+		entry.m_Format = fmt;
+		ParseCSTokens(fmt, [&entry](const CSToken& token) { entry.m_Tokens.push_back(token); });
+		return entry.m_Tokens;
+	}
+
+	// Hash collision or a full cache
+	ParseCSTokens(fmt, [&uncached](const CSToken& token) { uncached.push_back(token); });
+	return uncached;
+}
+
+void StringTools::AssembleCSFormat(std::string& out, const std::string_view& fmt, const CSToken* tokens, size_t tokenCount,
+	const CSArg* args, size_t argCount)
+{
+	size_t copied = 0;
+	for (size_t i = 0; i < tokenCount; i++)
+	{
+		const CSToken& token = tokens[i];
+
+		// Tokens without a matching argument are left as they are
+		assert(token.m_ID < argCount);
+		if (token.m_ID >= argCount)
+			continue;
+
+		out.append(fmt.data() + copied, token.m_FullTokenStart - copied);
+
+		const CSArg& arg = args[token.m_ID];
+		arg.m_Append(out, arg.m_Value);
+
+		copied = token.m_FullTokenEnd;
+	}
+
+	out.append(fmt.data() + copied, fmt.size() - copied);
+}
+
+void StringTools::CSFormatToPreformatted(std::string& out, const std::string_view& fmt, const std::string_view* args, size_t argCount)
+{
+	if (!argCount)
+	{
+		out.append(fmt);
+		return;
+	}
+
+	std::vector<CSArg> csArgs(argCount);
+	for (size_t i = 0; i < argCount; i++)
+		csArgs[i] = { &args[i], &AppendCSArg<std::string_view> };
+
+	std::vector<CSToken> uncached;
+	const auto& tokens = GetCachedCSTokens(fmt, uncached);
+
+	AssembleCSFormat(out, fmt, tokens.data(), tokens.size(), csArgs.data(), argCount);
+}
+
+static thread_local std::string s_ScratchString;
+static thread_local bool s_ScratchStringBorrowed;
+
+StringTools::ScratchString::ScratchString()
+{
+	if (s_ScratchStringBorrowed)
+	{
+		m_String = &m_Fallback;
+		return;
+	}
+
+	s_ScratchStringBorrowed = true;
+	m_String = &s_ScratchString;
+	m_String->clear();
+}
+
+StringTools::ScratchString::~ScratchString()
+{
+	if (m_String == &s_ScratchString)
+		s_ScratchStringBorrowed = false;
+}
+
+std::string*& StringTools::GetAppendTarget()
+{
+	thread_local std::string* s_Target;
+	return s_Target;
+}
+
+std::ostream& StringTools::GetAppendStream()
+{
+	// Sends everything written to the stream to the end of the current target
+	class AppendBuffer final : public std::streambuf
+	{
+	protected:
+		int_type overflow(int_type c) override
 		{
-			assert(braceLevel >= 1);
-			if (braceLevel >= 1)
-				braceLevel--;
+			if (!traits_type::eq_int_type(c, traits_type::eof()))
+				GetAppendTarget()->push_back(traits_type::to_char_type(c));
 
-			if (!braceLevel)
-			{
-				if (gatherMode == GatherMode::GatheringData)
-					current.m_DataEnd = i;
-				else if (gatherMode == GatherMode::Fresh)
-					gatherMode = GatherMode::Garbage;
-
-				if (gatherMode != GatherMode::Garbage)
-				{
-					current.m_FullTokenEnd = i + 1;
-					retVal.push_back(current);
-				}
-			}
+			return traits_type::not_eof(c);
 		}
-		else if (gatherMode == GatherMode::Fresh)
+		std::streamsize xsputn(const char* s, std::streamsize count) override
 		{
-			if (isdigit(c))
-			{
-				assert(&c == (str.data() + i));
-				size_t charsRead;
-				bool success;
-				current.m_ID = StringConverter::From<size_t>(std::string_view(str.data() + i, str.size() - i), &charsRead, &success);
-
-				if (!success)
-					gatherMode = GatherMode::Garbage;
-				else
-				{
-					gatherMode = GatherMode::GatheredID;
-					charIter += charsRead;
-					i += charsRead;
-					charIter -= 1;
-					i -= 1;
-				}
-			}
-			else
-			{
-				current.m_ModeStart = i;
-				current.m_ModeEnd = 0;
-				gatherMode = GatherMode::GatheringMode;
-			}
+			GetAppendTarget()->append(s, size_t(count));
+			return count;
 		}
+	};
 
-		i++;
-	}
-
-	return retVal;
+	thread_local AppendBuffer s_Buffer;
+	thread_local std::ostream s_Stream(&s_Buffer);
+	return s_Stream;
 }
 
 #if 0
@@ -1,11 +1,18 @@
 #pragma once
 #include <cassert>
-//#include <filesystem>			// More to_string stuff
 //#include <glm/detail/type_mat4x4.hpp>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <locale>
 #include <optional>
+#include <ostream>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 //#include <vulkan/vulkan.hpp>	// For all the to_string goodness
 
@@ -42,22 +49,16 @@ constexpr std::wstring_view operator "" sv(const wchar_t* str, size_t len) noexc
 #pragma warning(pop)
 #endif
 
+// Appends the text form of a CSFormat argument to a string. Specialize this for
+// types that need their own formatting, see the bottom of this file for examples.
+template<class T, class = void> struct CSFormatter;
+
+// Formats a single value the same way CSFormat would.
 template<class T> std::string to_string(const T& value)
 {
-	std::ostringstream ss;
-	ss << value;
-	return ss.str();
-}
-template<class T> std::string to_string(const std::optional<T>& value)
-{
-	std::ostringstream ss;
-
-	if (value.has_value())
-		ss << "{optional: "sv << value.value() << "}"sv;
-	else
-		ss << "{optional "sv << typeid(T).name() << ": nullopt}"sv;
-
-	return ss.str();
+	std::string retVal;
+	CSFormatter<T>::Append(retVal, value);
+	return retVal;
 }
 
 class utf8_exception : public std::runtime_error
@@ -76,12 +77,48 @@ public:
 
 	static void UnitTests();
 
-	template<class... Args> static std::string CSFormat(const char* fmt, const Args&... args) { return CSFormat(std::string(fmt), args...); }
+	// A format string tokenized at compile time, see CSFMT().
+	template<size_t N> class CSFormatString;
+
+	template<class... Args> static std::string CSFormat(const char* fmt, const Args&... args) { return CSFormat(std::string_view(fmt), args...); }
 	static std::string CSFormat(const char* fmt) { return std::string(fmt); }
-	template<class... Args> static std::string CSFormat(std::string fmt, const Args&... args);
+	template<class... Args> static std::string CSFormat(const std::string& fmt, const Args&... args) { return CSFormat(std::string_view(fmt), args...); }
 	static std::string CSFormat(const std::string& fmt) { return fmt; }
-	template<class... Args> static std::string CSFormat(const std::string_view& fmt, const Args&... args) { return CSFormat(std::string(fmt), args...); }
+	template<class... Args> static std::string CSFormat(const std::string_view& fmt, const Args&... args);
 	static std::string CSFormat(const std::string_view& fmt) { return std::string(fmt); }
+	template<size_t N, class... Args> static std::string CSFormat(const CSFormatString<N>& fmt, const Args&... args);
+
+	// Same as CSFormat, but appends to out rather than returning a new string.
+	template<class... Args> static void CSFormatTo(std::string& out, const std::string_view& fmt, const Args&... args);
+	template<size_t N, class... Args> static void CSFormatTo(std::string& out, const CSFormatString<N>& fmt, const Args&... args);
+
+	// For argument lists that are only known at runtime: {i} is replaced with
+	// args[i], which has already been formatted. Gives exactly what CSFormat
+	// would have, given arguments that format to those strings.
+	static void CSFormatToPreformatted(std::string& out, const std::string_view& fmt, const std::string_view* args, size_t argCount);
+
+	// Borrows this thread's scratch string for formatting into. It starts out
+	// empty, but keeps its capacity from earlier uses. If the scratch string is
+	// already borrowed further up the stack (an argument that logs while it's
+	// being formatted), this gets a string of its own instead.
+	class ScratchString
+	{
+	public:
+		ScratchString();
+		ScratchString(const ScratchString& other) = delete;
+		~ScratchString();
+
+		ScratchString& operator=(const ScratchString& other) = delete;
+
+		std::string& Get() { return *m_String; }
+
+	private:
+		std::string* m_String;
+		std::string m_Fallback;
+	};
+
+	// Writes value to out with its operator<<, without going through a temporary string.
+	template<class T> static void AppendStreamed(std::string& out, const T& value);
 
 	template<class CharT> static bool IsEscaped(const CharT* str, size_t offset, CharT escapeChar = '\\');
 	template<class CharT, class Traits, class Alloc> static bool IsEscaped(const std::basic_string<CharT, Traits, Alloc>& str, size_t offset, CharT escapeChar = '\\');
@@ -92,6 +129,19 @@ public:
 	// Determines the number of bytes in a utf8 character.
 	static size_t UTF8Size(const char* ptr, const char* endPtr = nullptr);
 
+	// Bulk UTF-8 routines, vectorized with SSE2/AVX2 where available.
+	//
+	// Offset of the first byte that doesn't start a valid sequence (including
+	// overlong forms, surrogates and anything past U+10FFFF), or npos if all of
+	// str is valid.
+	static size_t UTF8FindInvalid(const std::string_view& str);
+	static bool UTF8Validate(const std::string_view& str) { return UTF8FindInvalid(str) == str.npos; }
+	// Number of code points in str. str must be valid UTF-8.
+	static size_t UTF8CountCodePoints(const std::string_view& str);
+	// Byte offset where code point index starts, or str.size() if there are
+	// only index (or fewer) code points. str must be valid UTF-8.
+	static size_t UTF8FindCodePoint(const std::string_view& str, size_t index);
+
 	template<class T> static constexpr bool is_char_v =
 		std::is_same_v<T, char> ||
 		std::is_same_v<T, wchar_t> ||
@@ -106,42 +156,225 @@ public:
 private:
 	struct CSToken
 	{
-		size_t m_FullTokenStart;
-		size_t m_FullTokenEnd;
+		size_t m_FullTokenStart = 0;
+		size_t m_FullTokenEnd = 0;
 
-		size_t m_ID;
+		size_t m_ID = 0;
 
-		size_t m_DataStart;
-		size_t m_DataEnd;
+		size_t m_DataStart = 0;
+		size_t m_DataEnd = 0;
 
-		size_t m_ModeStart;
-		size_t m_ModeEnd;
+		size_t m_ModeStart = 0;
+		size_t m_ModeEnd = 0;
 	};
 
-	static std::vector<CSToken> ParseCSTokens(const std::string_view& str);
+	// Calls tokenFunc(const CSToken&) for each token in str, in order. constexpr
+	// so CSFormatString can run it at compile time.
+	template<class TokenFunc> static constexpr void ParseCSTokens(const std::string_view& str, TokenFunc&& tokenFunc);
+
+	// Tokens for a runtime format string, parsed on the first call with that
+	// string and cached per thread after that. Cached tokens stay valid for the
+	// life of the thread. If fmt can't be cached, it's parsed into uncached.
+	static const std::vector<CSToken>& GetCachedCSTokens(const std::string_view& fmt, std::vector<CSToken>& uncached);
+
+	// Type-erased argument, so the assembly doesn't need to be a template
+	struct CSArg
+	{
+		const void* m_Value;
+		void(*m_Append)(std::string& out, const void* value);
+	};
+	template<class T> static void AppendCSArg(std::string& out, const void* value) { CSFormatter<T>::Append(out, *static_cast<const T*>(value)); }
+
+	// Appends fmt to out in a single pass, writing each token's argument straight
+	// into out as it's reached. Arguments that no token refers to are never formatted.
+	static void AssembleCSFormat(std::string& out, const std::string_view& fmt, const CSToken* tokens, size_t tokenCount,
+		const CSArg* args, size_t argCount);
+
+	// This thread's stream for AppendStreamed, and the string it's currently appending to
+	static std::ostream& GetAppendStream();
+	static std::string*& GetAppendTarget();
 };
 
-template<class... Args>
-inline std::string StringTools::CSFormat(std::string fmt, const Args&... args)
+// Macro so the literal can be tokenized in a constant expression:
+//	Log::Msg(CSFMT("Loaded {0} in {1} ms"), name, time);
+#define CSFMT(fmt) ([]() { constexpr StringTools::CSFormatString<sizeof(fmt)> retVal(fmt); return retVal; }())
+
+template<size_t N> class StringTools::CSFormatString
 {
-	std::string strArgs[] = { to_string(args)... };
+public:
+	constexpr CSFormatString(const char(&fmt)[N]) : m_Format(fmt, N - 1)
+	{
+		ParseCSTokens(m_Format, [this](const CSToken& token) { m_Tokens[m_TokenCount++] = token; });
+	}
 
-	constexpr size_t argCount = sizeof...(args);
+	constexpr const std::string_view& GetFormat() const { return m_Format; }
+	constexpr size_t GetTokenCount() const { return m_TokenCount; }
 
-	std::vector<CSToken> tokens = ParseCSTokens(fmt);
+private:
+	friend class StringTools;
+
+	std::string_view m_Format;
+
+	// Every token is at least 3 characters ("{0}")
+	CSToken m_Tokens[N / 3 + 1] = {};
+	size_t m_TokenCount = 0;
+};
 
-	for (auto tokenIter = tokens.crbegin(); tokenIter != tokens.crend(); tokenIter++)
+template<class... Args>
+inline std::string StringTools::CSFormat(const std::string_view& fmt, const Args&... args)
+{
+	std::string retVal;
+	retVal.reserve(fmt.size() + 16 * sizeof...(args));
+	CSFormatTo(retVal, fmt, args...);
+	return retVal;
+}
+
+template<size_t N, class... Args>
+inline std::string StringTools::CSFormat(const CSFormatString<N>& fmt, const Args&... args)
+{
+	std::string retVal;
+	retVal.reserve(fmt.m_Format.size() + 16 * sizeof...(args));
+	CSFormatTo(retVal, fmt, args...);
+	return retVal;
+}
+
+template<class... Args>
+inline void StringTools::CSFormatTo(std::string& out, const std::string_view& fmt, const Args&... args)
+{
+	if constexpr (sizeof...(args) == 0)
 	{
-		// For now, we're lame
-		// Just replace the tokens with the stringified args based on the tokens' ID
-		const CSToken& token = *tokenIter;
+		// Like CSFormat(fmt), no arguments means nothing gets replaced
+		out.append(fmt);
+	}
+	else
+	{
+		const CSArg csArgs[] = { { &args, &AppendCSArg<Args> }... };
+
+		std::vector<CSToken> uncached;
+		const auto& tokens = GetCachedCSTokens(fmt, uncached);
 
-		assert(token.m_ID < argCount);
+		AssembleCSFormat(out, fmt, tokens.data(), tokens.size(), csArgs, sizeof...(args));
+	}
+}
 
-		fmt.replace(fmt.begin() + token.m_FullTokenStart, fmt.begin() + token.m_FullTokenEnd, strArgs[token.m_ID]);
+template<size_t N, class... Args>
+inline void StringTools::CSFormatTo(std::string& out, const CSFormatString<N>& fmt, const Args&... args)
+{
+	if constexpr (sizeof...(args) == 0)
+		out.append(fmt.m_Format);
+	else
+	{
+		const CSArg csArgs[] = { { &args, &AppendCSArg<Args> }... };
+		AssembleCSFormat(out, fmt.m_Format, fmt.m_Tokens, fmt.m_TokenCount, csArgs, sizeof...(args));
 	}
+}
+
+template<class T>
+inline void StringTools::AppendStreamed(std::string& out, const T& value)
+{
+	// Points the stream back at whatever it was writing to before, even if
+	// operator<< throws or formats something else with this stream itself
+	struct TargetScope
+	{
+		TargetScope(std::string*& target, std::string& out) : m_Target(target), m_Previous(target) { m_Target = &out; }
+		~TargetScope() { m_Target = m_Previous; }
+
+		std::string*& m_Target;
+		std::string* m_Previous;
+	};
+
+	TargetScope scope(GetAppendTarget(), out);
+
+	std::ostream& stream = GetAppendStream();
+	stream << value;
+	stream.clear();
+}
+
+template<class TokenFunc>
+inline constexpr void StringTools::ParseCSTokens(const std::string_view& str, TokenFunc&& tokenFunc)
+{
+	enum class GatherMode
+	{
+		Fresh,
+		GatheringMode,
+		GatheredID,
+		GatheringData,
+
+		// Throw this CSToken away, it's malformed somehow
+		Garbage,
+	} gatherMode = GatherMode::Fresh;
+
+	size_t braceLevel = 0;
+	bool isEscaped = false;
 
-	return fmt;
+	CSToken current;
+
+	for (size_t i = 0; i < str.size(); i++)
+	{
+		const char c = str[i];
+		if (isEscaped)
+			isEscaped = false;
+		else if (c == '\\')
+			isEscaped = true;
+		else if (c == '{')
+		{
+			braceLevel++;
+
+			if (braceLevel == 1)
+			{
+				gatherMode = GatherMode::Fresh;
+
+				current = CSToken();
+				current.m_FullTokenStart = i;
+			}
+		}
+		else if (c == ':' && braceLevel == 1)
+		{
+			if (gatherMode == GatherMode::Fresh)
+				gatherMode = GatherMode::Garbage;
+			else
+				gatherMode = GatherMode::GatheringData;
+
+			current.m_DataStart = i + 1;
+		}
+		else if (c == '}')
+		{
+			// Stray closing braces are left alone
+			if (!braceLevel)
+				continue;
+
+			if (!--braceLevel)
+			{
+				if (gatherMode == GatherMode::GatheringData)
+					current.m_DataEnd = i;
+				else if (gatherMode == GatherMode::Fresh)
+					gatherMode = GatherMode::Garbage;
+
+				if (gatherMode != GatherMode::Garbage)
+				{
+					current.m_FullTokenEnd = i + 1;
+					tokenFunc(std::as_const(current));
+				}
+			}
+		}
+		else if (braceLevel && gatherMode == GatherMode::Fresh)
+		{
+			if (c >= '0' && c <= '9')
+			{
+				size_t id = 0;
+				const auto result = StringConverter::Parse(str.substr(i), id);
+
+				current.m_ID = id;
+				gatherMode = (result.ec == std::errc()) ? GatherMode::GatheredID : GatherMode::Garbage;
+				i = size_t(result.ptr - str.data()) - 1;
+			}
+			else
+			{
+				current.m_ModeStart = i;
+				gatherMode = GatherMode::GatheringMode;
+			}
+		}
+	}
 }
 
 template<class CharT>
@@ -171,4 +404,143 @@ inline bool StringTools::IsEscaped(const std::basic_string_view<CharT, Traits>&
 	}
 
 	return escaped;
-}
\ No newline at end of file
+}
+
+namespace detail
+{
+	// Finds to_string() overloads that live alongside T, like vk::to_string(),
+	// without finding the to_string() template at the top of this file.
+	namespace csformat_adl
+	{
+		template<class T> void to_string(const T& value) = delete;
+
+		template<class T, class = void> struct has_to_string : std::false_type {};
+		template<class T> struct has_to_string<T, std::void_t<decltype(to_string(std::declval<const T&>()))>> :
+			std::is_same<decltype(to_string(std::declval<const T&>())), std::string> {};
+
+		template<class T> std::string call_to_string(const T& value) { return to_string(value); }
+	}
+
+	// glm vectors and matrices, without needing to include glm
+	template<class T, class = void> struct is_csformat_vector : std::false_type {};
+	template<class T> struct is_csformat_vector<T, std::void_t<typename T::value_type,
+		decltype(std::declval<const T&>().length()), decltype(std::declval<const T&>()[0])>> :
+		std::bool_constant<!std::is_class_v<typename T::value_type> || is_csformat_vector<typename T::value_type>::value> {};
+}
+
+template<class T, class> struct CSFormatter
+{
+	static void Append(std::string& out, const T& value)
+	{
+		if constexpr (detail::csformat_adl::has_to_string<T>::value)
+		{
+			if constexpr (std::is_enum_v<T>)
+			{
+				// Vulkan's to_string() builds a new std::string every time, so keep hold of them
+				thread_local std::unordered_map<std::underlying_type_t<T>, std::string> s_Names;
+
+				const auto key = static_cast<std::underlying_type_t<T>>(value);
+				auto found = s_Names.find(key);
+				if (found == s_Names.end())
+					found = s_Names.emplace(key, detail::csformat_adl::call_to_string(value)).first;
+
+				out += found->second;
+			}
+			else
+				out += detail::csformat_adl::call_to_string(value);
+		}
+		else if constexpr (detail::is_csformat_vector<T>::value)
+		{
+			out += '(';
+			for (decltype(value.length()) i = 0; i < value.length(); i++)
+			{
+				if (i)
+					out += ", "sv;
+
+				CSFormatter<std::decay_t<decltype(value[i])>>::Append(out, value[i]);
+			}
+			out += ')';
+		}
+		else
+			StringTools::AppendStreamed(out, value);
+	}
+};
+
+template<class T> struct CSFormatter<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool> &&
+	!std::is_same_v<T, char> && !std::is_same_v<T, signed char> && !std::is_same_v<T, unsigned char>>>
+{
+	static void Append(std::string& out, T value)
+	{
+		char buffer[24];
+		const auto result = std::to_chars(buffer, buffer + std::size(buffer), value);
+		out.append(buffer, result.ptr);
+	}
+};
+template<class T> struct CSFormatter<T, std::enable_if_t<std::is_floating_point_v<T>>>
+{
+	static void Append(std::string& out, T value)
+	{
+		// Matches operator<<'s default of 6 significant digits
+		char buffer[32];
+		const int length = snprintf(buffer, std::size(buffer), "%g", double(value));
+		out.append(buffer, length);
+	}
+};
+template<> struct CSFormatter<bool>
+{
+	// Same as operator<< without std::boolalpha
+	static void Append(std::string& out, bool value) { out += value ? '1' : '0'; }
+};
+template<> struct CSFormatter<char>
+{
+	static void Append(std::string& out, char value) { out += value; }
+};
+template<> struct CSFormatter<signed char>
+{
+	static void Append(std::string& out, signed char value) { out += char(value); }
+};
+template<> struct CSFormatter<unsigned char>
+{
+	static void Append(std::string& out, unsigned char value) { out += char(value); }
+};
+template<> struct CSFormatter<const char*>
+{
+	static void Append(std::string& out, const char* value) { out += value ? value : "(null)"; }
+};
+template<> struct CSFormatter<char*> : CSFormatter<const char*> {};
+template<size_t N> struct CSFormatter<char[N]>
+{
+	static void Append(std::string& out, const char(&value)[N]) { out.append(value, strnlen(value, N)); }
+};
+template<> struct CSFormatter<std::string>
+{
+	static void Append(std::string& out, const std::string& value) { out += value; }
+};
+template<> struct CSFormatter<std::string_view>
+{
+	static void Append(std::string& out, const std::string_view& value) { out += value; }
+};
+template<> struct CSFormatter<std::filesystem::path>
+{
+	static void Append(std::string& out, const std::filesystem::path& value)
+	{
+		if constexpr (std::is_same_v<std::filesystem::path::value_type, char>)
+			out += value.native();
+		else
+			out += value.u8string();
+	}
+};
+template<class T> struct CSFormatter<std::optional<T>>
+{
+	static void Append(std::string& out, const std::optional<T>& value)
+	{
+		if (value.has_value())
+		{
+			out += "{optional: "sv;
+			CSFormatter<T>::Append(out, value.value());
+			out += '}';
+		}
+		else
+			out.append("{optional "sv).append(typeid(T).name()).append(": nullopt}"sv);
+	}
+};
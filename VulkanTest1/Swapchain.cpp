@@ -18,7 +18,7 @@ std::vector<vk::Framebuffer> Swapchain::GetFramebuffers() const
 Swapchain::Swapchain(const std::shared_ptr<const SwapchainData>& data, LogicalDevice& device) :
 	m_Data(data), m_Device(device)
 {
-	Log::Msg<LogType::ObjectLifetime>(__FUNCSIG__);
+	Log::DeferredMsg<LogType::ObjectLifetime>(__FUNCSIG__);
 	Init();
 }
 
@@ -0,0 +1,133 @@
+#include "stdafx.h"
+#include "TaskGraph.h"
+
+#include "AtomicWait.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <memory>
+
+struct TaskGraph::RunState
+{
+	RunState(ThreadPool& pool, size_t taskCount) :
+		m_Pool(pool),
+		m_RemainingDependencies(std::make_unique<std::atomic<size_t>[]>(taskCount)),
+		m_DependencyFailed(std::make_unique<std::atomic<bool>[]>(taskCount)),
+		m_Unfinished(taskCount)
+	{
+	}
+
+	ThreadPool& m_Pool;
+	std::chrono::steady_clock::time_point m_StartTime = std::chrono::steady_clock::now();
+
+	std::unique_ptr<std::atomic<size_t>[]> m_RemainingDependencies;
+	std::unique_ptr<std::atomic<bool>[]> m_DependencyFailed;
+
+	// Changes are announced with AtomicWait::NotifyAll() when it reaches zero
+	std::atomic<size_t> m_Unfinished;
+};
+
+auto TaskGraph::Add(const std::string_view& name, const std::function<void()>& fn, const std::initializer_list<TaskID>& dependencies) -> TaskID
+{
+	const TaskID retVal = m_Tasks.size();
+
+	for (TaskID dependency : dependencies)
+	{
+		if (dependency >= retVal)
+			throw std::invalid_argument(StringTools::CSFormat("Task \"{0}\" depends on task {1}, which hasn't been added yet", name, dependency));
+
+		m_Tasks[dependency].m_Dependents.push_back(retVal);
+	}
+
+	m_Tasks.emplace_back();
+	Task& task = m_Tasks.back();
+	task.m_Name = name;
+	task.m_Function = fn;
+	task.m_DependencyCount = dependencies.size();
+
+	return retVal;
+}
+
+void TaskGraph::Run(ThreadPool& pool)
+{
+	if (m_Tasks.empty())
+		return;
+
+	RunState state(pool, m_Tasks.size());
+	for (TaskID i = 0; i < m_Tasks.size(); i++)
+	{
+		Task& task = m_Tasks[i];
+		task.m_StartTime = task.m_Duration = Duration::zero();
+		task.m_Exception = nullptr;
+		task.m_Skipped = false;
+
+		state.m_RemainingDependencies[i] = task.m_DependencyCount;
+		state.m_DependencyFailed[i] = false;
+	}
+
+	// Everything after this can only be touched by workers until m_Unfinished
+	// reaches zero
+	for (TaskID i = 0; i < m_Tasks.size(); i++)
+	{
+		if (!m_Tasks[i].m_DependencyCount)
+			pool.Submit([this, &state, i]() { RunTask(state, i); });
+	}
+
+	size_t unfinished;
+	while ((unfinished = state.m_Unfinished.load(std::memory_order_acquire)) != 0)
+		AtomicWait::Wait(state.m_Unfinished, unfinished);
+
+	m_TotalDuration = std::chrono::steady_clock::now() - state.m_StartTime;
+
+	for (const Task& task : m_Tasks)
+	{
+		if (task.m_Exception)
+			std::rethrow_exception(task.m_Exception);
+	}
+}
+
+void TaskGraph::RunTask(RunState& state, TaskID id)
+{
+	Task& task = m_Tasks[id];
+
+	const auto start = std::chrono::steady_clock::now();
+	task.m_StartTime = start - state.m_StartTime;
+
+	try
+	{
+		task.m_Function();
+	}
+	catch (...)
+	{
+		task.m_Exception = std::current_exception();
+	}
+
+	task.m_Duration = std::chrono::steady_clock::now() - start;
+
+	Finish(state, id, !task.m_Exception);
+}
+
+void TaskGraph::Finish(RunState& state, TaskID id, bool succeeded)
+{
+	for (TaskID dependentID : m_Tasks[id].m_Dependents)
+	{
+		if (!succeeded)
+			state.m_DependencyFailed[dependentID].store(true, std::memory_order_relaxed);
+
+		// Whoever finishes the last dependency starts it
+		if (state.m_RemainingDependencies[dependentID].fetch_sub(1, std::memory_order_acq_rel) != 1)
+			continue;
+
+		if (state.m_DependencyFailed[dependentID].load(std::memory_order_relaxed))
+		{
+			m_Tasks[dependentID].m_Skipped = true;
+			Finish(state, dependentID, false);
+		}
+		else
+			state.m_Pool.Submit([this, &state, dependentID]() { RunTask(state, dependentID); });
+	}
+
+	// Has to be the last thing we touch, Run() may return as soon as this hits zero
+	if (state.m_Unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		AtomicWait::NotifyAll(&state.m_Unfinished);
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class ThreadPool;
+
+// A set of named tasks and what each one has to wait for. Run() starts every
+// task as soon as everything it depends on has finished, so independent ones
+// run side by side, and records when each one started and how long it took.
+class TaskGraph
+{
+public:
+	using TaskID = size_t;
+	using Duration = std::chrono::duration<float, std::milli>;
+
+	// Dependencies have to be added first, which rules out cycles.
+	TaskID Add(const std::string_view& name, const std::function<void()>& fn, const std::initializer_list<TaskID>& dependencies = {});
+
+	// Runs every task on pool and returns once they've all finished or been
+	// skipped. A task is skipped if anything it depends on threw or was skipped
+	// itself. The exception from the first task (in the order they were added)
+	// that threw is rethrown here.
+	//
+	// Blocks the calling thread, so don't call it from one of pool's workers.
+	void Run(ThreadPool& pool);
+
+	size_t size() const { return m_Tasks.size(); }
+	const std::string& GetName(TaskID task) const { return m_Tasks.at(task).m_Name; }
+
+	// From the last Run(). Start times are relative to when Run() was called.
+	Duration GetStartTime(TaskID task) const { return m_Tasks.at(task).m_StartTime; }
+	Duration GetDuration(TaskID task) const { return m_Tasks.at(task).m_Duration; }
+	bool WasSkipped(TaskID task) const { return m_Tasks.at(task).m_Skipped; }
+	Duration GetTotalDuration() const { return m_TotalDuration; }
+
+private:
+	struct Task
+	{
+		std::string m_Name;
+		std::function<void()> m_Function;
+		std::vector<TaskID> m_Dependents;
+		size_t m_DependencyCount = 0;
+
+		// Results of the last Run()
+		Duration m_StartTime{};
+		Duration m_Duration{};
+		std::exception_ptr m_Exception;
+		bool m_Skipped = false;
+	};
+
+	struct RunState;
+	void RunTask(RunState& state, TaskID task);
+	void Finish(RunState& state, TaskID task, bool succeeded);
+
+	std::vector<Task> m_Tasks;
+	Duration m_TotalDuration{};
+};
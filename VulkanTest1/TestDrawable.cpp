@@ -32,7 +32,7 @@ TestDrawable::TestDrawable(LogicalDevice& device) :
 	m_Transform.SetTranslation(glm::vec2(300, 0));
 	m_Transform.SetScale(glm::vec2(300));
 
-	m_Material = MaterialManager::Instance().Find("test_material");
+	m_Material = MaterialManager::Instance().FindAsync("test_material");
 	m_Mesh = Mesh::Create(GetTestVertexList());
 }
 
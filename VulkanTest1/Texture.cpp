@@ -1,18 +1,21 @@
 #include "stdafx.h"
 #include "Texture.h"
 
+#include "BlockCompressor.h"
+#include "ImageDecoder.h"
 #include "LogicalDevice.h"
+#include "MipmapGenerator.h"
+#include "TextureCooker.h"
 #include "TextureCreateInfo.h"
+#include "ThreadPool.h"
 #include "Vulkan.h"
 #include "VulkanDebug.h"
-#include "VulkanHelpers.h"
-
-#include "stb_image.h"
-
-#include <fstream>
 
 Texture::~Texture()
 {
+	// The device might not have got to the upload yet
+	m_UploadToken.Wait();
+
 	m_ImageView.reset();
 	m_Image.reset();
 	m_DeviceMemory.reset();
@@ -22,55 +25,15 @@ Texture::Texture(LogicalDevice& device, const std::shared_ptr<const TextureCreat
 	m_Device(device),
 	m_CreateInfo(createInfo)
 {
-	Log::Msg<LogType::ObjectLifetime>(__FUNCSIG__);
+	Log::DeferredMsg<LogType::ObjectLifetime>(__FUNCSIG__);
 
-	const auto& sourceImages = LoadSourceImages();
-	const auto& firstImg = sourceImages.front();
-
-	Buffer stagingBuffer(m_Device, firstImg.GetImgDataSize() * sourceImages.size(), vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
-	{
-		const size_t tempBufferSize = firstImg.GetImgDataSize();
-		const size_t tempBufferStride = firstImg.GetImgDataStride();
-
-		stagingBuffer.Write(firstImg.m_Image.get(), tempBufferSize, 0);
-
-		if (sourceImages.size() > 1)
-		{
-			std::unique_ptr<uint8_t> tempBuffer((uint8_t*)malloc(tempBufferSize));
-			for (size_t i = 1; i < sourceImages.size(); i++)
-			{
-				const auto& img = sourceImages[i];
-
-				if (img.m_Width != firstImg.m_Width)
-				{
-					if (i > 1)
-						memset(tempBuffer.get(), 0, tempBufferSize);
-
-					const auto imgStride = img.GetImgDataStride();
-					const auto minStride = std::min(imgStride, tempBufferStride);
-					const auto minHeight = std::min(img.m_Height, firstImg.m_Height);
-
-					// Copy line by line
-					for (size_t y = 0; y < minHeight; y++)
-						memcpy(tempBuffer.get() + tempBufferStride * y, (uint8_t*)img.m_Image.get() + imgStride * y, minStride);
-
-					stagingBuffer.Write(tempBuffer.get(), tempBufferSize, tempBufferSize * i);
-				}
-				else
-				{
-					stagingBuffer.Write(img.m_Image.get(), tempBufferSize, tempBufferSize * i);
-				}
-			}
-		}
-	}
+	// Either one also fills in the image type, extent, level count, and format
+	std::vector<vk::DeviceSize> levelOffsets;
+	std::unique_ptr<Buffer> stagingBuffer = CanUseCooked() ? LoadCooked(levelOffsets) : LoadSources(levelOffsets);
 
 	// Setup final image
 	{
-		m_ImageCreateInfo.setImageType(sourceImages.size() == 1 ? vk::ImageType::e2D : vk::ImageType::e3D);
-		m_ImageCreateInfo.setExtent(vk::Extent3D(firstImg.m_Width, firstImg.m_Height, sourceImages.size()));
-		m_ImageCreateInfo.setMipLevels(1);
 		m_ImageCreateInfo.setArrayLayers(1);
-		m_ImageCreateInfo.setFormat(vk::Format::eR8G8B8A8Unorm);
 		m_ImageCreateInfo.setTiling(vk::ImageTiling::eOptimal);
 		m_ImageCreateInfo.setInitialLayout(vk::ImageLayout::ePreinitialized);
 		m_ImageCreateInfo.setUsage(vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled);
@@ -92,44 +55,95 @@ Texture::Texture(LogicalDevice& device, const std::shared_ptr<const TextureCreat
 
 	m_Device->bindImageMemory(m_Image.get(), m_DeviceMemory.get(), 0);
 
-	// Copy from staging to final
+	CreateImageView();
+	CreateSampler();
+
+	// Copy from staging to final, along with everything else loaded this frame.
+	// Last, so nothing can throw afterwards and destroy the image under it.
 	{
-		TransitionImageLayout(m_Image.get(), m_ImageCreateInfo.format, vk::ImageLayout::ePreinitialized, vk::ImageLayout::eTransferDstOptimal);
-		CopyBufferToImage(stagingBuffer.Get(), m_Image.get(), m_ImageCreateInfo.extent);
-		TransitionImageLayout(m_Image.get(), m_ImageCreateInfo.format, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+		vk::ImageSubresourceRange range;
+		range.setAspectMask(vk::ImageAspectFlagBits::eColor);
+		range.setLevelCount(m_ImageCreateInfo.mipLevels);
+		range.setLayerCount(1);
+
+		m_UploadToken = m_Device.GetUploadBatch().UploadImage(std::move(stagingBuffer), m_Image.get(), range, GetCopyRegions(levelOffsets));
 	}
+}
 
-	CreateImageView();
-	CreateSampler();
+bool Texture::CanUseCooked() const
+{
+	if (!TextureCooker::CanCook(*m_CreateInfo))
+		return false;
+
+	// Without BC support, the sources are the only way to get an image the
+	// device can sample
+	return m_CreateInfo->m_Compression == TextureCompression::None || m_Device.GetData().IsFeatureEnabled(DeviceFeature::TextureCompressionBC);
 }
 
-std::vector<Texture::SourceImage> Texture::LoadSourceImages()
+std::unique_ptr<Buffer> Texture::LoadCooked(std::vector<vk::DeviceSize>& levelOffsets)
 {
-	std::vector<SourceImage> retVal;
-	stbi_set_flip_vertically_on_load(true);
+	const CookedTexture cooked = TextureCooker::LoadOrCook(*m_CreateInfo);
 
-	for (const auto& path : m_CreateInfo->m_SourceFiles)
-	{
-		std::ifstream file(path.string(), std::ios::binary | std::ios::ate);
-		assert(file.good());
+	m_ImageCreateInfo.setImageType(vk::ImageType::e2D);
+	m_ImageCreateInfo.setExtent(vk::Extent3D(cooked.m_Width, cooked.m_Height, 1));
+	m_ImageCreateInfo.setMipLevels(cooked.m_LevelCount);
+	m_ImageCreateInfo.setFormat(cooked.m_Format);
 
-		const auto length = file.tellg();
-		std::shared_ptr<void> buffer(malloc(length));
-		file.seekg(0);
+	for (uint32_t level = 0; level < cooked.m_LevelCount; level++)
+		levelOffsets.push_back(cooked.GetLevelOffset(level));
 
-		file.read(reinterpret_cast<char*>(buffer.get()), length);
+	auto retVal = std::make_unique<Buffer>(m_Device, cooked.m_Data.size(), vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+	retVal->Write(cooked.m_Data.data(), cooked.m_Data.size(), 0);
+	return retVal;
+}
 
-		SourceImage newImg;
-		newImg.m_Image.reset(stbi_load_from_memory(reinterpret_cast<stbi_uc*>(buffer.get()), length, &newImg.m_Width, &newImg.m_Height, &newImg.m_Channels, 4));
+std::unique_ptr<Buffer> Texture::LoadSources(std::vector<vk::DeviceSize>& levelOffsets)
+{
+	uint32_t width, height;
+	ImageDecoder::ReadSize(m_CreateInfo->m_SourceFiles.front(), width, height);
 
-		if (newImg.m_Width <= 0 || newImg.m_Height <= 0 || newImg.m_Channels <= 0)
-			throw std::runtime_error(StringTools::CSFormat("Failed to load raw img in {0}(): width {1}, height {2}, channels {3}, image pointer {4}",
-														   __FUNCTION__, newImg.m_Width, newImg.m_Height, newImg.m_Channels, newImg.m_Image.get()));
+	const uint32_t frameCount = uint32_t(m_CreateInfo->m_SourceFiles.size());
 
-		retVal.push_back(newImg);
-	}
+	// Animated textures are 3D images, and mipmapping those would halve the
+	// frame count along with the size and blend neighbouring frames together
+	uint32_t mipLevels = 1;
+	if (frameCount == 1 && m_CreateInfo->m_MipmapFilter != MipmapFilter::None)
+		mipLevels = MipmapGenerator::GetLevelCount(width, height);
 
-	return retVal;
+	const size_t stagingSize = (mipLevels > 1) ?
+		MipmapGenerator::GetChainSize(width, height, mipLevels) :
+		size_t(width) * height * 4 * frameCount;
+
+	// Everything is decoded and filtered in place. Mipmapping reads each level
+	// back to build the next, which is painfully slow from uncached memory.
+	auto stagingBuffer = std::make_unique<Buffer>(m_Device, stagingSize, vk::BufferUsageFlagBits::eTransferSrc,
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+		(mipLevels > 1) ? vk::MemoryPropertyFlagBits::eHostCached : vk::MemoryPropertyFlags());
+
+	LoadSourceImages(stagingBuffer->GetMappedData(), width, height);
+
+	if (mipLevels > 1)
+		MipmapGenerator::Generate(stagingBuffer->GetMappedData(), width, height, mipLevels, m_CreateInfo->GetMipmapSettings());
+
+	m_ImageCreateInfo.setImageType(frameCount == 1 ? vk::ImageType::e2D : vk::ImageType::e3D);
+	m_ImageCreateInfo.setExtent(vk::Extent3D(width, height, frameCount));
+	m_ImageCreateInfo.setMipLevels(mipLevels);
+	m_ImageCreateInfo.setFormat(vk::Format::eR8G8B8A8Unorm);
+
+	for (uint32_t level = 0; level < mipLevels; level++)
+		levelOffsets.push_back(MipmapGenerator::GetLevelOffset(width, height, level));
+
+	return stagingBuffer;
+}
+
+void Texture::LoadSourceImages(uint8_t* frames, uint32_t width, uint32_t height) const
+{
+	const size_t frameSize = size_t(width) * height * 4;
+
+	ThreadPool::Default().ParallelFor(m_CreateInfo->m_SourceFiles.size(), [&](size_t i)
+	{
+		ImageDecoder::Decode(m_CreateInfo->m_SourceFiles[i], frames + frameSize * i, width, height);
+	});
 }
 
 void Texture::CreateImageView()
@@ -143,8 +157,9 @@ void Texture::CreateImageView()
 
 	m_ImageViewCreateInfo.setImage(m_Image.get());
 	m_ImageViewCreateInfo.setFormat(m_ImageCreateInfo.format);
+	m_ImageViewCreateInfo.setComponents(BlockCompressor::GetComponentMapping(m_ImageCreateInfo.format));
 	m_ImageViewCreateInfo.subresourceRange.setAspectMask(vk::ImageAspectFlagBits::eColor);
-	m_ImageViewCreateInfo.subresourceRange.setLevelCount(1);
+	m_ImageViewCreateInfo.subresourceRange.setLevelCount(m_ImageCreateInfo.mipLevels);
 	m_ImageViewCreateInfo.subresourceRange.setLayerCount(1);
 
 	m_ImageView = m_Device->createImageViewUnique(m_ImageViewCreateInfo);
@@ -172,66 +187,32 @@ void Texture::CreateSampler()
 	m_SamplerCreateInfo.setMipmapMode(vk::SamplerMipmapMode::eLinear);
 	m_SamplerCreateInfo.setMipLodBias(0);
 	m_SamplerCreateInfo.setMinLod(0);
-	m_SamplerCreateInfo.setMaxLod(0);
+	m_SamplerCreateInfo.setMaxLod(float(m_ImageCreateInfo.mipLevels));
 
 	m_Sampler = m_Device->createSamplerUnique(m_SamplerCreateInfo);
 }
 
-void Texture::TransitionImageLayout(const vk::Image& img, vk::Format /*format*/, vk::ImageLayout oldLayout, vk::ImageLayout newLayout) const
+std::vector<vk::BufferImageCopy> Texture::GetCopyRegions(const std::vector<vk::DeviceSize>& levelOffsets) const
 {
-	auto cmdBuf = m_Device.AllocCommandBuffer();
-	cmdBuf->begin(VulkanHelpers::CBBI_ONE_TIME_SUBMIT);
-	{
-		vk::ImageMemoryBarrier barrier;
-		barrier.setOldLayout(oldLayout);
-		barrier.setNewLayout(newLayout);
-
-		barrier.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
-		barrier.setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
-
-		barrier.setImage(img);
-		barrier.subresourceRange.setAspectMask(vk::ImageAspectFlagBits::eColor);
-		barrier.subresourceRange.setLevelCount(1);
-		barrier.subresourceRange.setLayerCount(1);
-
-		if (oldLayout == vk::ImageLayout::ePreinitialized && newLayout == vk::ImageLayout::eTransferDstOptimal)
-		{
-			barrier.setSrcAccessMask(vk::AccessFlagBits::eHostWrite);
-			barrier.setDstAccessMask(vk::AccessFlagBits::eTransferWrite);
-		}
-		else if (oldLayout == vk::ImageLayout::eTransferDstOptimal && newLayout == vk::ImageLayout::eShaderReadOnlyOptimal)
-		{
-			barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
-			barrier.setDstAccessMask(vk::AccessFlagBits::eShaderRead);
-		}
-		else
-			throw std::invalid_argument("Unsupported layout transition");
-
-		cmdBuf->pipelineBarrier(
-			vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTopOfPipe,
-			(vk::DependencyFlagBits)0,
-			nullptr, nullptr,
-			barrier);
-	}
-	cmdBuf->end();
-	m_Device.SubmitCommandBuffers(cmdBuf.get());
-}
+	const vk::Extent3D& extent = m_ImageCreateInfo.extent;
 
-void Texture::CopyBufferToImage(const vk::Buffer& src, const vk::Image& dst, const vk::Extent3D& extent) const
-{
-	vk::UniqueCommandBuffer cmdBuf = m_Device.AllocCommandBuffer();
-	cmdBuf->begin(VulkanHelpers::CBBI_ONE_TIME_SUBMIT);
-
-	vk::BufferImageCopy region;
+	std::vector<vk::BufferImageCopy> regions(levelOffsets.size());
+	for (uint32_t level = 0; level < regions.size(); level++)
+	{
+		vk::BufferImageCopy& region = regions[level];
 
-	region.imageSubresource.setAspectMask(vk::ImageAspectFlagBits::eColor);
-	region.imageSubresource.setLayerCount(1);
+		region.setBufferOffset(levelOffsets[level]);
 
-	//region.setImageOffset(vk::Offset3D(0, 0, 0));
-	region.setImageExtent(extent);
+		region.imageSubresource.setAspectMask(vk::ImageAspectFlagBits::eColor);
+		region.imageSubresource.setMipLevel(level);
+		region.imageSubresource.setLayerCount(1);
 
-	cmdBuf->copyBufferToImage(src, dst, vk::ImageLayout::eTransferDstOptimal, region);
+		//region.setImageOffset(vk::Offset3D(0, 0, 0));
+		region.setImageExtent(vk::Extent3D(
+			MipmapGenerator::GetLevelSize(extent.width, level),
+			MipmapGenerator::GetLevelSize(extent.height, level),
+			extent.depth));
+	}
 
-	cmdBuf->end();
-	m_Device.SubmitCommandBuffers(cmdBuf.get());
+	return regions;
 }
@@ -1,7 +1,12 @@
 #pragma once
+#include "UploadBatch.h"
+
 #include <filesystem>
+#include <memory>
 #include <optional>
+#include <vector>
 
+class Buffer;
 class LogicalDevice;
 struct TextureCreateInfo;
 
@@ -19,23 +24,27 @@ public:
 
 	const vk::ImageType GetImageType() const { return m_ImageCreateInfo.imageType; }
 
+	// The image is copied in by the device's UploadBatch. Anything drawing with
+	// it is submitted after that anyway, so this is only needed to know whether
+	// the device has actually got there yet.
+	const UploadToken& GetUploadToken() const { return m_UploadToken; }
+
 private:
-	struct SourceImage
-	{
-		std::shared_ptr<void> m_Image;
-		size_t GetImgDataSize() const { return m_Width * m_Height * 4; }
-		size_t GetImgDataStride() const { return m_Width * 4; }
-		int m_Width;
-		int m_Height;
-		int m_Channels;
-	};
-	std::vector<SourceImage> LoadSourceImages();
+	// Decodes every source on the thread pool, each one straight into its own
+	// slice of frames. Frames are padded or cropped to the size of the first.
+	void LoadSourceImages(uint8_t* frames, uint32_t width, uint32_t height) const;
+
+	bool CanUseCooked() const;
+
+	// Staging buffers with every level packed one after another, and where
+	// each level starts
+	std::unique_ptr<Buffer> LoadCooked(std::vector<vk::DeviceSize>& levelOffsets);
+	std::unique_ptr<Buffer> LoadSources(std::vector<vk::DeviceSize>& levelOffsets);
 
 	void CreateImageView();
 	void CreateSampler();
 
-	void TransitionImageLayout(const vk::Image& img, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout) const;
-	void CopyBufferToImage(const vk::Buffer& src, const vk::Image& dst, const vk::Extent3D& extent) const;
+	std::vector<vk::BufferImageCopy> GetCopyRegions(const std::vector<vk::DeviceSize>& levelOffsets) const;
 
 	LogicalDevice& m_Device;
 
@@ -44,6 +53,7 @@ private:
 	vk::UniqueImage m_Image;
 	vk::UniqueDeviceMemory m_DeviceMemory;
 	vk::UniqueImageView m_ImageView;
+	UploadToken m_UploadToken;
 
 	vk::SamplerCreateInfo m_SamplerCreateInfo;
 	vk::UniqueSampler m_Sampler;
@@ -0,0 +1,288 @@
+#include "stdafx.h"
+#include "TextureCooker.h"
+
+#include "BlockCompressor.h"
+#include "ContentPaths.h"
+#include "ImageDecoder.h"
+#include "MipmapGenerator.h"
+#include "TextureCreateInfo.h"
+
+#include <fstream>
+
+namespace
+{
+	// Only as much of the DDS format as we write: a single 2D image with a
+	// DX10 header, so the format is always a plain DXGI_FORMAT
+	constexpr uint32_t DDS_MAGIC = 0x20534444;			// "DDS "
+	constexpr uint32_t DDS_FOURCC_DX10 = 0x30315844;	// "DX10"
+
+	constexpr uint32_t DDSD_CAPS = 0x1;
+	constexpr uint32_t DDSD_HEIGHT = 0x2;
+	constexpr uint32_t DDSD_WIDTH = 0x4;
+	constexpr uint32_t DDSD_PIXELFORMAT = 0x1000;
+	constexpr uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+	constexpr uint32_t DDSD_LINEARSIZE = 0x80000;
+	constexpr uint32_t DDPF_FOURCC = 0x4;
+	constexpr uint32_t DDSCAPS_COMPLEX = 0x8;
+	constexpr uint32_t DDSCAPS_TEXTURE = 0x1000;
+	constexpr uint32_t DDSCAPS_MIPMAP = 0x400000;
+	constexpr uint32_t D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3;
+
+	// Goes in the header's reserved space. Bump the version whenever the
+	// cooker's output changes so old files get cooked again instead of loaded.
+	constexpr uint32_t COOKER_TAG = 0x43315456;			// "VT1C"
+	constexpr uint32_t COOKER_VERSION = 1;
+
+	struct DDSPixelFormat
+	{
+		uint32_t m_Size;
+		uint32_t m_Flags;
+		uint32_t m_FourCC;
+		uint32_t m_RGBBitCount;
+		uint32_t m_BitMasks[4];
+	};
+
+	struct DDSHeader
+	{
+		uint32_t m_Size;
+		uint32_t m_Flags;
+		uint32_t m_Height;
+		uint32_t m_Width;
+		uint32_t m_PitchOrLinearSize;
+		uint32_t m_Depth;
+		uint32_t m_MipMapCount;
+		uint32_t m_Reserved1[11];
+		DDSPixelFormat m_PixelFormat;
+		uint32_t m_Caps[4];
+		uint32_t m_Reserved2;
+	};
+	static_assert(sizeof(DDSHeader) == 124);
+
+	struct DDSHeaderDX10
+	{
+		uint32_t m_DXGIFormat;
+		uint32_t m_ResourceDimension;
+		uint32_t m_MiscFlag;
+		uint32_t m_ArraySize;
+		uint32_t m_MiscFlags2;
+	};
+	static_assert(sizeof(DDSHeaderDX10) == 20);
+
+	// DXGI_FORMAT values
+	constexpr std::pair<vk::Format, uint32_t> DXGI_FORMATS[] =
+	{
+		{ vk::Format::eR8G8B8A8Unorm, 28 },
+		{ vk::Format::eBc1RgbaUnormBlock, 71 },
+		{ vk::Format::eBc3UnormBlock, 77 },
+		{ vk::Format::eBc4UnormBlock, 80 },
+		{ vk::Format::eBc5UnormBlock, 83 },
+		{ vk::Format::eBc7UnormBlock, 98 },
+	};
+}
+
+size_t CookedTexture::GetLevelOffset(uint32_t level) const
+{
+	size_t retVal = 0;
+	for (uint32_t i = 0; i < level; i++)
+		retVal += BlockCompressor::GetImageSize(m_Format, MipmapGenerator::GetLevelSize(m_Width, i), MipmapGenerator::GetLevelSize(m_Height, i));
+
+	return retVal;
+}
+
+bool TextureCooker::CanCook(const TextureCreateInfo& createInfo)
+{
+	return createInfo.m_SourceFiles.size() == 1;
+}
+
+std::filesystem::path TextureCooker::GetCookedPath(const TextureCreateInfo& createInfo)
+{
+	std::filesystem::path relative = createInfo.m_DefinitionFile.lexically_relative(ContentPaths::Textures());
+	if (relative.empty() || *relative.begin() == "..")
+		relative = createInfo.m_DefinitionFile.filename();
+
+	return ContentPaths::CookedTextures() / relative.replace_extension(".dds");
+}
+
+bool TextureCooker::IsUpToDate(const TextureCreateInfo& createInfo)
+{
+	std::error_code error;
+	const auto cookedTime = std::filesystem::last_write_time(GetCookedPath(createInfo), error);
+	if (error)
+		return false;
+
+	// The definition says how to mipmap and compress, so it counts as a source too
+	if (std::filesystem::last_write_time(createInfo.m_DefinitionFile, error) > cookedTime || error)
+		return false;
+
+	for (const auto& source : createInfo.m_SourceFiles)
+	{
+		if (std::filesystem::last_write_time(source, error) > cookedTime || error)
+			return false;
+	}
+
+	return true;
+}
+
+CookedTexture TextureCooker::Cook(const TextureCreateInfo& createInfo)
+{
+	if (!CanCook(createInfo))
+	{
+		throw std::invalid_argument(StringTools::CSFormat("{0}: {1} has {2} source images, only textures with one can be cooked",
+			__FUNCTION__, createInfo.m_DefinitionFile.string(), createInfo.m_SourceFiles.size()));
+	}
+
+	const auto& sourcePath = createInfo.m_SourceFiles.front();
+	const MipmapGenerator::Settings mipmapSettings = createInfo.GetMipmapSettings();
+
+	CookedTexture retVal;
+	ImageDecoder::ReadSize(sourcePath, retVal.m_Width, retVal.m_Height);
+	retVal.m_LevelCount = (mipmapSettings.m_Filter == MipmapFilter::None) ? 1 : MipmapGenerator::GetLevelCount(retVal.m_Width, retVal.m_Height);
+
+	std::vector<uint8_t> chain(MipmapGenerator::GetChainSize(retVal.m_Width, retVal.m_Height, retVal.m_LevelCount));
+	ImageDecoder::Decode(sourcePath, chain.data(), retVal.m_Width, retVal.m_Height);
+
+	MipmapGenerator::Generate(chain.data(), retVal.m_Width, retVal.m_Height, retVal.m_LevelCount, mipmapSettings);
+
+	retVal.m_Format = BlockCompressor::ChooseFormat(createInfo.m_Compression, chain.data(), retVal.m_Width, retVal.m_Height);
+	if (retVal.m_Format == vk::Format::eR8G8B8A8Unorm)
+	{
+		retVal.m_Data = std::move(chain);
+		return retVal;
+	}
+
+	retVal.m_Data.resize(retVal.GetLevelOffset(retVal.m_LevelCount));
+	for (uint32_t level = 0; level < retVal.m_LevelCount; level++)
+	{
+		BlockCompressor::Compress(retVal.m_Format,
+			chain.data() + MipmapGenerator::GetLevelOffset(retVal.m_Width, retVal.m_Height, level),
+			MipmapGenerator::GetLevelSize(retVal.m_Width, level), MipmapGenerator::GetLevelSize(retVal.m_Height, level),
+			retVal.m_Data.data() + retVal.GetLevelOffset(level));
+	}
+
+	return retVal;
+}
+
+CookedTexture TextureCooker::LoadOrCook(const TextureCreateInfo& createInfo)
+{
+	const auto cookedPath = GetCookedPath(createInfo);
+
+	if (IsUpToDate(createInfo))
+	{
+		try
+		{
+			return Read(cookedPath);
+		}
+		catch (const std::exception& e)
+		{
+			Log::TagMsg(TAG, "Cooking {0} again: {1}", cookedPath.string(), e.what());
+		}
+	}
+
+	CookedTexture retVal = Cook(createInfo);
+
+	try
+	{
+		Write(retVal, cookedPath);
+	}
+	catch (const std::exception& e)
+	{
+		// Still usable, it'll just be cooked again next time
+		Log::TagMsg(TAG, "Warning: Failed to write {0}: {1}", cookedPath.string(), e.what());
+	}
+
+	return retVal;
+}
+
+CookedTexture TextureCooker::Read(const std::filesystem::path& path)
+{
+	std::ifstream file(path, std::ios::binary);
+
+	uint32_t magic = 0;
+	DDSHeader header{};
+	DDSHeaderDX10 dx10{};
+	file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	file.read(reinterpret_cast<char*>(&dx10), sizeof(dx10));
+
+	if (!file || magic != DDS_MAGIC || header.m_Size != sizeof(header) || header.m_PixelFormat.m_FourCC != DDS_FOURCC_DX10)
+		throw std::runtime_error(StringTools::CSFormat("{0}: {1} isn't a DDS file with a DX10 header", __FUNCTION__, path.string()));
+
+	if (header.m_Reserved1[9] != COOKER_TAG || header.m_Reserved1[10] != COOKER_VERSION)
+		throw std::runtime_error(StringTools::CSFormat("{0}: {1} was written by a different version of the cooker", __FUNCTION__, path.string()));
+
+	if (dx10.m_ResourceDimension != D3D10_RESOURCE_DIMENSION_TEXTURE2D || dx10.m_ArraySize != 1 || !header.m_Width || !header.m_Height)
+		throw std::runtime_error(StringTools::CSFormat("{0}: {1} isn't a single 2D image", __FUNCTION__, path.string()));
+
+	CookedTexture retVal;
+	for (const auto& format : DXGI_FORMATS)
+	{
+		if (format.second == dx10.m_DXGIFormat)
+			retVal.m_Format = format.first;
+	}
+
+	if (retVal.m_Format == vk::Format::eUndefined)
+		throw std::runtime_error(StringTools::CSFormat("{0}: {1} has unsupported DXGI_FORMAT {2}", __FUNCTION__, path.string(), dx10.m_DXGIFormat));
+
+	retVal.m_Width = header.m_Width;
+	retVal.m_Height = header.m_Height;
+	retVal.m_LevelCount = std::clamp<uint32_t>(header.m_MipMapCount, 1, MipmapGenerator::GetLevelCount(header.m_Width, header.m_Height));
+
+	retVal.m_Data.resize(retVal.GetLevelOffset(retVal.m_LevelCount));
+	file.read(reinterpret_cast<char*>(retVal.m_Data.data()), retVal.m_Data.size());
+	if (size_t(file.gcount()) != retVal.m_Data.size())
+	{
+		throw std::runtime_error(StringTools::CSFormat("{0}: {1} is truncated, expected {2} bytes of image data but found {3}",
+			__FUNCTION__, path.string(), retVal.m_Data.size(), file.gcount()));
+	}
+
+	return retVal;
+}
+
+void TextureCooker::Write(const CookedTexture& texture, const std::filesystem::path& path)
+{
+	DDSHeader header{};
+	header.m_Size = sizeof(header);
+	header.m_Flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+	header.m_Height = texture.m_Height;
+	header.m_Width = texture.m_Width;
+	header.m_PitchOrLinearSize = uint32_t(texture.GetLevelOffset(1));
+	header.m_MipMapCount = texture.m_LevelCount;
+	header.m_Reserved1[9] = COOKER_TAG;
+	header.m_Reserved1[10] = COOKER_VERSION;
+	header.m_PixelFormat.m_Size = sizeof(header.m_PixelFormat);
+	header.m_PixelFormat.m_Flags = DDPF_FOURCC;
+	header.m_PixelFormat.m_FourCC = DDS_FOURCC_DX10;
+	header.m_Caps[0] = DDSCAPS_TEXTURE | ((texture.m_LevelCount > 1) ? (DDSCAPS_COMPLEX | DDSCAPS_MIPMAP) : 0);
+
+	DDSHeaderDX10 dx10{};
+	for (const auto& format : DXGI_FORMATS)
+	{
+		if (format.first == texture.m_Format)
+			dx10.m_DXGIFormat = format.second;
+	}
+
+	if (!dx10.m_DXGIFormat)
+		throw std::invalid_argument(StringTools::CSFormat("{0}: Unsupported format {1}", __FUNCTION__, vk::to_string(texture.m_Format)));
+
+	dx10.m_ResourceDimension = D3D10_RESOURCE_DIMENSION_TEXTURE2D;
+	dx10.m_ArraySize = 1;
+
+	std::filesystem::create_directories(path.parent_path());
+
+	// Written to the side first, so a crash part way through can't leave a
+	// truncated file that looks newer than its sources
+	std::filesystem::path tempPath = path;
+	tempPath += ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&DDS_MAGIC), sizeof(DDS_MAGIC));
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(&dx10), sizeof(dx10));
+		file.write(reinterpret_cast<const char*>(texture.m_Data.data()), texture.m_Data.size());
+
+		if (!file)
+			throw std::runtime_error(StringTools::CSFormat("{0}: Failed to write {1}", __FUNCTION__, tempPath.string()));
+	}
+
+	std::filesystem::rename(tempPath, path);
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+struct TextureCreateInfo;
+
+// Every mip level already built and compressed, ready to be copied straight
+// into an image.
+struct CookedTexture
+{
+	vk::Format m_Format = vk::Format::eUndefined;
+	uint32_t m_Width = 0;
+	uint32_t m_Height = 0;
+	uint32_t m_LevelCount = 0;
+
+	// Every level one after another, without padding
+	std::vector<uint8_t> m_Data;
+
+	size_t GetLevelOffset(uint32_t level) const;
+};
+
+// Turns a texture definition's source image into a CookedTexture, and keeps
+// them as .dds files under ContentPaths::CookedTextures(). Only textures with
+// a single source image can be cooked, animated ones are left as they are.
+class TextureCooker final
+{
+public:
+	TextureCooker() = delete;
+	TextureCooker(const TextureCooker& other) = delete;
+	TextureCooker(TextureCooker&& other) = delete;
+	~TextureCooker() = delete;
+
+	static bool CanCook(const TextureCreateInfo& createInfo);
+	static std::filesystem::path GetCookedPath(const TextureCreateInfo& createInfo);
+
+	// The cooked file exists and is newer than the definition and its source
+	// image, so neither has changed since it was cooked.
+	static bool IsUpToDate(const TextureCreateInfo& createInfo);
+
+	static CookedTexture Cook(const TextureCreateInfo& createInfo);
+
+	// Reads the cooked file if it's up to date, otherwise cooks it again and
+	// writes it back out for next time.
+	static CookedTexture LoadOrCook(const TextureCreateInfo& createInfo);
+
+	static CookedTexture Read(const std::filesystem::path& path);
+	static void Write(const CookedTexture& texture, const std::filesystem::path& path);
+
+private:
+	static constexpr char TAG[] = "[TextureCooker] ";
+};
@@ -6,6 +6,21 @@ TextureCreateInfo::TextureCreateInfo() :
 	m_Animated(0),
 	m_AddressModeU(vk::SamplerAddressMode(0)),
 	m_AddressModeV(vk::SamplerAddressMode(0)),
-	m_AddressModeW(vk::SamplerAddressMode(0))
+	m_AddressModeW(vk::SamplerAddressMode(0)),
+	m_MipmapFilter(MipmapFilter(0)),
+	m_MipmapAlphaReference(0),
+	m_Compression(TextureCompression(0))
 {
 }
+
+MipmapGenerator::Settings TextureCreateInfo::GetMipmapSettings() const
+{
+	// Mirrored modes reflect back onto the edge texels, which clamping is
+	// close enough to for a filter a few texels wide
+	MipmapGenerator::Settings retVal;
+	retVal.m_Filter = m_MipmapFilter;
+	retVal.m_AlphaReference = m_MipmapAlphaReference;
+	retVal.m_WrapU = (m_AddressModeU == vk::SamplerAddressMode::eRepeat);
+	retVal.m_WrapV = (m_AddressModeV == vk::SamplerAddressMode::eRepeat);
+	return retVal;
+}
@@ -1,4 +1,6 @@
 #pragma once
+#include "BlockCompressor.h"
+#include "MipmapGenerator.h"
 #include "Util.h"
 
 #include <filesystem>
@@ -20,4 +22,12 @@ struct TextureCreateInfo
 	vk::SamplerAddressMode m_AddressModeU;
 	vk::SamplerAddressMode m_AddressModeV;
 	vk::SamplerAddressMode m_AddressModeW;
+
+	MipmapFilter m_MipmapFilter;
+	float m_MipmapAlphaReference;
+
+	TextureCompression m_Compression;
+
+	// Edges wrap for filtering if the sampler repeats
+	MipmapGenerator::Settings GetMipmapSettings() const;
 };
\ No newline at end of file
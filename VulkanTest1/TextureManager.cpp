@@ -2,8 +2,9 @@
 #include "TextureManager.h"
 
 #include "ContentPaths.h"
-#include "JSON.h"
+#include "JSONSchema.h"
 #include "Texture.h"
+#include "TextureCooker.h"
 #include "TextureCreateInfo.h"
 
 #include <filesystem>
@@ -11,31 +12,33 @@
 TextureManager::TextureManager(LogicalDevice& device) :
 	DataStoreType(device)
 {
+	EnableAsyncLoading("fallback");
 }
 
 void TextureManager::Reload()
 {
 	ClearData();
 
-	for (auto& item : std::filesystem::recursive_directory_iterator(ContentPaths::Textures()))
+	AddFiles(FindFiles(ContentPaths::Textures(), ".json"), [](const std::filesystem::path& path)
 	{
-		const auto& type = item.status().type();
-		if (type != std::filesystem::file_type::regular)
-			continue;
+		const auto name = name_from_path(ContentPaths::Textures(), path);
 
-		const auto& path = item.path();
-		if (!path.has_extension())
-			continue;
+		Log::TagMsg(TAG, CSFMT("Loading texture {0}"), name);
 
-		const auto& extension = path.extension();
-		if (extension != ".json")
-			continue;
-
-		const auto name = name_from_path(ContentPaths::Textures(), item);
+		return std::make_pair(name, LoadCreateInfo(path));
+	});
+}
 
-		Log::TagMsg(TAG, "Loading texture {0}", name);
+void TextureManager::CookAll()
+{
+	for (const auto& path : FindFiles(ContentPaths::Textures(), ".json"))
+	{
+		const auto createInfo = LoadCreateInfo(path);
+		if (!TextureCooker::CanCook(*createInfo) || TextureCooker::IsUpToDate(*createInfo))
+			continue;
 
-		AddPair(name, LoadCreateInfo(path));
+		Log::TagMsg(TAG, CSFMT("Cooking texture {0}"), name_from_path(ContentPaths::Textures(), path));
+		TextureCooker::Write(TextureCooker::Cook(*createInfo), TextureCooker::GetCookedPath(*createInfo));
 	}
 }
 
@@ -46,58 +49,149 @@ std::shared_ptr<Texture> TextureManager::Transform(const std::shared_ptr<Texture
 
 std::shared_ptr<TextureCreateInfo> TextureManager::LoadCreateInfo(const std::filesystem::path& path)
 {
+	static const auto s_Schema = MakeJSONSchema<TextureCreateInfo>(
+		JSONBind<TextureCreateInfo>("sourceFiles", &LoadSourceFiles, JSONPresence::Required),
+		JSONBind<&TextureCreateInfo::m_Animated>("animated"),
+		JSONBind<TextureCreateInfo>("filter", [](JSONReader& reader, TextureCreateInfo& createInfo) { createInfo.m_Filter = ToFilter(reader.ReadString()); }),
+		JSONBind<TextureCreateInfo>("addressMode", &LoadAddressMode),
+		JSONBind<TextureCreateInfo>("mipmaps", &LoadMipmaps),
+		JSONBind<TextureCreateInfo>("compression", [](JSONReader& reader, TextureCreateInfo& createInfo) { createInfo.m_Compression = ToCompression(reader.ReadString()); }));
+
 	std::shared_ptr<TextureCreateInfo> retVal = std::make_shared<TextureCreateInfo>();
 	retVal->m_DefinitionFile = path;
+	retVal->m_Filter = vk::Filter::eLinear;
+	retVal->m_MipmapFilter = MipmapFilter::Box;
+	retVal->m_MipmapAlphaReference = 0.5f;
+	retVal->m_Compression = TextureCompression::Auto;
 
-	const JSONObject root = JSONSerializer::FromFile(path).GetObject();
-
-	for (const auto& sourceFile : root.GetArray("sourceFiles"))
-		retVal->m_SourceFiles.push_back(ContentPaths::Textures() / sourceFile.GetString());
+	std::vector<std::string> unknownFields;
+	JSONReader reader(path);
+	s_Schema.Read(reader, *retVal, &unknownFields);
 
-	retVal->m_Animated = root.TryGetBool("animated", false);
-
-	retVal->m_Filter = ToFilter(root.TryGetString("filter", "linear"));
-
-	LoadAddressMode(*retVal, root);
+	for (const auto& field : unknownFields)
+		Log::TagMsg(TAG, "Warning: Unknown field \"{0}\" in texture definition {1}", field, path.string());
 
 	return retVal;
 }
 
-void TextureManager::LoadAddressMode(TextureCreateInfo& createInfo, const JSONObject& root)
+void TextureManager::LoadSourceFiles(JSONReader& reader, TextureCreateInfo& createInfo)
 {
-	const JSONValue* addressMode = root.TryGetValue("addressMode");
-	if (!addressMode)
-		return;
-
-	static const std::map<std::string, vk::SamplerAddressMode> s_AddressModeLookup =
+	reader.Expect(JSONEvent::StartArray);
+	while (reader.Next() != JSONEvent::EndArray)
 	{
-		{ "repeat", vk::SamplerAddressMode::eRepeat },
-		{ "repeatMirror", vk::SamplerAddressMode::eMirroredRepeat },
-		{ "clampEdge", vk::SamplerAddressMode::eClampToEdge },
-		{ "clampEdgeMirror", vk::SamplerAddressMode::eMirrorClampToEdge },
-		{ "clampBorder", vk::SamplerAddressMode::eClampToBorder },
-	};
-
-	if (addressMode->GetType() == JSONDataType::Object)
+		reader.Unread();
+		createInfo.m_SourceFiles.push_back(ContentPaths::Textures() / reader.ReadString());
+	}
+}
+
+void TextureManager::LoadAddressMode(JSONReader& reader, TextureCreateInfo& createInfo, std::vector<std::string>* unknownFields)
+{
+	static const auto s_Schema = MakeJSONSchema<TextureCreateInfo>(
+		JSONBind<TextureCreateInfo>("u", [](JSONReader& reader, TextureCreateInfo& createInfo) { createInfo.m_AddressModeU = ToAddressMode(reader.ReadString()); }),
+		JSONBind<TextureCreateInfo>("v", [](JSONReader& reader, TextureCreateInfo& createInfo) { createInfo.m_AddressModeV = ToAddressMode(reader.ReadString()); }),
+		JSONBind<TextureCreateInfo>("w", [](JSONReader& reader, TextureCreateInfo& createInfo) { createInfo.m_AddressModeW = ToAddressMode(reader.ReadString()); }));
+
+	switch (reader.Next())
 	{
-		const JSONObject& addressModeObj = addressMode->GetObject();
-		createInfo.m_AddressModeU = vk::SamplerAddressMode(s_AddressModeLookup.at(addressModeObj.TryGetString("u", s_AddressModeLookup.begin()->first)));
-		createInfo.m_AddressModeV = vk::SamplerAddressMode(s_AddressModeLookup.at(addressModeObj.TryGetString("v", s_AddressModeLookup.begin()->first)));
-		createInfo.m_AddressModeW = vk::SamplerAddressMode(s_AddressModeLookup.at(addressModeObj.TryGetString("w", s_AddressModeLookup.begin()->first)));
+	case JSONEvent::StartObject:
+		createInfo.m_AddressModeU = createInfo.m_AddressModeV = createInfo.m_AddressModeW = vk::SamplerAddressMode::eClampToBorder;
+		s_Schema.ReadMembers(reader, createInfo, unknownFields);
+		break;
+
+	case JSONEvent::String:
+		createInfo.m_AddressModeU = createInfo.m_AddressModeV = createInfo.m_AddressModeW = ToAddressMode(reader.GetString());
+		break;
+
+	default:
+		throw json_value_type_error(StringTools::CSFormat("addressMode must be a string or an object, but found {0}", reader.GetEvent()));
 	}
-	else if (addressMode->GetType() == JSONDataType::String)
+}
+
+void TextureManager::LoadMipmaps(JSONReader& reader, TextureCreateInfo& createInfo, std::vector<std::string>* unknownFields)
+{
+	static const auto s_Schema = MakeJSONSchema<TextureCreateInfo>(
+		JSONBind<TextureCreateInfo>("filter", [](JSONReader& reader, TextureCreateInfo& createInfo) { createInfo.m_MipmapFilter = ToMipmapFilter(reader.ReadString()); }),
+		JSONBind<TextureCreateInfo>("alphaReference", [](JSONReader& reader, TextureCreateInfo& createInfo) { createInfo.m_MipmapAlphaReference = float(reader.ReadNumber()); }));
+
+	switch (reader.Next())
 	{
-		createInfo.m_AddressModeU = createInfo.m_AddressModeV = createInfo.m_AddressModeW =
-			vk::SamplerAddressMode(s_AddressModeLookup.at(addressMode->GetString()));
+	case JSONEvent::StartObject:
+		s_Schema.ReadMembers(reader, createInfo, unknownFields);
+		break;
+
+	case JSONEvent::String:
+		createInfo.m_MipmapFilter = ToMipmapFilter(reader.GetString());
+		break;
+
+	case JSONEvent::Bool:
+		createInfo.m_MipmapFilter = reader.GetBool() ? MipmapFilter::Box : MipmapFilter::None;
+		break;
+
+	default:
+		throw json_value_type_error(StringTools::CSFormat("mipmaps must be a string, a bool, or an object, but found {0}", reader.GetEvent()));
 	}
+
+	if (createInfo.m_MipmapAlphaReference <= 0 || createInfo.m_MipmapAlphaReference >= 1)
+		throw json_parsing_error(StringTools::CSFormat("mipmaps alphaReference must be between 0 and 1, but found {0}", createInfo.m_MipmapAlphaReference));
 }
 
-vk::Filter TextureManager::ToFilter(const std::string& filterText)
+vk::Filter TextureManager::ToFilter(const std::string_view& filterText)
 {
-	if (filterText == "linear")
+	if (filterText == "linear"sv)
 		return vk::Filter::eLinear;
-	else if (filterText == "nearest")
+	else if (filterText == "nearest"sv)
 		return vk::Filter::eNearest;
 	else
 		throw json_parsing_error(StringTools::CSFormat("Failed to convert \"{0}\" to a vk::Filter value", filterText));
 }
+
+vk::SamplerAddressMode TextureManager::ToAddressMode(const std::string_view& addressModeText)
+{
+	if (addressModeText == "repeat"sv)
+		return vk::SamplerAddressMode::eRepeat;
+	else if (addressModeText == "repeatMirror"sv)
+		return vk::SamplerAddressMode::eMirroredRepeat;
+	else if (addressModeText == "clampEdge"sv)
+		return vk::SamplerAddressMode::eClampToEdge;
+	else if (addressModeText == "clampEdgeMirror"sv)
+		return vk::SamplerAddressMode::eMirrorClampToEdge;
+	else if (addressModeText == "clampBorder"sv)
+		return vk::SamplerAddressMode::eClampToBorder;
+	else
+		throw json_parsing_error(StringTools::CSFormat("Failed to convert \"{0}\" to a vk::SamplerAddressMode value", addressModeText));
+}
+
+
+MipmapFilter TextureManager::ToMipmapFilter(const std::string_view& mipmapFilterText)
+{
+	if (mipmapFilterText == "none"sv)
+		return MipmapFilter::None;
+	else if (mipmapFilterText == "box"sv)
+		return MipmapFilter::Box;
+	else if (mipmapFilterText == "kaiser"sv)
+		return MipmapFilter::Kaiser;
+	else if (mipmapFilterText == "alphaCoverage"sv)
+		return MipmapFilter::AlphaCoverage;
+	else
+		throw json_parsing_error(StringTools::CSFormat("Failed to convert \"{0}\" to a MipmapFilter value", mipmapFilterText));
+}
+
+TextureCompression TextureManager::ToCompression(const std::string_view& compressionText)
+{
+	if (compressionText == "none"sv)
+		return TextureCompression::None;
+	else if (compressionText == "auto"sv)
+		return TextureCompression::Auto;
+	else if (compressionText == "bc1"sv)
+		return TextureCompression::BC1;
+	else if (compressionText == "bc3"sv)
+		return TextureCompression::BC3;
+	else if (compressionText == "bc4"sv)
+		return TextureCompression::BC4;
+	else if (compressionText == "bc5"sv)
+		return TextureCompression::BC5;
+	else if (compressionText == "bc7"sv)
+		return TextureCompression::BC7;
+	else
+		throw json_parsing_error(StringTools::CSFormat("Failed to convert \"{0}\" to a TextureCompression value", compressionText));
+}
\ No newline at end of file
@@ -2,10 +2,12 @@
 #include "DataStore.h"
 #include <filesystem>
 
-class JSONObject;
+class JSONReader;
 class LogicalDevice;
 class Texture;
 struct TextureCreateInfo;
+enum class MipmapFilter;
+enum class TextureCompression;
 
 class TextureManager : public DataStore<TextureManager, Texture, TextureCreateInfo>
 {
@@ -14,13 +16,22 @@ public:
 
 	void Reload() override;
 
+	// Cooks every texture whose cooked file is missing or out of date. Needs
+	// no device, so build machines can run it ahead of time.
+	static void CookAll();
+
 private:
 	static constexpr char TAG[] = "[TextureManager] ";
 
 	std::shared_ptr<Texture> Transform(const std::shared_ptr<TextureCreateInfo>& createInfo) const override;
 
 	static std::shared_ptr<TextureCreateInfo> LoadCreateInfo(const std::filesystem::path& path);
-	static void LoadAddressMode(TextureCreateInfo& createInfo, const JSONObject& root);
+	static void LoadSourceFiles(JSONReader& reader, TextureCreateInfo& createInfo);
+	static void LoadAddressMode(JSONReader& reader, TextureCreateInfo& createInfo, std::vector<std::string>* unknownFields);
+	static void LoadMipmaps(JSONReader& reader, TextureCreateInfo& createInfo, std::vector<std::string>* unknownFields);
 
-	static vk::Filter ToFilter(const std::string& filterText);
+	static vk::Filter ToFilter(const std::string_view& filterText);
+	static vk::SamplerAddressMode ToAddressMode(const std::string_view& addressModeText);
+	static MipmapFilter ToMipmapFilter(const std::string_view& mipmapFilterText);
+	static TextureCompression ToCompression(const std::string_view& compressionText);
 };
\ No newline at end of file
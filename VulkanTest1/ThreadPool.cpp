@@ -0,0 +1,68 @@
+#include "stdafx.h"
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t threadCount)
+{
+	m_Threads.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; i++)
+		m_Threads.emplace_back(&ThreadPool::WorkerMain, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Exiting = true;
+	}
+
+	m_TaskAvailable.notify_all();
+
+	for (auto& thread : m_Threads)
+		thread.join();
+}
+
+ThreadPool& ThreadPool::Default()
+{
+	static ThreadPool s_Default;
+	return s_Default;
+}
+
+size_t ThreadPool::DefaultThreadCount()
+{
+	// hardware_concurrency() is allowed to return 0 if it doesn't know
+	const size_t hardwareThreads = std::thread::hardware_concurrency();
+	return std::max<size_t>(hardwareThreads, 2) - 1;
+}
+
+void ThreadPool::Enqueue(std::function<void()>&& task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		assert(!m_Exiting);
+		m_Tasks.push_back(std::move(task));
+	}
+
+	m_TaskAvailable.notify_one();
+}
+
+void ThreadPool::WorkerMain()
+{
+	while (true)
+	{
+		std::function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_TaskAvailable.wait(lock, [this]() { return m_Exiting || !m_Tasks.empty(); });
+
+			// Finish whatever's left before exiting, someone may be waiting on it
+			if (m_Tasks.empty())
+				return;
+
+			task = std::move(m_Tasks.front());
+			m_Tasks.pop_front();
+		}
+
+		task();
+	}
+}
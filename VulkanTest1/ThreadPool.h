@@ -0,0 +1,127 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads pulling from a single FIFO queue.
+class ThreadPool
+{
+public:
+	ThreadPool(size_t threadCount = DefaultThreadCount());
+	ThreadPool(const ThreadPool& other) = delete;
+	~ThreadPool();
+
+	ThreadPool& operator=(const ThreadPool& other) = delete;
+
+	// Shared pool for engine-wide background work, created on first use.
+	static ThreadPool& Default();
+
+	// One worker per hardware thread, leaving one for the thread that's waiting on them.
+	static size_t DefaultThreadCount();
+
+	size_t GetThreadCount() const { return m_Threads.size(); }
+
+	template<class Fn> auto Submit(Fn&& fn) -> std::future<std::invoke_result_t<Fn>>;
+
+	// Calls fn(i) for every i in [0, count), spread across the workers and the
+	// calling thread, and returns once all of them have finished. If any calls
+	// throw, the exception from the lowest i is rethrown here.
+	//
+	// Safe to call from a worker: the caller keeps taking indices itself, so it
+	// never waits on work that's stuck behind it in the queue.
+	template<class Fn> void ParallelFor(size_t count, const Fn& fn);
+
+private:
+	void Enqueue(std::function<void()>&& task);
+	void WorkerMain();
+
+	std::vector<std::thread> m_Threads;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_TaskAvailable;
+	std::deque<std::function<void()>> m_Tasks;
+	bool m_Exiting = false;
+};
+
+template<class Fn> inline auto ThreadPool::Submit(Fn&& fn) -> std::future<std::invoke_result_t<Fn>>
+{
+	// std::function needs something copyable
+	auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Fn>()>>(std::forward<Fn>(fn));
+	auto retVal = task->get_future();
+
+	Enqueue([task]() { (*task)(); });
+	return retVal;
+}
+
+template<class Fn> inline void ThreadPool::ParallelFor(size_t count, const Fn& fn)
+{
+	if (!count)
+		return;
+
+	// Helpers may not get to run until after we've returned, so everything they
+	// touch has to be kept alive by them.
+	struct State
+	{
+		State(size_t count, const Fn& fn) : m_Count(count), m_Fn(fn), m_Exceptions(count) { }
+
+		void Run()
+		{
+			size_t index;
+			while ((index = m_NextIndex++) < m_Count)
+			{
+				try
+				{
+					m_Fn(index);
+				}
+				catch (...)
+				{
+					m_Exceptions[index] = std::current_exception();
+				}
+
+				if (++m_Finished == m_Count)
+				{
+					std::lock_guard<std::mutex> lock(m_Mutex);
+					m_AllFinished.notify_all();
+				}
+			}
+		}
+
+		const size_t m_Count;
+		const Fn& m_Fn;
+		std::vector<std::exception_ptr> m_Exceptions;
+
+		std::atomic<size_t> m_NextIndex = 0;
+		std::atomic<size_t> m_Finished = 0;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_AllFinished;
+	};
+
+	const auto state = std::make_shared<State>(count, fn);
+
+	const size_t helperCount = std::min(count - 1, GetThreadCount());
+	for (size_t i = 0; i < helperCount; i++)
+		Enqueue([state]() { state->Run(); });
+
+	state->Run();
+
+	{
+		std::unique_lock<std::mutex> lock(state->m_Mutex);
+		state->m_AllFinished.wait(lock, [&state]() { return state->m_Finished == state->m_Count; });
+	}
+
+	for (const auto& exception : state->m_Exceptions)
+	{
+		if (exception)
+			std::rethrow_exception(exception);
+	}
+}
@@ -0,0 +1,211 @@
+#include "stdafx.h"
+#include "UploadBatch.h"
+
+#include "Buffer.h"
+#include "LogicalDevice.h"
+#include "VulkanHelpers.h"
+
+#include <atomic>
+
+struct UploadBatch::Submission
+{
+	Submission(UploadBatch& batch) : m_Batch(batch), m_Device(batch.m_Device.Get()) { }
+
+	UploadBatch& m_Batch;
+	vk::Device m_Device;
+
+	// m_Fence is set before this is, and never changes afterwards
+	std::atomic<bool> m_Submitted = false;
+	vk::UniqueFence m_Fence;
+
+	// Released by UploadBatch::Retire() once the fence has been signaled. The
+	// fence itself goes with the last reference, which is usually the batch's.
+	vk::UniqueCommandBuffer m_CommandBuffer;
+	std::vector<std::unique_ptr<Buffer>> m_StagingBuffers;
+};
+
+UploadBatch::UploadBatch(LogicalDevice& device) :
+	m_Device(device)
+{
+	m_Pending = std::make_shared<Submission>(*this);
+}
+
+UploadBatch::~UploadBatch()
+{
+	Submit();
+
+	// Every submission and its fence goes with this, so tokens that outlive us
+	// never touch the device again
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	Retire(true);
+}
+
+UploadToken UploadBatch::UploadImage(std::unique_ptr<Buffer>&& staging, vk::Image image, const vk::ImageSubresourceRange& range,
+	std::vector<vk::BufferImageCopy>&& regions)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	ImageUpload& upload = m_ImageUploads.emplace_back();
+	upload.m_Staging = staging->Get();
+	upload.m_Image = image;
+	upload.m_Range = range;
+	upload.m_Regions = std::move(regions);
+
+	m_Pending->m_StagingBuffers.push_back(std::move(staging));
+	return UploadToken(m_Pending);
+}
+
+UploadToken UploadBatch::CopyBuffer(std::unique_ptr<Buffer>&& staging, const Buffer& dst)
+{
+	assert(staging->GetSize() <= dst.GetSize());
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	BufferCopy& copy = m_BufferCopies.emplace_back();
+	copy.m_Staging = staging->Get();
+	copy.m_Dst = dst.Get();
+	copy.m_Region = vk::BufferCopy(0, 0, staging->GetSize());
+
+	m_Pending->m_StagingBuffers.push_back(std::move(staging));
+	return UploadToken(m_Pending);
+}
+
+UploadToken UploadBatch::Submit()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	Retire(false);
+
+	if (m_ImageUploads.empty() && m_BufferCopies.empty())
+		return UploadToken();
+
+	const std::shared_ptr<Submission> submission = std::move(m_Pending);
+	m_Pending = std::make_shared<Submission>(*this);
+
+	{
+		const auto poolLock = m_Device.LockCommandPool();
+		submission->m_CommandBuffer = m_Device.AllocCommandBuffer();
+
+		Record(submission->m_CommandBuffer.get());
+		submission->m_Fence = m_Device.SubmitCommandBuffersAsync({ submission->m_CommandBuffer.get() });
+	}
+
+	m_ImageUploads.clear();
+	m_BufferCopies.clear();
+
+	submission->m_Submitted.store(true, std::memory_order_release);
+	m_InFlight.push_back(submission);
+
+	return UploadToken(submission);
+}
+
+void UploadBatch::Record(const vk::CommandBuffer& cmdBuf) const
+{
+	cmdBuf.begin(VulkanHelpers::CBBI_ONE_TIME_SUBMIT);
+
+	// Every image goes to eTransferDstOptimal in one barrier, then everything
+	// is copied, then one more barrier makes it all visible to shaders and
+	// vertex input. Whatever was in the images before is thrown away.
+	std::vector<vk::ImageMemoryBarrier> imageBarriers(m_ImageUploads.size());
+	for (size_t i = 0; i < m_ImageUploads.size(); i++)
+	{
+		vk::ImageMemoryBarrier& barrier = imageBarriers[i];
+		barrier.setOldLayout(vk::ImageLayout::eUndefined);
+		barrier.setNewLayout(vk::ImageLayout::eTransferDstOptimal);
+		barrier.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+		barrier.setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+		barrier.setImage(m_ImageUploads[i].m_Image);
+		barrier.setSubresourceRange(m_ImageUploads[i].m_Range);
+		barrier.setDstAccessMask(vk::AccessFlagBits::eTransferWrite);
+	}
+
+	if (!imageBarriers.empty())
+	{
+		cmdBuf.pipelineBarrier(
+			vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
+			vk::DependencyFlags(),
+			nullptr, nullptr,
+			imageBarriers);
+	}
+
+	for (const ImageUpload& upload : m_ImageUploads)
+		cmdBuf.copyBufferToImage(upload.m_Staging, upload.m_Image, vk::ImageLayout::eTransferDstOptimal, upload.m_Regions);
+
+	for (const BufferCopy& copy : m_BufferCopies)
+		cmdBuf.copyBuffer(copy.m_Staging, copy.m_Dst, copy.m_Region);
+
+	for (vk::ImageMemoryBarrier& barrier : imageBarriers)
+	{
+		barrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
+		barrier.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+		barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+		barrier.setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+	}
+
+	// Buffers don't change layout, so one global barrier covers all of them.
+	// With no buffer copies it has nothing to do and costs nothing.
+	vk::MemoryBarrier bufferBarrier;
+	bufferBarrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+	bufferBarrier.setDstAccessMask(vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead |
+		vk::AccessFlagBits::eUniformRead | vk::AccessFlagBits::eShaderRead);
+
+	cmdBuf.pipelineBarrier(
+		vk::PipelineStageFlagBits::eTransfer,
+		vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader,
+		vk::DependencyFlags(),
+		bufferBarrier,
+		nullptr,
+		imageBarriers);
+
+	cmdBuf.end();
+}
+
+void UploadBatch::Retire(bool wait)
+{
+	for (auto it = m_InFlight.begin(); it != m_InFlight.end(); )
+	{
+		Submission& submission = **it;
+
+		if (wait)
+			m_Device->waitForFences(submission.m_Fence.get(), true, UINT64_MAX);
+		else if (m_Device->getFenceStatus(submission.m_Fence.get()) != vk::Result::eSuccess)
+		{
+			++it;
+			continue;
+		}
+
+		{
+			const auto poolLock = m_Device.LockCommandPool();
+			submission.m_CommandBuffer.reset();
+		}
+		submission.m_StagingBuffers.clear();
+
+		it = m_InFlight.erase(it);
+	}
+}
+
+bool UploadToken::IsComplete() const
+{
+	const auto submission = m_Submission.lock();
+	if (!submission)
+		return true;
+
+	if (!submission->m_Submitted.load(std::memory_order_acquire))
+		return false;
+
+	return submission->m_Device.getFenceStatus(submission->m_Fence.get()) == vk::Result::eSuccess;
+}
+
+void UploadToken::Wait() const
+{
+	const auto submission = m_Submission.lock();
+	if (!submission)
+		return;
+
+	// Still there, so the batch is too
+	if (!submission->m_Submitted.load(std::memory_order_acquire))
+		submission->m_Batch.Submit();
+
+	assert(submission->m_Submitted.load(std::memory_order_acquire));
+	submission->m_Device.waitForFences(submission->m_Fence.get(), true, UINT64_MAX);
+}
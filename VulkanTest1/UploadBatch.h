@@ -0,0 +1,104 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class Buffer;
+class LogicalDevice;
+class UploadToken;
+
+// Collects copies out of staging buffers from any number of threads, and
+// records all of them into a single command buffer when Submit() is called.
+// The device only gets one submission and one fence no matter how many
+// textures and buffers went into it, and nobody waits for it unless they ask
+// to through the UploadToken they were given.
+//
+// Everything goes to the graphics queue, so command buffers submitted after
+// Submit() see the uploads finished without waiting on anything.
+class UploadBatch
+{
+public:
+	UploadBatch(LogicalDevice& device);
+	~UploadBatch();
+
+	// Copies each region of staging into image, which is in its initial layout
+	// and ends up eShaderReadOnlyOptimal. The batch keeps staging alive until
+	// the device is done with it. image has to outlive the upload.
+	UploadToken UploadImage(std::unique_ptr<Buffer>&& staging, vk::Image image, const vk::ImageSubresourceRange& range,
+		std::vector<vk::BufferImageCopy>&& regions);
+
+	// Copies all of staging to the start of dst, which has to outlive the upload.
+	UploadToken CopyBuffer(std::unique_ptr<Buffer>&& staging, const Buffer& dst);
+
+	// Records everything added since last time and submits it. The token
+	// covers just that, and is already complete if there was nothing to submit.
+	// Also frees the command buffers and staging buffers of earlier submissions
+	// the device has finished with.
+	UploadToken Submit();
+
+	UploadBatch(const UploadBatch& other) = delete;
+	UploadBatch& operator=(const UploadBatch& other) = delete;
+
+private:
+	friend class UploadToken;
+	struct Submission;
+
+	struct ImageUpload
+	{
+		vk::Buffer m_Staging;
+		vk::Image m_Image;
+		vk::ImageSubresourceRange m_Range;
+		std::vector<vk::BufferImageCopy> m_Regions;
+	};
+	struct BufferCopy
+	{
+		vk::Buffer m_Staging;
+		vk::Buffer m_Dst;
+		vk::BufferCopy m_Region;
+	};
+
+	void Record(const vk::CommandBuffer& cmdBuf) const;
+
+	// Releases whatever submissions the device has finished, or all of them
+	// after waiting if wait is true. Call with m_Mutex held.
+	void Retire(bool wait);
+
+	LogicalDevice& m_Device;
+
+	std::mutex m_Mutex;
+
+	// Everything added since the last Submit(). m_Pending holds their staging
+	// buffers, and is what their tokens point at.
+	std::shared_ptr<Submission> m_Pending;
+	std::vector<ImageUpload> m_ImageUploads;
+	std::vector<BufferCopy> m_BufferCopies;
+
+	// Submitted, and not yet seen to be finished by Retire(). Tokens only hold
+	// weak references, so a submission and its fence are gone once it's retired.
+	std::vector<std::shared_ptr<Submission>> m_InFlight;
+};
+
+// Tells whether some work added to an UploadBatch has finished on the device.
+// Cheap to copy. Doesn't keep anything of the batch's alive, and once the batch
+// (or the device) has been destroyed it's always complete.
+class UploadToken
+{
+public:
+	// Complete from the start
+	UploadToken() = default;
+
+	// Never blocks.
+	bool IsComplete() const;
+
+	// Blocks until the device has finished the upload, submitting the batch
+	// it's in first if nobody has yet.
+	void Wait() const;
+
+private:
+	friend class UploadBatch;
+	UploadToken(const std::shared_ptr<UploadBatch::Submission>& submission) : m_Submission(submission) { }
+
+	// Expired once the batch has retired it, which it only does once the
+	// device is done with it
+	std::weak_ptr<UploadBatch::Submission> m_Submission;
+};
@@ -301,9 +301,9 @@ VKAPI_ATTR VkBool32 VKAPI_CALL VulkanInstance::DebugCallback(VkDebugReportFlagsE
 
 	const std::string* objName = VulkanDebug::GetObjectName(obj);
 	if (objName)
-		Log::Msg("{0} {2}", msgType, *objName, msg);
+		Log::Msg(CSFMT("{0} {2}"), msgType, *objName, msg);
 	else
-		Log::Msg("{0} {1}", msgType, msg);
+		Log::Msg(CSFMT("{0} {1}"), msgType, msg);
 
 	assert(!(flagBits & vk::DebugReportFlagBitsEXT::eError));
 